@@ -0,0 +1,11 @@
+@echo off
+
+echo [1/3] Compiling benchmark against both runtimes...
+clang -O2 test\bench_print.c test\runtime.c -o test\bench_buffered.exe || (echo ERROR: Failed to compile buffered runtime & exit /b 1)
+clang -O2 test\bench_print.c test\runtime_printf.c -o test\bench_printf.exe || (echo ERROR: Failed to compile printf runtime & exit /b 1)
+
+echo [2/3] printf runtime:
+test\bench_printf.exe > NUL
+
+echo [3/3] Buffered runtime:
+test\bench_buffered.exe > NUL
@@ -0,0 +1,13 @@
+# Writes the bytes of INPUT to OUTPUT as a C++ array SYMBOL with its size in SYMBOL_size
+# cmake -DINPUT=<file> -DOUTPUT=<file.cpp> -DSYMBOL=<name> -P EmbedFile.cmake
+
+file(READ "${INPUT}" content HEX)
+string(LENGTH "${content}" length)
+math(EXPR size "${length} / 2")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${content}")
+
+file(WRITE "${OUTPUT}"
+    "#include <cstddef>\n\n"
+    "alignas(4) extern const unsigned char ${SYMBOL}[] = {${bytes}};\n"
+    "extern const size_t ${SYMBOL}_size = ${size};\n"
+)
@@ -0,0 +1,60 @@
+#include "ASTArena.h"
+
+#include <new>
+
+
+namespace {
+    thread_local ASTArena* activeArena = nullptr;
+}  // namespace
+
+void* ASTArena::allocate(std::size_t size) {
+    size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    if (size > static_cast<std::size_t>(m_end - m_next)) {
+        // Oversized nodes get a block of their own, the current block stays in use
+        std::size_t blockSize = size > BlockSize ? size : BlockSize;
+        m_blocks.emplace_back(std::make_unique<char[]>(blockSize), blockSize);
+        char* block = m_blocks.back().first.get();
+        if (blockSize != BlockSize)
+            return block;
+        m_next = block;
+        m_end = block + blockSize;
+    }
+
+    void* ptr = m_next;
+    m_next += size;
+    return ptr;
+}
+
+bool ASTArena::contains(const void* ptr) const {
+    const char* p = static_cast<const char*>(ptr);
+    for (const auto& [block, size] : m_blocks) {
+        if (p >= block.get() && p < block.get() + size)
+            return true;
+    }
+    return false;
+}
+
+ASTArena* ASTArena::current() {
+    return activeArena;
+}
+
+ASTArena::Scope::Scope(ASTArena& arena) : m_previous(activeArena) {
+    activeArena = &arena;
+}
+
+ASTArena::Scope::~Scope() {
+    activeArena = m_previous;
+}
+
+void* ArenaAllocated::operator new(std::size_t size) {
+    if (ASTArena* arena = ASTArena::current())
+        return arena->allocate(size);
+    return ::operator new(size);
+}
+
+void ArenaAllocated::operator delete(void* ptr) noexcept {
+    ASTArena* arena = ASTArena::current();
+    if (arena && arena->contains(ptr))
+        return;
+    ::operator delete(ptr);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+// Bump allocator for AST nodes. While an arena is active on a thread (see Scope) every
+// node created on that thread comes from it, which keeps parallel parsing off the shared
+// heap. Arena memory is released all at once when the arena is destroyed
+class ASTArena {
+  public:
+    ASTArena() = default;
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+
+    void* allocate(std::size_t size);
+    bool contains(const void* ptr) const;
+
+    // The arena active on the calling thread, null when nodes go to the heap
+    static ASTArena* current();
+
+    class Scope {
+      public:
+        explicit Scope(ASTArena& arena);
+        ~Scope();
+
+      private:
+        ASTArena* m_previous;
+    };
+
+  private:
+    static constexpr std::size_t BlockSize = 64 * 1024;
+
+    std::vector<std::pair<std::unique_ptr<char[]>, std::size_t>> m_blocks;
+    char* m_next = nullptr;
+    char* m_end = nullptr;
+};
+
+// Base of the node hierarchies, routes new/delete through the active arena
+struct ArenaAllocated {
+    static void* operator new(std::size_t size);
+    // No-op for arena memory, only reached for it when a constructor throws
+    static void operator delete(void* ptr) noexcept;
+};
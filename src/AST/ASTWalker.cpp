@@ -0,0 +1,133 @@
+#include "ASTWalker.h"
+
+#include "includeNodes.h"
+
+
+void ASTWalker::walk(ProgramNode* program) {
+    for (auto* declaration : program->declarations) {
+        walk(declaration);
+    }
+}
+
+void ASTWalker::walk(DeclarationNode* node) {
+    if (!node)
+        return;
+    visitDeclaration(node);
+
+    if (auto* varDecl = dynamic_cast<VariableDeclNode*>(node)) {
+        walk(varDecl->type);
+        walk(varDecl->arraySize);
+        walk(varDecl->initializer);
+    } else if (auto* paramDecl = dynamic_cast<ParameterDeclNode*>(node)) {
+        walk(paramDecl->type);
+    } else if (auto* funcDecl = dynamic_cast<FunctionDeclNode*>(node)) {
+        walk(funcDecl->returnType);
+        for (auto* param : funcDecl->parameters) {
+            walk(param);
+        }
+        if (funcDecl->body) {
+            walk(funcDecl->body);
+            leaveFunction(funcDecl);
+        }
+    } else if (auto* funcPtrDecl = dynamic_cast<FunctionPtrDeclNode*>(node)) {
+        walk(funcPtrDecl->returnType);
+        for (auto* param : funcPtrDecl->parameters) {
+            walk(param);
+        }
+    } else if (auto* structDecl = dynamic_cast<StructDeclNode*>(node)) {
+        for (auto* field : structDecl->fields) {
+            walk(field);
+        }
+    }
+}
+
+void ASTWalker::walk(StatementNode* node) {
+    if (!node)
+        return;
+    visitStatement(node);
+
+    if (auto* block = dynamic_cast<BlockStatementNode*>(node)) {
+        for (auto* stmt : block->body) {
+            walk(stmt);
+        }
+    } else if (auto* exprStmt = dynamic_cast<ExpressionStatementNode*>(node)) {
+        if (std::holds_alternative<ExpressionNode*>(exprStmt->expression))
+            walk(std::get<ExpressionNode*>(exprStmt->expression));
+        else
+            walk(std::get<DeclarationNode*>(exprStmt->expression));
+    } else if (auto* ifStmt = dynamic_cast<IfStatementNode*>(node)) {
+        walk(ifStmt->condition);
+        walk(ifStmt->thenBody);
+        walk(ifStmt->elseBody);
+    } else if (auto* whileStmt = dynamic_cast<WhileStatementNode*>(node)) {
+        walk(whileStmt->condition);
+        walk(whileStmt->loopBody);
+    } else if (auto* doWhile = dynamic_cast<DoWhileStatementNode*>(node)) {
+        walk(doWhile->loopBody);
+        walk(doWhile->condition);
+    } else if (auto* forStmt = dynamic_cast<ForStatementNode*>(node)) {
+        if (std::holds_alternative<ExpressionNode*>(forStmt->init))
+            walk(std::get<ExpressionNode*>(forStmt->init));
+        else
+            walk(std::get<DeclarationNode*>(forStmt->init));
+        walk(forStmt->condition);
+        walk(forStmt->body);
+        walk(forStmt->update);
+    } else if (auto* retStmt = dynamic_cast<ReturnStatementNode*>(node)) {
+        walk(retStmt->returnValue);
+    } else if (auto* switchStmt = dynamic_cast<SwitchStatementNode*>(node)) {
+        walk(switchStmt->condition);
+        for (auto* caseStmt : switchStmt->cases) {
+            walk(caseStmt);
+        }
+    } else if (auto* caseStmt = dynamic_cast<CaseStatementNode*>(node)) {
+        walk(caseStmt->value);
+        walk(caseStmt->body);
+    }
+}
+
+void ASTWalker::walk(ExpressionNode* node) {
+    if (!node)
+        return;
+    visitExpression(node);
+
+    if (auto* bin = dynamic_cast<BinaryExprNode*>(node)) {
+        walk(bin->left);
+        walk(bin->right);
+    } else if (auto* un = dynamic_cast<UnaryExprNode*>(node)) {
+        walk(un->operand);
+    } else if (auto* cast = dynamic_cast<CastExprNode*>(node)) {
+        walk(cast->type);
+        walk(cast->operand);
+    } else if (auto* call = dynamic_cast<CallExprNode*>(node)) {
+        walk(call->callee);
+        for (auto* arg : call->arguments) {
+            walk(arg);
+        }
+    } else if (auto* member = dynamic_cast<MemberExprNode*>(node)) {
+        walk(member->object);
+    } else if (auto* index = dynamic_cast<IndexExprNode*>(node)) {
+        walk(index->array);
+        walk(index->index);
+    } else if (auto* comma = dynamic_cast<CommaExprNode*>(node)) {
+        for (auto* expr : comma->expressions) {
+            walk(expr);
+        }
+    } else if (auto* list = dynamic_cast<InitializerListExprNode*>(node)) {
+        for (auto* element : list->elements) {
+            walk(element);
+        }
+    }
+}
+
+void ASTWalker::walk(TypeNode* node) {
+    if (!node)
+        return;
+    visitType(node);
+
+    if (auto* ptr = dynamic_cast<PointerTypeNode*>(node)) {
+        walk(ptr->baseType);
+    } else if (auto* array = dynamic_cast<ArrayTypeNode*>(node)) {
+        walk(array->elementType);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "forwardDecl.h"
+
+
+// Pre-order traversal over the whole AST for analyses that run before CodeGen.
+// Override the hooks of interest, every node is reported before its children
+struct ASTWalker {
+    virtual ~ASTWalker() = default;
+
+    virtual void visitDeclaration(DeclarationNode* node) {}
+    virtual void visitStatement(StatementNode* node) {}
+    virtual void visitExpression(ExpressionNode* node) {}
+    virtual void visitType(TypeNode* node) {}
+
+    // Called after the body of a function definition was walked
+    virtual void leaveFunction(FunctionDeclNode* node) {}
+
+    void walk(ProgramNode* program);
+    void walk(DeclarationNode* node);
+    void walk(StatementNode* node);
+    void walk(ExpressionNode* node);
+    void walk(TypeNode* node);
+};
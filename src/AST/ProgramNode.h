@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory>
 #include <vector>
+#include "ASTArena.h"
 #include "declaration/DeclarationNode.h"
 
 
@@ -8,6 +10,7 @@ class CodeGen;
 
 struct ProgramNode {
     std::vector<DeclarationNode*> declarations;
+    std::vector<std::unique_ptr<ASTArena>> arenas;  // Own the nodes of a parallel parse
 
     ProgramNode(std::vector<DeclarationNode*> declarations) : declarations(declarations) {}
 };
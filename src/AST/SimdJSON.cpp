@@ -0,0 +1,463 @@
+#include "SimdJSON.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace {
+    using json = nlohmann::json;
+
+    unsigned trailingZeros(uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return index;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    // Bit i of each mask describes byte i of a 64 byte block
+    struct BlockMasks {
+        uint64_t quote = 0;
+        uint64_t backslash = 0;
+        uint64_t op = 0;  // { } [ ] : ,
+        uint64_t whitespace = 0;
+    };
+
+#if JSON_AVX2
+    uint64_t matchAny(__m256i lo, __m256i hi, std::initializer_list<char> chars) {
+        __m256i anyLo = _mm256_setzero_si256();
+        __m256i anyHi = _mm256_setzero_si256();
+        for (char c : chars) {
+            __m256i match = _mm256_set1_epi8(c);
+            anyLo = _mm256_or_si256(anyLo, _mm256_cmpeq_epi8(lo, match));
+            anyHi = _mm256_or_si256(anyHi, _mm256_cmpeq_epi8(hi, match));
+        }
+        return uint64_t(uint32_t(_mm256_movemask_epi8(anyLo))) |
+               uint64_t(uint32_t(_mm256_movemask_epi8(anyHi))) << 32;
+    }
+
+    BlockMasks classifyBlock(const char* block) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+        BlockMasks masks;
+        masks.quote = matchAny(lo, hi, {'"'});
+        masks.backslash = matchAny(lo, hi, {'\\'});
+        masks.op = matchAny(lo, hi, {'{', '}', '[', ']', ':', ','});
+        masks.whitespace = matchAny(lo, hi, {' ', '\t', '\n', '\r'});
+        return masks;
+    }
+#elif JSON_SSE2
+    uint64_t matchAny(__m128i data, std::initializer_list<char> chars) {
+        __m128i any = _mm_setzero_si128();
+        for (char c : chars)
+            any = _mm_or_si128(any, _mm_cmpeq_epi8(data, _mm_set1_epi8(c)));
+        return uint16_t(_mm_movemask_epi8(any));
+    }
+
+    BlockMasks classifyBlock(const char* block) {
+        BlockMasks masks;
+        for (int i = 0; i < 4; i++) {
+            __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+            masks.quote |= matchAny(data, {'"'}) << (16 * i);
+            masks.backslash |= matchAny(data, {'\\'}) << (16 * i);
+            masks.op |= matchAny(data, {'{', '}', '[', ']', ':', ','}) << (16 * i);
+            masks.whitespace |= matchAny(data, {' ', '\t', '\n', '\r'}) << (16 * i);
+        }
+        return masks;
+    }
+#else
+    enum CharClass : uint8_t { Other, Quote, Backslash, Op, Whitespace };
+
+    struct CharClassTable {
+        CharClass classes[256] = {};
+        CharClassTable() {
+            classes[uint8_t('"')] = Quote;
+            classes[uint8_t('\\')] = Backslash;
+            for (char c : {'{', '}', '[', ']', ':', ','})
+                classes[uint8_t(c)] = Op;
+            for (char c : {' ', '\t', '\n', '\r'})
+                classes[uint8_t(c)] = Whitespace;
+        }
+    };
+
+    BlockMasks classifyBlock(const char* block) {
+        static const CharClassTable table;
+        BlockMasks masks;
+        for (int i = 0; i < 64; i++) {
+            uint64_t bit = uint64_t(1) << i;
+            switch (table.classes[uint8_t(block[i])]) {
+                case Quote: masks.quote |= bit; break;
+                case Backslash: masks.backslash |= bit; break;
+                case Op: masks.op |= bit; break;
+                case Whitespace: masks.whitespace |= bit; break;
+                case Other: break;
+            }
+        }
+        return masks;
+    }
+#endif
+
+    // Bit i is set when an odd number of bits at or below i are set
+    uint64_t prefixXor(uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    // Characters following an unescaped backslash, carry is set when the block ends in one.
+    // AST files rarely have escapes, so a loop over the backslashes is fine
+    uint64_t findEscaped(uint64_t backslash, bool& carry) {
+        if (!backslash && !carry)
+            return 0;
+
+        uint64_t escaped = carry ? 1 : 0;
+        carry = false;
+        uint64_t unescaped = backslash & ~escaped;
+        while (unescaped) {
+            unsigned i = trailingZeros(unescaped);
+            if (i == 63) {
+                carry = true;
+                break;
+            }
+            uint64_t next = uint64_t(1) << (i + 1);
+            escaped |= next;
+            unescaped &= ~next;
+            unescaped &= unescaped - 1;
+        }
+        return escaped;
+    }
+
+    // Positions of { } [ ] : , outside strings, of opening quotes and of the first
+    // character of every number and literal
+    std::vector<uint32_t> findStructurals(std::string_view input) {
+        if (input.size() > UINT32_MAX)
+            throw std::runtime_error("Parse error: JSON files over 4GB are not supported");
+
+        std::vector<uint32_t> indices;
+        indices.reserve(input.size() / 8);
+
+        uint64_t prevInString = 0;  // All ones when the previous block ended inside a string
+        uint64_t prevScalar = 0;    // 1 when the previous block ended inside a number/literal
+        bool prevEscaped = false;
+        char padded[64];
+        for (size_t offset = 0; offset < input.size(); offset += 64) {
+            const char* block = input.data() + offset;
+            if (input.size() - offset < 64) {
+                std::memset(padded, ' ', sizeof(padded));
+                std::memcpy(padded, block, input.size() - offset);
+                block = padded;
+            }
+
+            BlockMasks masks = classifyBlock(block);
+            uint64_t quote = masks.quote & ~findEscaped(masks.backslash, prevEscaped);
+
+            // Includes the opening quote but not the closing one
+            uint64_t inString = prefixXor(quote) ^ prevInString;
+            prevInString = uint64_t(int64_t(inString) >> 63);
+
+            uint64_t scalar = ~(masks.op | masks.whitespace | quote | inString);
+            uint64_t scalarStart = scalar & ~((scalar << 1) | prevScalar);
+            prevScalar = scalar >> 63;
+
+            uint64_t structurals = (masks.op & ~inString) | (quote & inString) | scalarStart;
+            while (structurals) {
+                indices.push_back(uint32_t(offset + trailingZeros(structurals)));
+                structurals &= structurals - 1;
+            }
+        }
+
+        if (prevInString)
+            throw std::runtime_error("Parse error: unterminated string");
+        return indices;
+    }
+
+    void appendUtf8(std::string& out, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out += char(codePoint);
+        } else if (codePoint < 0x800) {
+            out += char(0xC0 | (codePoint >> 6));
+            out += char(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += char(0xE0 | (codePoint >> 12));
+            out += char(0x80 | ((codePoint >> 6) & 0x3F));
+            out += char(0x80 | (codePoint & 0x3F));
+        } else {
+            out += char(0xF0 | (codePoint >> 18));
+            out += char(0x80 | ((codePoint >> 12) & 0x3F));
+            out += char(0x80 | ((codePoint >> 6) & 0x3F));
+            out += char(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    // Stage 2, only ever looks at the structural positions and the values they start
+    class DocumentBuilder {
+      public:
+        DocumentBuilder(std::string_view input, const std::vector<uint32_t>& indices)
+            : m_input(input), m_indices(indices) {}
+
+        json build() {
+            json document = parseValue();
+            if (m_next != m_indices.size())
+                error("unexpected content after the document", m_indices[m_next]);
+            return document;
+        }
+
+      private:
+        std::string_view m_input;
+        const std::vector<uint32_t>& m_indices;
+        size_t m_next = 0;
+
+        [[noreturn]] void error(const std::string& what, size_t position) const {
+            throw std::runtime_error(
+                "Parse error: " + what + " at byte " + std::to_string(position)
+            );
+        }
+
+        size_t advance() {
+            if (m_next == m_indices.size())
+                error("unexpected end of input", m_input.size());
+            return m_indices[m_next++];
+        }
+
+        bool isDelimiter(size_t position) const {
+            if (position == m_input.size())
+                return true;
+            switch (m_input[position]) {
+                case ' ': case '\t': case '\n': case '\r':
+                case ',': case '}': case ']': case ':':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        json parseValue() {
+            size_t position = advance();
+            switch (m_input[position]) {
+                case '{': return parseObject();
+                case '[': return parseArray();
+                case '"': return parseString(position);
+                case 't': return parseLiteral(position, "true", true);
+                case 'f': return parseLiteral(position, "false", false);
+                case 'n': return parseLiteral(position, "null", nullptr);
+                default: return parseNumber(position);
+            }
+        }
+
+        json parseObject() {
+            json object = json::object();
+            json::object_t& members = object.get_ref<json::object_t&>();
+            if (m_next < m_indices.size() && m_input[m_indices[m_next]] == '}') {
+                m_next++;
+                return object;
+            }
+
+            while (true) {
+                size_t position = advance();
+                if (m_input[position] != '"')
+                    error("expected an object key", position);
+                std::string key = parseString(position);
+
+                position = advance();
+                if (m_input[position] != ':')
+                    error("expected ':'", position);
+                // Later duplicates win, as with json::parse
+                members[std::move(key)] = parseValue();
+
+                position = advance();
+                if (m_input[position] == '}')
+                    return object;
+                if (m_input[position] != ',')
+                    error("expected ',' or '}'", position);
+            }
+        }
+
+        json parseArray() {
+            json array = json::array();
+            json::array_t& elements = array.get_ref<json::array_t&>();
+            if (m_next < m_indices.size() && m_input[m_indices[m_next]] == ']') {
+                m_next++;
+                return array;
+            }
+
+            while (true) {
+                elements.push_back(parseValue());
+
+                size_t position = advance();
+                if (m_input[position] == ']')
+                    return array;
+                if (m_input[position] != ',')
+                    error("expected ',' or ']'", position);
+            }
+        }
+
+        // position is the opening quote, stage 1 already made sure the string is closed
+        std::string parseString(size_t position) {
+            const char* p = m_input.data() + position + 1;
+            const char* end = m_input.data() + m_input.size();
+
+            std::string result;
+            const char* run = p;
+            while (p < end && *p != '"') {
+                if (*p != '\\') {
+                    if (static_cast<unsigned char>(*p) < 0x20)
+                        error("control character in string", p - m_input.data());
+                    p++;
+                    continue;
+                }
+                result.append(run, p);
+                p = unescape(p, end, result);
+                run = p;
+            }
+            result.append(run, p);
+            return result;
+        }
+
+        // p is the backslash, returns the position after the escape sequence
+        const char* unescape(const char* p, const char* end, std::string& out) {
+            if (end - p < 2)
+                error("invalid escape", p - m_input.data());
+            switch (p[1]) {
+                case '"': out += '"'; return p + 2;
+                case '\\': out += '\\'; return p + 2;
+                case '/': out += '/'; return p + 2;
+                case 'b': out += '\b'; return p + 2;
+                case 'f': out += '\f'; return p + 2;
+                case 'n': out += '\n'; return p + 2;
+                case 'r': out += '\r'; return p + 2;
+                case 't': out += '\t'; return p + 2;
+                case 'u': break;
+                default: error("invalid escape", p - m_input.data());
+            }
+
+            uint32_t codePoint = parseHex4(p + 2, end);
+            p += 6;
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                // High surrogate, the low half must follow as another \u escape
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u')
+                    error("unpaired surrogate", p - m_input.data());
+                uint32_t low = parseHex4(p + 2, end);
+                if (low < 0xDC00 || low > 0xDFFF)
+                    error("unpaired surrogate", p - m_input.data());
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                error("unpaired surrogate", p - m_input.data());
+            }
+            appendUtf8(out, codePoint);
+            return p;
+        }
+
+        uint32_t parseHex4(const char* p, const char* end) {
+            uint32_t value = 0;
+            if (end - p < 4 || std::from_chars(p, p + 4, value, 16).ptr != p + 4)
+                error("invalid \\u escape", p - m_input.data());
+            return value;
+        }
+
+        json parseLiteral(size_t position, std::string_view text, json value) {
+            if (m_input.compare(position, text.size(), text) != 0 ||
+                !isDelimiter(position + text.size())) {
+                error("invalid literal", position);
+            }
+            return value;
+        }
+
+        json parseNumber(size_t position) {
+            const char* begin = m_input.data() + position;
+            const char* end = m_input.data() + m_input.size();
+
+            // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?, json::parse rejects 01, 1. and 1e
+            const char* p = begin;
+            auto digits = [&]() {
+                const char* first = p;
+                while (p < end && *p >= '0' && *p <= '9')
+                    p++;
+                return p != first;
+            };
+            if (p < end && *p == '-')
+                p++;
+            if (p == end || !(*p >= '0' && *p <= '9'))
+                error("invalid value", position);
+            // No digits may follow a leading 0
+            if (*p == '0')
+                p++;
+            else
+                digits();
+            bool valid = true;
+            bool isFloat = false;
+            if (valid && p < end && *p == '.') {
+                p++;
+                isFloat = true;
+                valid = digits();
+            }
+            if (valid && p < end && (*p == 'e' || *p == 'E')) {
+                p++;
+                isFloat = true;
+                if (p < end && (*p == '+' || *p == '-'))
+                    p++;
+                valid = digits();
+            }
+            if (!valid || !isDelimiter(p - m_input.data()))
+                error("invalid number", position);
+
+            // Same number types as json::parse: unsigned, signed when negative, double
+            std::from_chars_result result;
+            json value;
+            if (isFloat) {
+                double number = 0;
+                result = std::from_chars(begin, p, number);
+                value = number;
+            } else if (*begin == '-') {
+                int64_t number = 0;
+                result = std::from_chars(begin, p, number);
+                value = number;
+            } else {
+                uint64_t number = 0;
+                result = std::from_chars(begin, p, number);
+                value = number;
+            }
+            if (result.ec != std::errc() || result.ptr != p)
+                error("invalid number", position);
+            return value;
+        }
+    };
+}  // namespace
+
+nlohmann::json parseJSONSimd(std::string_view input) {
+    std::vector<uint32_t> indices = findStructurals(input);
+    return DocumentBuilder(input, indices).build();
+}
+
+const char* simdJSONBackend() {
+#if JSON_AVX2
+    return "avx2";
+#elif JSON_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
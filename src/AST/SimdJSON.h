@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+
+// Two stage parser in the style of simdjson. Stage 1 finds every structural character
+// 64 bytes at a time with AVX2 or SSE2 (scalar on other targets), stage 2 builds the same
+// nlohmann::json that json::parse would from those positions without looking at the rest
+nlohmann::json parseJSONSimd(std::string_view input);
+
+// "avx2", "sse2" or "scalar", whichever stage 1 was compiled for
+const char* simdJSONBackend();
@@ -0,0 +1,10 @@
+#pragma once
+
+
+// Position of a node in the original source, taken from the JSON "location" object
+struct SourceLocation {
+    unsigned line = 0;
+    unsigned column = 0;
+
+    bool isValid() const { return line != 0; }
+};
@@ -2,9 +2,13 @@
 
 #include "../NodeVisitor.h"
 #include "../CodeGen.h"
+#include "../ASTArena.h"
+#include "../SourceLocation.h"
 
 
-struct DeclarationNode {
+struct DeclarationNode : ArenaAllocated {
+    SourceLocation location;
+
     virtual ~DeclarationNode() = default;
 
     virtual void accept(CodeGen& codeGen) = 0;
@@ -11,17 +11,23 @@ struct VariableDeclNode : public DeclarationNode {
     TypeNode* type;
     ExpressionNode* arraySize;
     ExpressionNode* initializer;
+    bool isConst;
+    bool isExtern;  // Top level only, defined in another module
 
     VariableDeclNode(
         std::string identifier,
         TypeNode* type,
         ExpressionNode* arraySize,
-        ExpressionNode* initializer
+        ExpressionNode* initializer,
+        bool isConst = false,
+        bool isExtern = false
     )
         : identifier(identifier),
           type(type),
           arraySize(arraySize),
-          initializer(initializer) {}
+          initializer(initializer),
+          isConst(isConst),
+          isExtern(isExtern) {}
 
     void accept(CodeGen& codeGen) override { codeGen.visitVariableDeclaration(this); }
 };
\ No newline at end of file
@@ -4,9 +4,12 @@
 #include "ExpressionNode.h"
 
 
+struct Builtin;
+
 struct CallExprNode : public ExpressionNode {
     IdentifierExprNode* callee;
     std::vector<ExpressionNode*> arguments;
+    const Builtin* builtin = nullptr;  // Compiler-provided function, set by Sema
 
     CallExprNode(IdentifierExprNode* callee, std::vector<ExpressionNode*> arguments)
         : callee(callee),
@@ -2,8 +2,17 @@
 
 #include <llvm/IR/Value.h>
 #include "../../CodeGen.h"
+#include "../ASTArena.h"
+#include "../SourceLocation.h"
+
+struct ExpressionNode : ArenaAllocated {
+    SourceLocation location;
+
+    // Filled in by analyzeSemantics before CodeGen runs. resolvedType is null for function
+    // names, the only expressions without a value of their own
+    TypeNode* resolvedType = nullptr;
+    bool isLValue = false;
 
-struct ExpressionNode {
     virtual ~ExpressionNode() = default;
     virtual llvm::Value* accept(CodeGen& codeGen) = 0;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 struct IdentifierExprNode : public ExpressionNode {
     std::string name;
+    DeclarationNode* declaration = nullptr;  // Variable, parameter or function, set by Sema
 
     IdentifierExprNode(std::string name) : name(name) {}
 
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include "ExpressionNode.h"
+
+
+// Brace initializer of an array or struct variable, elements may be nested lists
+struct InitializerListExprNode : public ExpressionNode {
+    std::vector<ExpressionNode*> elements;
+
+    InitializerListExprNode(std::vector<ExpressionNode*> elements) : elements(elements) {}
+
+    llvm::Value* accept(CodeGen& codeGen) override { return codeGen.visitInitializerList(this); }
+};
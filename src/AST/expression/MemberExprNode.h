@@ -9,6 +9,11 @@ struct MemberExprNode : public ExpressionNode {
     std::string member;
     bool arrowAccess;
 
+    // Set by analyzeSemantics, the definition of the accessed struct and the position of
+    // member among its fields in declaration order
+    StructDeclNode* structDecl = nullptr;
+    unsigned fieldIndex = 0;
+
     MemberExprNode(ExpressionNode* object, std::string member, bool arrowAccess)
         : object(object),
           member(member),
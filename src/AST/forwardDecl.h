@@ -17,9 +17,13 @@ struct IfStatementNode;
 struct WhileStatementNode;
 struct DoWhileStatementNode;
 struct ForStatementNode;
+struct ParallelForStatementNode;
 struct ReturnStatementNode;
 struct CaseStatementNode;
 struct SwitchStatementNode;
+struct BreakStatementNode;
+struct ContinueStatementNode;
+struct LoopAttributes;
 
 struct ExpressionNode;
 struct BinaryExprNode;
@@ -35,8 +39,10 @@ struct CastExprNode;
 struct MemberExprNode;
 struct IndexExprNode;
 struct CommaExprNode;
+struct InitializerListExprNode;
 
 struct TypeNode;
 struct PrimitiveTypeNode;
 struct PointerTypeNode;
-struct NamedTypeNode;
\ No newline at end of file
+struct NamedTypeNode;
+struct ArrayTypeNode;
\ No newline at end of file
@@ -2,11 +2,15 @@
 
 #undef NDEBUG
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
 
+#include "../Parallel.h"
 #include "ProgramNode.h"
+#include "SimdJSON.h"
 #include "includeNodes.h"
 
 namespace {
@@ -17,23 +21,49 @@ namespace {
     }
 
     template <typename NodeT>
-    NodeT* parseNode(const nlohmann::json& json) {
+    NodeT* parseNodeBody(const nlohmann::json& json) {
         static_assert(false, "parseNode is not implemented for this node type");
         return nullptr;
     }
 
     // Forward declarations of template specializations
     template <>
-    TypeNode* parseNode<TypeNode>(const nlohmann::json& json);
+    TypeNode* parseNodeBody<TypeNode>(const nlohmann::json& json);
 
     template <>
-    ExpressionNode* parseNode<ExpressionNode>(const nlohmann::json& json);
+    ExpressionNode* parseNodeBody<ExpressionNode>(const nlohmann::json& json);
 
     template <>
-    StatementNode* parseNode<StatementNode>(const nlohmann::json& json);
+    StatementNode* parseNodeBody<StatementNode>(const nlohmann::json& json);
 
     template <>
-    DeclarationNode* parseNode<DeclarationNode>(const nlohmann::json& json);
+    DeclarationNode* parseNodeBody<DeclarationNode>(const nlohmann::json& json);
+
+    SourceLocation parseLocation(const nlohmann::json& json) {
+        SourceLocation location;
+        if (json.contains("location")) {
+            location.line = json["location"].value("line", 0u);
+            location.column = json["location"].value("column", 0u);
+        }
+        return location;
+    }
+
+    // Parses the node and attaches its source location
+    template <typename NodeT>
+    NodeT* parseNode(const nlohmann::json& json) {
+        NodeT* node = parseNodeBody<NodeT>(json);
+        node->location = parseLocation(json);
+        return node;
+    }
+
+    LoopAttributes parseLoopAttributes(const nlohmann::json& json) {
+        LoopAttributes attributes;
+        attributes.unrollCount = json.value("unrollCount", 0);
+        attributes.vectorizeWidth = json.value("vectorizeWidth", 0);
+        attributes.interleaveCount = json.value("interleaveCount", 0);
+        attributes.distribute = json.value("distribute", false);
+        return attributes;
+    }
 
     template <typename ParseT, typename NodeT>
     std::vector<NodeT*> parseNodes(const nlohmann::json& json) {
@@ -45,7 +75,7 @@ namespace {
     }
 
     template <>
-    TypeNode* parseNode<TypeNode>(const nlohmann::json& json) {
+    TypeNode* parseNodeBody<TypeNode>(const nlohmann::json& json) {
         std::string nodeType = json["nodeType"].get<std::string>();
 
         if (nodeType == "PrimitiveType") {
@@ -59,7 +89,7 @@ namespace {
     }
 
     template <>
-    ExpressionNode* parseNode<ExpressionNode>(const nlohmann::json& json) {
+    ExpressionNode* parseNodeBody<ExpressionNode>(const nlohmann::json& json) {
         std::string nodeType = json["nodeType"].get<std::string>();
 
         if (nodeType == "Literal") {
@@ -100,7 +130,7 @@ namespace {
                 static_cast<IdentifierExprNode*>(parseNode<ExpressionNode>(json["callee"])),
                 parseNodes<ExpressionNode, ExpressionNode>(json["arguments"])
             );
-        } else if (nodeType == "MemberAccessExpression") {
+        } else if (nodeType == "MemberExpression" || nodeType == "MemberAccessExpression") {
             bool isArrow = json["kind"].get<std::string>() == "arrow";
             return new MemberExprNode(
                 parseNode<ExpressionNode>(json["object"]),
@@ -115,17 +145,24 @@ namespace {
             return new CommaExprNode(
                 parseNodes<ExpressionNode, ExpressionNode>(json["expressions"])
             );
+        } else if (nodeType == "InitializerList") {
+            return new InitializerListExprNode(
+                parseNodes<ExpressionNode, ExpressionNode>(json["elements"])
+            );
         }
 
         unknownNode(nodeType);
     }
 
     template <>
-    StatementNode* parseNode<StatementNode>(const nlohmann::json& json) {
+    StatementNode* parseNodeBody<StatementNode>(const nlohmann::json& json) {
         std::string nodeType = json["nodeType"].get<std::string>();
 
         if (nodeType == "ReturnStatement") {
-            return new ReturnStatementNode(parseNode<ExpressionNode>(json["expression"]));
+            nlohmann::json expression = json.contains("expression") ? json["expression"] : nullptr;
+            return new ReturnStatementNode(
+                expression.is_null() ? nullptr : parseNode<ExpressionNode>(expression)
+            );
         } else if (nodeType == "BlockStatement") {
             return new BlockStatementNode(
                 parseNodes<StatementNode, StatementNode>(json["statements"])
@@ -139,32 +176,48 @@ namespace {
                                      : parseNode<StatementNode>(elseBranch)
             );
         } else if (nodeType == "WhileStatement") {
-            return new WhileStatementNode(
+            auto* whileNode = new WhileStatementNode(
                 parseNode<ExpressionNode>(json["condition"]),
                 parseNode<StatementNode>(json["loopBody"])
             );
+            whileNode->attributes = parseLoopAttributes(json);
+            return whileNode;
         } else if (nodeType == "ForStatement") {
-            nlohmann::json init = json.contains("init") ? json["init"] : nullptr;
+            nlohmann::json init = json.contains("init")             ? json["init"]
+                                  : json.contains("initialization") ? json["initialization"]
+                                                                    : nullptr;
             ForStatementNode::InitT initT{};
             if (init.is_null()) {
                 //initT = nullptr;  // TODO?
             } else {
                 std::string initNodeType = init["nodeType"].get<std::string>();
-                if (initNodeType.find("Expression") != std::string::npos) {
-                    initT = parseNode<ExpressionNode>(init);
-                } else {
+                if (initNodeType.find("Declaration") != std::string::npos) {
                     initT = parseNode<DeclarationNode>(init);
+                } else {
+                    initT = parseNode<ExpressionNode>(init);
                 }
             }
 
             nlohmann::json update = json.contains("update") ? json["update"] : nullptr;
             nlohmann::json condition = json.contains("condition") ? json["condition"] : nullptr;
-            return new ForStatementNode(
-                initT,
-                update.is_null() ? nullptr : parseNode<ExpressionNode>(update),
-                condition.is_null() ? nullptr : parseNode<ExpressionNode>(condition),
-                parseNode<StatementNode>(json["body"])
-            );
+            ForStatementNode* forNode = nullptr;
+            ExpressionNode* conditionNode =
+                condition.is_null() ? nullptr : parseNode<ExpressionNode>(condition);
+            ExpressionNode* updateNode =
+                update.is_null() ? nullptr : parseNode<ExpressionNode>(update);
+            StatementNode* body = parseNode<StatementNode>(json["body"]);
+            if (json.value("parallel", false)) {
+                auto* parallelNode =
+                    new ParallelForStatementNode(initT, conditionNode, updateNode, body);
+                parallelNode->schedule =
+                    ParallelForStatementNode::scheduleFromString(json.value("schedule", "static"));
+                parallelNode->chunk = json.value("chunk", 0);
+                forNode = parallelNode;
+            } else {
+                forNode = new ForStatementNode(initT, conditionNode, updateNode, body);
+            }
+            forNode->attributes = parseLoopAttributes(json);
+            return forNode;
         } else if (nodeType == "ExpressionStatement") {
             std::string exprNodeType = json["expression"]["nodeType"];
             if (exprNodeType.find("Expression") != std::string::npos) {
@@ -174,16 +227,37 @@ namespace {
             }
             assert(false);
         } else if (nodeType == "DoWhileStatement") {
-            return new DoWhileStatementNode(
+            auto* doWhileNode = new DoWhileStatementNode(
                 parseNode<ExpressionNode>(json["condition"]),
                 parseNode<StatementNode>(json["loopBody"])
             );
+            doWhileNode->attributes = parseLoopAttributes(json);
+            return doWhileNode;
+        } else if (nodeType == "SwitchStatement") {
+            // Case bodies are plain statement lists, default stays where it is among them
+            std::vector<CaseStatementNode*> cases;
+            for (const auto& caseJson : json["cases"]) {
+                auto* body = new BlockStatementNode(
+                    parseNodes<StatementNode, StatementNode>(caseJson["body"])
+                );
+                IntegerLiteralNode* value = nullptr;
+                if (!caseJson.value("isDefault", false))
+                    value = new IntegerLiteralNode(caseJson["value"].get<int>());
+                auto* caseNode = new CaseStatementNode(value, body);
+                caseNode->location = parseLocation(caseJson);
+                cases.push_back(caseNode);
+            }
+            return new SwitchStatementNode(parseNode<ExpressionNode>(json["expression"]), cases);
+        } else if (nodeType == "BreakStatement") {
+            return new BreakStatementNode();
+        } else if (nodeType == "ContinueStatement") {
+            return new ContinueStatementNode();
         }
         unknownNode(nodeType);
     }
 
     template <>
-    DeclarationNode* parseNode<DeclarationNode>(const nlohmann::json& json) {
+    DeclarationNode* parseNodeBody<DeclarationNode>(const nlohmann::json& json) {
         std::string nodeType = json["nodeType"].get<std::string>();
         if (nodeType == "VariableDeclaration") {
             nlohmann::json arraySize = json.contains("arraySize") ? json["arraySize"] : nullptr;
@@ -195,7 +269,9 @@ namespace {
                 json["identifier"].get<std::string>(),
                 parseNode<TypeNode>(json["type"]),
                 arraySize.is_null() ? nullptr : parseNode<ExpressionNode>(arraySize),
-                initializer.is_null() ? nullptr : parseNode<ExpressionNode>(initializer)
+                initializer.is_null() ? nullptr : parseNode<ExpressionNode>(initializer),
+                json.value("const", false),
+                json.value("extern", false)
             );
         } else if (nodeType == "Parameter") {
             return new ParameterDeclNode(
@@ -216,10 +292,19 @@ namespace {
                 static_cast<BlockStatementNode*>(parseNode<StatementNode>(json["body"]))
             );
         } else if (nodeType == "FunctionPointerDeclaration") {
+            // The frontend only gives the parameter types, parameters stay unnamed then
+            std::vector<ParameterDeclNode*> parameters;
+            if (json.contains("parameterTypes")) {
+                for (const auto& type : json["parameterTypes"]) {
+                    parameters.push_back(new ParameterDeclNode("", parseNode<TypeNode>(type)));
+                }
+            } else {
+                parameters = parseNodes<DeclarationNode, ParameterDeclNode>(json["parameters"]);
+            }
             return new FunctionPtrDeclNode(
                 json["identifier"].get<std::string>(),
                 parseNode<TypeNode>(json["returnType"]),
-                parseNodes<DeclarationNode, ParameterDeclNode>(json["parameters"])
+                parameters
             );
         } else if (nodeType == "StructDeclaration") {
             return new StructDeclNode(json["identifier"].get<std::string>(), {});
@@ -234,29 +319,104 @@ namespace {
     }
 }  // namespace
 
-ProgramNode* fromJSON(const nlohmann::json& json) {
-    ProgramNode* program =
-        new ProgramNode(parseNodes<DeclarationNode, DeclarationNode>(json["declarations"]));
+ProgramNode* fromJSON(const nlohmann::json& json, unsigned threads) {
+    const nlohmann::json& declarations = json["declarations"];
+    if (threads <= 1 || declarations.size() <= 1) {
+        return new ProgramNode(parseNodes<DeclarationNode, DeclarationNode>(declarations));
+    }
+
+    // Top-level declarations are independent subtrees, each lands at its own index so the
+    // original order is kept no matter which worker built it
+    std::vector<DeclarationNode*> nodes(declarations.size());
+    std::vector<std::unique_ptr<ASTArena>> arenas;
+    for (unsigned i = 0; i < threads; i++)
+        arenas.push_back(std::make_unique<ASTArena>());
 
+    parallelFor(declarations.size(), threads, [&](unsigned worker, size_t i) {
+        ASTArena::Scope scope(*arenas[worker]);
+        nodes[i] = parseNode<DeclarationNode>(declarations[i]);
+    });
+
+    ProgramNode* program = new ProgramNode(std::move(nodes));
+    program->arenas = std::move(arenas);
     return program;
 }
 
 
-nlohmann::json loadASTFromFile(const std::string& jsonFile) {
-    std::ifstream R(jsonFile);
-    if (!R.is_open()) {
-        throw std::runtime_error("AST Json could not be opened\n");
+namespace {
+    std::string readFile(const std::string& jsonFile) {
+        std::ifstream R(jsonFile, std::ios::binary);
+        if (!R.is_open()) {
+            throw std::runtime_error("AST Json could not be opened\n");
+        }
+        std::ostringstream contents;
+        contents << R.rdbuf();
+        return contents.str();
+    }
+
+    nlohmann::json parseJSON(const std::string& text, JSONParser parser) {
+        if (parser == JSONParser::Simd)
+            return parseJSONSimd(text);
+        try {
+            return nlohmann::json::parse(text);
+        } catch (nlohmann::json::parse_error& e) {
+            throw std::runtime_error("Parse error: Not a JSON file\n");
+        }
     }
+}  // namespace
+
+nlohmann::json loadASTFromFile(const std::string& jsonFile, JSONParser parser) {
+    nlohmann::json data = parseJSON(readFile(jsonFile), parser);
+    std::cout << "Parsed JSON successfully!\n";
+    std::cout << "Pretty print:\n" << data.dump(2) << std::endl;
+
+    return data;
+}
 
-    // Example: Parse the input file as JSON
-    try {
-        nlohmann::json data = nlohmann::json::parse(R);
-        std::cout << "Parsed JSON successfully!\n";
-        std::cout << "Pretty print:\n" << data.dump(2) << std::endl;
+void benchmarkJSONParsers(const std::string& jsonFile, std::ostream& out) {
+    std::string text = readFile(jsonFile);
+    out << jsonFile << ": " << text.size() / 1e6 << " MB\n";
+
+    nlohmann::json results[2];
+    const std::pair<JSONParser, const char*> parsers[] = {
+        {JSONParser::Nlohmann, "nlohmann"},
+        {JSONParser::Simd, simdJSONBackend()},
+    };
+    for (int i = 0; i < 2; i++) {
+        // Best of three, the first run also pays for faulting in the allocator
+        double best = 0;
+        for (int run = 0; run < 3; run++) {
+            auto start = std::chrono::steady_clock::now();
+            results[i] = parseJSON(text, parsers[i].first);
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            if (run == 0 || seconds.count() < best)
+                best = seconds.count();
+        }
+        out << "  " << parsers[i].second << ": " << text.size() / best / 1e9 << " GB/s\n";
+    }
+    if (results[0] != results[1])
+        out << "  results differ!\n";
+}
 
-        return data;
-    } catch (nlohmann::json::parse_error& e) {
-        throw std::runtime_error("Parse error: Not a JSON file\n");
+void benchmarkASTConstruction(const std::string& jsonFile, unsigned maxThreads, std::ostream& out) {
+    nlohmann::json json = parseJSON(readFile(jsonFile), JSONParser::Simd);
+    out << jsonFile << ": " << json["declarations"].size() << " top-level declarations\n";
+
+    double serial = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        // The nodes are leaked on purpose, freeing them is not what is being measured
+        double best = 0;
+        for (int run = 0; run < 3; run++) {
+            auto start = std::chrono::steady_clock::now();
+            fromJSON(json, threads);
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            if (run == 0 || seconds.count() < best)
+                best = seconds.count();
+        }
+        if (threads == 1)
+            serial = best;
+        out << "  " << threads << " threads: " << best * 1000 << " ms, speedup "
+            << serial / best << "x\n";
     }
 }
 
@@ -279,12 +439,7 @@ namespace {
         }
 
         if (auto* prim = dynamic_cast<const PrimitiveTypeNode*>(type)) {
-            switch (prim->kind) {
-                case PrimitiveTypeNode::Void: std::cout << "void"; break;
-                case PrimitiveTypeNode::Char: std::cout << "char"; break;
-                case PrimitiveTypeNode::Int: std::cout << "int"; break;
-                case PrimitiveTypeNode::Double: std::cout << "double"; break;
-            }
+            std::cout << PrimitiveTypeNode::kindName(prim->kind);
         } else if (auto* named = dynamic_cast<const NamedTypeNode*>(type)) {
             std::cout << named->identifier;
         } else if (auto* ptr = dynamic_cast<const PointerTypeNode*>(type)) {
@@ -353,6 +508,14 @@ namespace {
                 printExpression(comma->expressions[i], indent);
             }
             std::cout << ")";
+        } else if (auto* list = dynamic_cast<const InitializerListExprNode*>(expr)) {
+            std::cout << "{";
+            for (size_t i = 0; i < list->elements.size(); i++) {
+                if (i > 0)
+                    std::cout << ", ";
+                printExpression(list->elements[i], indent);
+            }
+            std::cout << "}";
         } else {
             std::cout << "<unknown expression>";
         }
@@ -453,6 +616,8 @@ namespace {
             std::cout << ");\n";
         } else if (auto* forStmt = dynamic_cast<const ForStatementNode*>(stmt)) {
             printIndent(indent);
+            if (dynamic_cast<const ParallelForStatementNode*>(stmt))
+                std::cout << "parallel ";
             std::cout << "for (";
             if (auto* initExpr = std::get_if<ExpressionNode*>(&forStmt->init)) {
                 if (*initExpr)
@@ -492,6 +657,25 @@ namespace {
                 printExpression(retStmt->returnValue);
             }
             std::cout << ";\n";
+        } else if (auto* switchStmt = dynamic_cast<const SwitchStatementNode*>(stmt)) {
+            printIndent(indent);
+            std::cout << "switch (";
+            printExpression(switchStmt->condition);
+            std::cout << ")\n";
+            for (auto* caseStmt : switchStmt->cases) {
+                printIndent(indent);
+                if (caseStmt->isDefault())
+                    std::cout << "default:\n";
+                else
+                    std::cout << "case " << caseStmt->value->value << ":\n";
+                printStatement(caseStmt->body, indent + 1);
+            }
+        } else if (dynamic_cast<const BreakStatementNode*>(stmt)) {
+            printIndent(indent);
+            std::cout << "break;\n";
+        } else if (dynamic_cast<const ContinueStatementNode*>(stmt)) {
+            printIndent(indent);
+            std::cout << "continue;\n";
         } else {
             printIndent(indent);
             std::cout << "<unknown statement>\n";
@@ -507,6 +691,10 @@ namespace {
 
         if (auto* varDecl = dynamic_cast<const VariableDeclNode*>(decl)) {
             printIndent(indent);
+            if (varDecl->isExtern)
+                std::cout << "extern ";
+            if (varDecl->isConst)
+                std::cout << "const ";
             printType(varDecl->type);
             std::cout << " " << varDecl->identifier;
             if (varDecl->arraySize) {
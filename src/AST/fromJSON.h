@@ -1,11 +1,25 @@
 #pragma once
 
+#include <ostream>
+#include <string>
+
 #include <nlohmann/json.hpp>
 
 struct ProgramNode;
 
-ProgramNode* fromJSON(const nlohmann::json& json);
+// threads > 1 builds the top-level declarations in parallel, each worker allocating its
+// nodes from its own ASTArena owned by the ProgramNode
+ProgramNode* fromJSON(const nlohmann::json& json, unsigned threads = 1);
+
+// Simd is the structural-index parser from SimdJSON.h, Nlohmann is json::parse
+enum class JSONParser { Simd, Nlohmann };
+
+nlohmann::json loadASTFromFile(const std::string& jsonFile, JSONParser parser = JSONParser::Simd);
+
+// Parses the file with both backends and prints their throughput
+void benchmarkJSONParsers(const std::string& jsonFile, std::ostream& out);
 
-nlohmann::json loadASTFromFile(const std::string& jsonFile);
+// Times fromJSON on the file with 1, 2, 4, ... up to maxThreads threads
+void benchmarkASTConstruction(const std::string& jsonFile, unsigned maxThreads, std::ostream& out);
 
 void printAST(const ProgramNode* ast);
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 // Forward declarations
 #include "ProgramNode.h"
+#include "SourceLocation.h"
 #include "declaration/DeclarationNode.h"
 #include "declaration/FunctionDeclNode.h"
 #include "declaration/FunctionPtrDeclNode.h"
@@ -12,10 +13,14 @@
 
 
 #include "statement/BlockStatementNode.h"
+#include "statement/BreakStatementNode.h"
+#include "statement/ContinueStatementNode.h"
 #include "statement/DoWhileStatementNode.h"
 #include "statement/ExpressionStatementNode.h"
 #include "statement/ForStatementNode.h"
 #include "statement/IfStatementNode.h"
+#include "statement/LoopAttributes.h"
+#include "statement/ParallelForStatementNode.h"
 #include "statement/ReturnStatementNode.h"
 #include "statement/StatementNode.h"
 #include "statement/SwitchStatementNode.h"
@@ -34,9 +39,11 @@
 #include "expression/CommaExprNode.h"
 #include "expression/IdentifierExprNode.h"
 #include "expression/IndexExprNode.h"
+#include "expression/InitializerListExprNode.h"
 #include "expression/MemberExprNode.h"
 
 
+#include "type/ArrayTypeNode.h"
 #include "type/NamedTypeNode.h"
 #include "type/PointerTypeNode.h"
 #include "type/PrimitiveTypeNode.h"
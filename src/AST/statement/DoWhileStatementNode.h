@@ -1,16 +1,18 @@
 #pragma once
 
 #include "../expression/ExpressionNode.h"
+#include "LoopAttributes.h"
 #include "StatementNode.h"
 
 
 struct DoWhileStatementNode : public StatementNode {
     ExpressionNode* condition;
     StatementNode* loopBody;
+    LoopAttributes attributes;
 
     DoWhileStatementNode(ExpressionNode* condition, StatementNode* body)
         : condition(condition),
-          loopBody(loopBody) {}
+          loopBody(body) {}
 
     void accept(CodeGen& codeGen) override { codeGen.visitDoWhileStatement(this); }
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <vector>
 #include "../declaration/DeclarationNode.h"
 #include "../expression/ExpressionNode.h"
+#include "LoopAttributes.h"
 #include "StatementNode.h"
 
 struct ForStatementNode : public StatementNode {
@@ -12,6 +13,7 @@ struct ForStatementNode : public StatementNode {
     ExpressionNode* update;
     ExpressionNode* condition;
     StatementNode* body;
+    LoopAttributes attributes;
 
     ForStatementNode(
         InitT init, ExpressionNode* condition, ExpressionNode* update, StatementNode* body
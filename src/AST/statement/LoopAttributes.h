@@ -0,0 +1,15 @@
+#pragma once
+
+
+// Optional loop hints from the AST, lowered to llvm.loop metadata on the latch branch
+// 0 means not specified and leaves the decision to LLVM
+struct LoopAttributes {
+    int unrollCount = 0;  // 1 disables unrolling
+    int vectorizeWidth = 0;  // 1 disables vectorization
+    int interleaveCount = 0;
+    bool distribute = false;
+
+    bool empty() const {
+        return unrollCount == 0 && vectorizeWidth == 0 && interleaveCount == 0 && !distribute;
+    }
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cassert>
+#include <string>
+#include "ForStatementNode.h"
+
+
+// for (int i = begin; i < end; i++) whose iterations may run in any order on several threads,
+// "parallel": true on a ForStatement. end is evaluated once before the loop, the body shares
+// the variables around it and must not break out of the loop, return or assign i
+struct ParallelForStatementNode : public ForStatementNode {
+    // How iterations are handed to threads, the values are the runtime's
+    enum Schedule {
+        Static = 0,   // One equal slice per thread, nothing moves between threads
+        Dynamic = 1,  // chunk iterations at a time, idle threads steal from busy ones
+        Guided = 2,   // Half of what a thread has left but at least chunk, with stealing
+    };
+
+    Schedule schedule = Static;
+    int chunk = 0;  // 0 leaves the chunk size to the runtime
+
+    using ForStatementNode::ForStatementNode;
+
+    static Schedule scheduleFromString(const std::string& name) {
+        if (name == "static")
+            return Static;
+        if (name == "dynamic")
+            return Dynamic;
+        if (name == "guided")
+            return Guided;
+        assert(false && "Invalid parallel for schedule");
+        return Static;
+    }
+
+    void accept(CodeGen& codeGen) override { codeGen.visitParallelForStatement(this); }
+};
\ No newline at end of file
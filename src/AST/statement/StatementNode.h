@@ -1,8 +1,12 @@
 #pragma once
 
 #include "../../CodeGen.h"
+#include "../ASTArena.h"
+#include "../SourceLocation.h"
+
+struct StatementNode : ArenaAllocated {
+    SourceLocation location;
 
-struct StatementNode {
     virtual ~StatementNode() = default;
     virtual void accept(CodeGen& codeGen) = 0;
 };
\ No newline at end of file
@@ -5,26 +5,25 @@
 
 #include <vector>
 
+// default is a case without a value, kept in source order so fall through reaches the next case
 struct CaseStatementNode : public StatementNode {
-    IntegerLiteralNode* value;
+    IntegerLiteralNode* value;  // Null for default
     StatementNode* body;
 
     CaseStatementNode(IntegerLiteralNode* value, StatementNode* body) : value(value), body(body) {}
 
+    bool isDefault() const { return !value; }
+
     void accept(CodeGen& codeGen) override { codeGen.visitCaseStatement(this); }
 };
 
 struct SwitchStatementNode : public StatementNode {
     ExpressionNode* condition;
-    std::vector<CaseStatementNode*> cases;
-    StatementNode* defaultBody;
+    std::vector<CaseStatementNode*> cases;  // default included
 
-    SwitchStatementNode(
-        ExpressionNode* condition, std::vector<CaseStatementNode*> cases, StatementNode* defaultBody
-    )
+    SwitchStatementNode(ExpressionNode* condition, std::vector<CaseStatementNode*> cases)
         : condition(condition),
-          cases(cases),
-          defaultBody(defaultBody) {}
+          cases(cases) {}
 
     void accept(CodeGen& codeGen) override { codeGen.visitSwitchStatement(this); }
 };
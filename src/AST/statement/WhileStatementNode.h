@@ -2,16 +2,18 @@
 
 #include <vector>
 #include "../expression/ExpressionNode.h"
+#include "LoopAttributes.h"
 #include "StatementNode.h"
 
 
 struct WhileStatementNode : public StatementNode {
     ExpressionNode* condition;
     StatementNode* loopBody;
+    LoopAttributes attributes;
 
     WhileStatementNode(ExpressionNode* condition, StatementNode* body)
         : condition(condition),
-          loopBody(loopBody) {}
+          loopBody(body) {}
 
     void accept(CodeGen& codeGen) override { codeGen.visitWhileStatement(this); }
 };
\ No newline at end of file
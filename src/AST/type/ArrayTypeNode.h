@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include "TypeNode.h"
+
+// Type of array variables. Never parsed, the AST keeps the size on the VariableDeclNode and
+// analyzeSemantics creates these for the expressions that name an array
+struct ArrayTypeNode : public TypeNode {
+    TypeNode* elementType;
+    uint64_t size;
+
+    ArrayTypeNode(TypeNode* elementType, uint64_t size) : elementType(elementType), size(size) {}
+
+    llvm::Type* accept(CodeGen& codeGen) override { return codeGen.visitArrayType(this); }
+};
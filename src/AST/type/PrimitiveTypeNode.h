@@ -8,7 +8,13 @@ struct PrimitiveTypeNode : public TypeNode {
         Void,
         Char,
         Int,
-        Double
+        Double,
+        // SIMD vectors, LLVM fixed vectors with element-wise operators
+        Int2,
+        Int4,
+        Int8,
+        Double2,
+        Double4
     };
 
     Kind kind;
@@ -16,16 +22,50 @@ struct PrimitiveTypeNode : public TypeNode {
     PrimitiveTypeNode(Kind kind) : kind(kind) {}
 
     static Kind kindFromString(const std::string& kindStr) {
-        if (kindStr == "void")
-            return Void;
-        if (kindStr == "int")
-            return Int;
-        if (kindStr == "double")
-            return Double;
-        if (kindStr == "char")
-            return Char;
+        for (const KindInfo& info : kinds) {
+            if (kindStr == info.name)
+                return info.kind;
+        }
         assert(false && "Invalid primitive type");
+        return Void;
+    }
+
+    static const char* kindName(Kind kind) { return kinds[kind].name; }
+
+    // Lanes of a vector, 1 for scalars
+    unsigned lanes() const { return kinds[kind].lanes; }
+    bool isVector() const { return lanes() > 1; }
+    Kind elementKind() const { return kinds[kind].element; }
+
+    // Vector type of lanes elements, Void when the language has none
+    static Kind vectorKind(Kind element, unsigned lanes) {
+        for (const KindInfo& info : kinds) {
+            if (info.element == element && info.lanes == lanes && lanes > 1)
+                return info.kind;
+        }
+        return Void;
     }
 
     llvm::Type* accept(CodeGen& codeGen) override { return codeGen.visitPrimitiveType(this); }
+
+  private:
+    struct KindInfo {
+        Kind kind;
+        const char* name;
+        Kind element;
+        unsigned lanes;
+    };
+
+    // Indexed by Kind
+    static constexpr KindInfo kinds[] = {
+        {Void, "void", Void, 1},
+        {Char, "char", Char, 1},
+        {Int, "int", Int, 1},
+        {Double, "double", Double, 1},
+        {Int2, "int2", Int, 2},
+        {Int4, "int4", Int, 4},
+        {Int8, "int8", Int, 8},
+        {Double2, "double2", Double, 2},
+        {Double4, "double4", Double, 4},
+    };
 };
\ No newline at end of file
@@ -2,8 +2,12 @@
 
 #include <llvm/IR/Type.h>
 #include "../../CodeGen.h"
+#include "../ASTArena.h"
+#include "../SourceLocation.h"
+
+struct TypeNode : ArenaAllocated {
+    SourceLocation location;
 
-struct TypeNode {
     virtual ~TypeNode() = default;
     virtual llvm::Type* accept(CodeGen& codeGen) = 0;
 };
\ No newline at end of file
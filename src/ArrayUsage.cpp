@@ -0,0 +1,61 @@
+#include "ArrayUsage.h"
+
+#include <unordered_map>
+
+#include "AST/ASTWalker.h"
+#include "AST/includeNodes.h"
+
+
+namespace {
+
+    class ArrayUsageWalker : public ASTWalker {
+      public:
+        ArrayUsage usage;
+
+        void visitExpression(ExpressionNode* node) override {
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(node)) {
+                m_uses[id->name]++;
+            } else if (auto* index = dynamic_cast<IndexExprNode*>(node)) {
+                if (auto* id = dynamic_cast<IdentifierExprNode*>(index->array))
+                    m_elementReads[id->name]++;
+            } else if (auto* bin = dynamic_cast<BinaryExprNode*>(node)) {
+                if (bin->op == "=")
+                    markWritten(bin->left);
+            } else if (auto* un = dynamic_cast<UnaryExprNode*>(node)) {
+                if (un->op == "++" || un->op == "--" || un->op == "&")
+                    markWritten(un->operand);
+            }
+        }
+
+        void finish() {
+            for (auto& [name, count] : m_uses) {
+                if (count > m_elementReads[name])
+                    usage.written.insert(name);
+            }
+        }
+
+      private:
+        // The array holding the target, through element and member chains like a[i].f or a[i][j]
+        void markWritten(ExpressionNode* target) {
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(target)) {
+                usage.written.insert(id->name);
+            } else if (auto* index = dynamic_cast<IndexExprNode*>(target)) {
+                if (!dynamic_cast<PointerTypeNode*>(index->array->resolvedType))
+                    markWritten(index->array);
+            } else if (auto* member = dynamic_cast<MemberExprNode*>(target)) {
+                if (!member->arrowAccess)
+                    markWritten(member->object);
+            }
+        }
+
+        std::unordered_map<std::string, unsigned> m_uses;
+        std::unordered_map<std::string, unsigned> m_elementReads;
+    };
+}  // namespace
+
+ArrayUsage analyzeArrayUsage(FunctionDeclNode* function) {
+    ArrayUsageWalker walker;
+    walker.walk(function->body);
+    walker.finish();
+    return std::move(walker.usage);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include "AST/forwardDecl.h"
+
+
+// Names of local arrays in a function that may be modified: element stores, ++/--, & on an
+// element, or any use of the array other than reading an element (it decays to a pointer).
+// Scopes are ignored, a name counts as written if any variable with that name is
+struct ArrayUsage {
+    std::unordered_set<std::string> written;
+
+    bool isReadOnly(const std::string& name) const { return !written.count(name); }
+};
+
+ArrayUsage analyzeArrayUsage(FunctionDeclNode* function);
@@ -0,0 +1,53 @@
+#include "Builtins.h"
+
+#include <unordered_map>
+
+#include "AST/includeNodes.h"
+
+
+namespace {
+
+    std::unordered_map<std::string, Builtin> createBuiltins() {
+        std::unordered_map<std::string, Builtin> builtins = {
+            {"__builtin_shufflevector", {BuiltinKind::ShuffleVector}},
+            {"__builtin_reduce_add", {BuiltinKind::ReduceAdd}},
+            {"__builtin_reduce_mul", {BuiltinKind::ReduceMul}},
+            {"__builtin_reduce_min", {BuiltinKind::ReduceMin}},
+            {"__builtin_reduce_max", {BuiltinKind::ReduceMax}},
+            {"__builtin_reduce_and", {BuiltinKind::ReduceAnd}},
+            {"__builtin_reduce_or", {BuiltinKind::ReduceOr}},
+            {"__builtin_reduce_xor", {BuiltinKind::ReduceXor}},
+            {"__builtin_sqrt", {BuiltinKind::Sqrt}},
+            {"__builtin_fabs", {BuiltinKind::Fabs}},
+            {"__builtin_floor", {BuiltinKind::Floor}},
+            {"__builtin_ceil", {BuiltinKind::Ceil}},
+            {"__builtin_trunc", {BuiltinKind::Trunc}},
+            {"__builtin_round", {BuiltinKind::Round}},
+            {"__builtin_fmin", {BuiltinKind::Fmin}},
+            {"__builtin_fmax", {BuiltinKind::Fmax}},
+            {"__builtin_fma", {BuiltinKind::Fma}},
+            {"__builtin_popcount", {BuiltinKind::Popcount}},
+            {"__builtin_clz", {BuiltinKind::Clz}},
+            {"__builtin_ctz", {BuiltinKind::Ctz}},
+            {"__builtin_prefetch", {BuiltinKind::Prefetch}},
+            {"__builtin_expect", {BuiltinKind::Expect}},
+        };
+
+        for (int kind = PrimitiveTypeNode::Void; kind <= PrimitiveTypeNode::Double4; kind++) {
+            if (!PrimitiveTypeNode(PrimitiveTypeNode::Kind(kind)).isVector())
+                continue;
+            std::string name = PrimitiveTypeNode::kindName(PrimitiveTypeNode::Kind(kind));
+            builtins[name + "_load"] = {BuiltinKind::VectorLoad, name, false};
+            builtins[name + "_load_aligned"] = {BuiltinKind::VectorLoad, name, true};
+            builtins[name + "_store"] = {BuiltinKind::VectorStore, name, false};
+            builtins[name + "_store_aligned"] = {BuiltinKind::VectorStore, name, true};
+        }
+        return builtins;
+    }
+}  // namespace
+
+const Builtin* lookupBuiltin(const std::string& name) {
+    static const std::unordered_map<std::string, Builtin> builtins = createBuiltins();
+    auto it = builtins.find(name);
+    return it != builtins.end() ? &it->second : nullptr;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+
+// Functions the compiler provides without a declaration. Sema checks their arguments and sets
+// CallExprNode::builtin, CodeGen::visitBuiltinCall lowers them inline
+enum class BuiltinKind {
+    // __builtin_shufflevector(a, b, lane...), lanes are constants indexing a then b
+    ShuffleVector,
+    // __builtin_reduce_<op>(v), one lane from all lanes of a vector
+    ReduceAdd,
+    ReduceMul,
+    ReduceMin,
+    ReduceMax,
+    ReduceAnd,
+    ReduceOr,
+    ReduceXor,
+    // <vector>_load(p) and <vector>_store(p, v), p points to the first element. The _aligned
+    // versions require p aligned to the vector size
+    VectorLoad,
+    VectorStore,
+    // __builtin_<name>(x...) like the C math functions but never setting errno. Doubles or
+    // double vectors, lane by lane
+    Sqrt,
+    Fabs,
+    Floor,
+    Ceil,
+    Trunc,
+    Round,
+    Fmin,
+    Fmax,
+    Fma,
+    // __builtin_popcount, __builtin_clz and __builtin_ctz, ints or int vectors lane by lane. The
+    // zero count of 0 is undefined like in GCC
+    Popcount,
+    Clz,
+    Ctz,
+    // __builtin_prefetch(p, rw = 0, locality = 3), rw and locality are constants
+    Prefetch,
+    // __builtin_expect(value, expected) is value, expected is a constant hint for the branch
+    Expect,
+};
+
+struct Builtin {
+    BuiltinKind kind;
+    std::string vectorType = "";  // Loads and stores, the PrimitiveTypeNode kind name
+    bool aligned = false;
+};
+
+// Null when name is no builtin. Declared functions with the same name take precedence
+const Builtin* lookupBuiltin(const std::string& name);
@@ -0,0 +1,207 @@
+#include "CallTargets.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <unordered_set>
+
+#include <nlohmann/json.hpp>
+
+#include "AST/ASTWalker.h"
+#include "AST/includeNodes.h"
+
+
+namespace {
+
+    // Everything stored to a variable or parameter, sources are other variables copied from
+    struct Flow {
+        std::set<std::string> functions;
+        std::vector<const DeclarationNode*> sources;
+        bool unknown = false;  // Stored from a value we can't follow, or written through &
+    };
+
+    using Flows = std::unordered_map<const DeclarationNode*, Flow>;
+
+    void assign(Flows& flows, const DeclarationNode* target, ExpressionNode* value) {
+        Flow& flow = flows[target];
+        if (auto* id = dynamic_cast<IdentifierExprNode*>(value)) {
+            if (dynamic_cast<FunctionDeclNode*>(id->declaration)) {
+                flow.functions.insert(id->name);
+            } else if (id->declaration) {
+                flow.sources.push_back(id->declaration);
+            } else {
+                flow.unknown = true;
+            }
+        } else if (auto* un = dynamic_cast<UnaryExprNode*>(value); un && un->op == "&") {
+            assign(flows, target, un->operand);  // &f is f
+        } else if (auto* cast = dynamic_cast<CastExprNode*>(value)) {
+            assign(flows, target, cast->operand);
+        } else if (auto* comma = dynamic_cast<CommaExprNode*>(value)) {
+            assign(flows, target, comma->expressions.back());
+        } else if (!dynamic_cast<IntegerLiteralNode*>(value)) {
+            // Null is no target, calls through it are undefined anyway
+            flow.unknown = true;
+        }
+    }
+
+    class CallTargetsWalker : public ASTWalker {
+      public:
+        Flows flows;
+        std::unordered_map<std::string, FunctionDeclNode*> definitions;
+        std::unordered_set<std::string> addressTaken;
+        std::vector<CallExprNode*> calls;
+
+        void visitDeclaration(DeclarationNode* node) override {
+            if (auto* funcDecl = dynamic_cast<FunctionDeclNode*>(node)) {
+                if (funcDecl->body)
+                    definitions[funcDecl->identifier] = funcDecl;
+            } else if (auto* varDecl = dynamic_cast<VariableDeclNode*>(node)) {
+                if (varDecl->initializer)
+                    assign(flows, varDecl, varDecl->initializer);
+            }
+        }
+
+        void visitExpression(ExpressionNode* node) override {
+            if (auto* call = dynamic_cast<CallExprNode*>(node)) {
+                m_directCallees.insert(call->callee);
+                calls.push_back(call);
+            } else if (auto* bin = dynamic_cast<BinaryExprNode*>(node)) {
+                auto* id = dynamic_cast<IdentifierExprNode*>(bin->left);
+                if (bin->op == "=" && id && id->declaration)
+                    assign(flows, id->declaration, bin->right);
+            } else if (auto* un = dynamic_cast<UnaryExprNode*>(node)) {
+                auto* id = dynamic_cast<IdentifierExprNode*>(un->operand);
+                if (un->op == "&" && id && id->declaration &&
+                    !dynamic_cast<FunctionDeclNode*>(id->declaration)) {
+                    flows[id->declaration].unknown = true;
+                }
+            } else if (auto* id = dynamic_cast<IdentifierExprNode*>(node)) {
+                // Callees are reported before their identifier
+                if (dynamic_cast<FunctionDeclNode*>(id->declaration) && !m_directCallees.count(id))
+                    addressTaken.insert(id->name);
+            }
+        }
+
+      private:
+        std::unordered_set<const ExpressionNode*> m_directCallees;
+    };
+}  // namespace
+
+std::vector<CallTargets::Target> CallTargets::promote(
+    const std::string& caller,
+    const std::string& pointerName,
+    const DeclarationNode* pointer
+) const {
+    auto knownIt = known.find(pointer);
+    const std::vector<std::string>* proven = knownIt != known.end() ? &knownIt->second : nullptr;
+    auto isProven = [&](const std::string& function) {
+        return !proven || std::find(proven->begin(), proven->end(), function) != proven->end();
+    };
+
+    // Profiled targets taking at least a tenth of the calls, like the hot/cold field split
+    std::vector<Target> targets;
+    auto profileIt = profile.find(caller + ":" + pointerName);
+    if (profileIt != profile.end()) {
+        uint64_t total = 0;
+        for (const auto& [function, count] : profileIt->second) {
+            total += count;
+        }
+        for (const auto& [function, count] : profileIt->second) {
+            if (count > 0 && count * 10 >= total && isProven(function))
+                targets.push_back({function, count});
+        }
+        std::sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) {
+            return a.count != b.count ? a.count > b.count : a.function < b.function;
+        });
+    }
+
+    if (proven) {
+        for (const std::string& function : *proven) {
+            auto same = [&](const Target& target) { return target.function == function; };
+            if (std::none_of(targets.begin(), targets.end(), same))
+                targets.push_back({function, 0});
+        }
+    }
+    if (targets.size() > maxTargets)
+        targets.resize(maxTargets);
+    return targets;
+}
+
+CallTargets analyzeCallTargets(ProgramNode* program) {
+    CallTargetsWalker walker;
+    walker.walk(program);
+    Flows& flows = walker.flows;
+
+    // Arguments of direct calls flow into the parameters. Functions called from elsewhere,
+    // through a pointer or as main, may get anything
+    auto calledFromElsewhere = [&](const std::string& name) {
+        return name == "main" || walker.addressTaken.count(name);
+    };
+    for (CallExprNode* call : walker.calls) {
+        auto it = walker.definitions.find(call->callee->name);
+        if (it == walker.definitions.end() || calledFromElsewhere(it->first))
+            continue;
+        const auto& parameters = it->second->parameters;
+        for (size_t i = 0; i < call->arguments.size() && i < parameters.size(); i++) {
+            assign(flows, parameters[i], call->arguments[i]);
+        }
+    }
+    for (const auto& [name, funcDecl] : walker.definitions) {
+        if (!calledFromElsewhere(name))
+            continue;
+        for (auto* param : funcDecl->parameters) {
+            flows[param].unknown = true;
+        }
+    }
+
+    // Copies between variables, until nothing changes. Sets over maxTargets aren't worth guarding
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [declaration, flow] : flows) {
+            if (flow.unknown)
+                continue;
+            for (const DeclarationNode* source : flow.sources) {
+                auto it = flows.find(source);
+                if (it == flows.end())
+                    continue;
+                if (it->second.unknown) {
+                    flow.unknown = true;
+                    break;
+                }
+                size_t before = flow.functions.size();
+                flow.functions.insert(it->second.functions.begin(), it->second.functions.end());
+                changed |= flow.functions.size() != before;
+            }
+            if (flow.functions.size() > CallTargets::maxTargets)
+                flow.unknown = true;
+            changed |= flow.unknown;
+        }
+    }
+
+    CallTargets targets;
+    for (const auto& [declaration, flow] : flows) {
+        if (!flow.unknown && !flow.functions.empty())
+            targets.known[declaration].assign(flow.functions.begin(), flow.functions.end());
+    }
+    return targets;
+}
+
+void loadCallProfile(CallTargets& targets, const std::string& profileFile) {
+    std::ifstream R(profileFile);
+    if (!R.is_open()) {
+        throw std::runtime_error("Call profile could not be opened: " + profileFile);
+    }
+
+    try {
+        nlohmann::json data = nlohmann::json::parse(R);
+        for (const auto& [site, functions] : data.items()) {
+            for (const auto& [function, count] : functions.items()) {
+                targets.profile[site][function] = count.get<uint64_t>();
+            }
+        }
+    } catch (nlohmann::json::exception& e) {
+        throw std::runtime_error("Invalid call profile: " + std::string(e.what()));
+    }
+}
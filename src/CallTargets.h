@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/forwardDecl.h"
+
+
+// Functions a call through a function pointer may reach, used by CodeGen::visitCallExpr to
+// guard direct calls to them before the indirect call. The indirect call stays as fallback, so
+// a wrong guess, e.g. a pointer set by another module, only costs the compares
+struct CallTargets {
+    static constexpr size_t maxTargets = 4;
+
+    struct Target {
+        std::string function;
+        uint64_t count;  // Profile count, 0 without a profile
+    };
+
+    // Every function a pointer variable or parameter can hold, only for small proven sets
+    std::unordered_map<const DeclarationNode*, std::vector<std::string>> known;
+    // Value profile, "caller:pointer" -> function -> calls
+    std::unordered_map<std::string, std::unordered_map<std::string, uint64_t>> profile;
+
+    // Targets to guard at a call through pointer in caller, hottest first
+    std::vector<Target> promote(
+        const std::string& caller,
+        const std::string& pointerName,
+        const DeclarationNode* pointer
+    ) const;
+};
+
+// Needs the declarations analyzeSemantics sets on identifiers
+CallTargets analyzeCallTargets(ProgramNode* program);
+
+// Profile is a JSON object {"caller:pointer": {"function": count, ...}, ...}
+void loadCallProfile(CallTargets& targets, const std::string& profileFile);
@@ -1,12 +1,24 @@
 #include "CodeGen.h"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <string>
 
+#include <llvm/Analysis/ConstantFolding.h>
+#include <llvm/Bitcode/BitcodeWriterPass.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/Metadata.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Scalar/TailRecursionElimination.h>
 
 #include "AST/includeNodes.h"
+#include "Builtins.h"
+#include "LoopCaptures.h"
 
 
 using namespace llvm;
@@ -16,16 +28,51 @@ void* LogError(const char* msg) {
     return nullptr;
 }
 
-CodeGen::CodeGen(const std::string& moduleName)
+CodeGen::CodeGen(const std::string& moduleName, TargetMachine* targetMachine)
     : m_context(std::make_unique<LLVMContext>()),
       m_module(std::make_unique<Module>(moduleName, *m_context)),
-      m_builder(std::make_unique<IRBuilder<>>(*m_context)) {}
+      m_builder(std::make_unique<IRBuilder<>>(*m_context)),
+      m_targetMachine(targetMachine) {
+    if (m_targetMachine) {
+        m_module->setTargetTriple(m_targetMachine->getTargetTriple());
+        m_module->setDataLayout(m_targetMachine->createDataLayout());
+    }
+}
+
+void CodeGen::enableDebugInfo(const std::string& sourceFile) {
+    m_module->addModuleFlag(Module::Warning, "Debug Info Version", DEBUG_METADATA_VERSION);
+    m_module->addModuleFlag(Module::Warning, "Dwarf Version", 4);
+
+    m_debugBuilder = std::make_unique<DIBuilder>(*m_module);
+    DIFile* file = m_debugBuilder->createFile(
+        sys::path::filename(sourceFile), sys::path::parent_path(sourceFile)
+    );
+    m_debugUnit = m_debugBuilder->createCompileUnit(
+        dwarf::DW_LANG_C, file, "my_compiler", false, "", 0, "", DICompileUnit::LineTablesOnly
+    );
+}
+
+// Nodes without a location get the line of their function. Every inlinable call in a function
+// with debug info needs a location, or the verifier rejects the module
+void CodeGen::emitLocation(const SourceLocation& location) {
+    if (!m_debugScope)
+        return;
+    unsigned line = location.isValid() ? location.line : m_debugScope->getLine();
+    unsigned column = location.isValid() ? location.column : 0;
+    m_builder->SetCurrentDebugLocation(DILocation::get(*m_context, line, column, m_debugScope));
+}
 
 void CodeGen::generate(ProgramNode* program) {
     for (auto* declaration : program->declarations) {
         declaration->accept(*this);
     }
 
+    if (m_debugBuilder) {
+        m_debugBuilder->finalize();
+    }
+}
+
+void CodeGen::verify() {
     // Verify the entire module for consistency
     std::string errorMsg;
     raw_string_ostream errorStream(errorMsg);
@@ -35,6 +82,88 @@ void CodeGen::generate(ProgramNode* program) {
     }
 }
 
+void CodeGen::runModulePasses(
+    const std::function<ModulePassManager(PassBuilder&)>& buildPipeline
+) {
+    LoopAnalysisManager LAM;
+    FunctionAnalysisManager FAM;
+    CGSCCAnalysisManager CGAM;
+    ModuleAnalysisManager MAM;
+
+    PassBuilder PB(m_targetMachine);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    ModulePassManager MPM = buildPipeline(PB);
+    MPM.run(*m_module, MAM);
+}
+
+void CodeGen::optimize(unsigned level) {
+    bool tailRecursionLoops = m_tailRecursionLoops;
+    runModulePasses([level, tailRecursionLoops](PassBuilder& PB) {
+        switch (level) {
+            case 0: {
+                ModulePassManager MPM = PB.buildO0DefaultPipeline(OptimizationLevel::O0);
+                if (tailRecursionLoops)
+                    MPM.addPass(createModuleToFunctionPassAdaptor(TailCallElimPass()));
+                return MPM;
+            }
+            case 1: return PB.buildPerModuleDefaultPipeline(OptimizationLevel::O1);
+            case 2: return PB.buildPerModuleDefaultPipeline(OptimizationLevel::O2);
+            default: return PB.buildPerModuleDefaultPipeline(OptimizationLevel::O3);
+        }
+    });
+}
+
+void CodeGen::emitThinLTOBitcode(unsigned level, raw_ostream& out) {
+    runModulePasses([level, &out](PassBuilder& PB) {
+        // The pre-link pipeline leaves inlining across modules to the thin link
+        ModulePassManager MPM;
+        switch (level) {
+            case 0:
+                MPM = PB.buildO0DefaultPipeline(
+                    OptimizationLevel::O0, ThinOrFullLTOPhase::ThinLTOPreLink
+                );
+                break;
+            case 1: MPM = PB.buildThinLTOPreLinkDefaultPipeline(OptimizationLevel::O1); break;
+            case 2: MPM = PB.buildThinLTOPreLinkDefaultPipeline(OptimizationLevel::O2); break;
+            default: MPM = PB.buildThinLTOPreLinkDefaultPipeline(OptimizationLevel::O3); break;
+        }
+        // Summary and module hash are what the thin link and its cache work from
+        MPM.addPass(BitcodeWriterPass(out, false, true, true));
+        return MPM;
+    });
+}
+
+void CodeGen::setMultiModule() {
+    m_multiModule = true;
+}
+
+void CodeGen::setStructLayout(StructLayoutMode mode, StructUsage usage) {
+    m_structLayout = mode;
+    m_structUsage = std::move(usage);
+}
+
+void CodeGen::setTailRecursionLoops() {
+    m_tailRecursionLoops = true;
+}
+
+void CodeGen::setCallTargets(CallTargets targets) {
+    m_callTargets = std::move(targets);
+}
+
+void CodeGen::setFastMath(FastMathFlags flags) {
+    m_builder->setFastMathFlags(flags);
+}
+
+void CodeGen::setWholeProgram(FunctionAttrsAnalysis analysis) {
+    m_wholeProgram = true;
+    m_functionAttrs = std::move(analysis);
+}
+
 void CodeGen::print() {
     m_module->print(outs(), nullptr);
 }
@@ -80,9 +209,60 @@ void CodeGen::visitFunctionDeclaration(FunctionDeclNode* node) {
     for (auto& arg : function->args()) {
         arg.setName(node->parameters[idx++]->identifier);
     }
+
+    // Without these the backend (and clang on the emitted .ll) targets the generic CPU
+    if (m_targetMachine) {
+        function->addFnAttr("target-cpu", m_targetMachine->getTargetCPU());
+        if (!m_targetMachine->getTargetFeatureString().empty())
+            function->addFnAttr("target-features", m_targetMachine->getTargetFeatureString());
+    }
+
+    if (m_wholeProgram)
+        applyFunctionAttributes(function);
     //return function;
 }
 
+void CodeGen::applyFunctionAttributes(Function* function) {
+    // The language has no exceptions and the runtime is plain C
+    function->addFnAttr(Attribute::NoUnwind);
+
+    const FunctionFacts* facts = m_functionAttrs.lookup(function->getName().str());
+    if (!facts || !facts->isDefined)
+        return;
+
+    // Only main and the runtime externs are visible outside the program
+    if (function->getName() != "main") {
+        function->setLinkage(GlobalValue::InternalLinkage);
+        // Indirect calls use the C convention, so only functions never used as a value.
+        // Under tailcc every call marked tail is eliminated, whatever the two signatures
+        if (!facts->addressTaken)
+            function->setCallingConv(facts->noRecurse ? CallingConv::Fast : CallingConv::Tail);
+    }
+
+    if (facts->noRecurse)
+        function->addFnAttr(Attribute::NoRecurse);
+    if (facts->willReturn)
+        function->addFnAttr(Attribute::WillReturn);
+
+    ModRefInfo argMem = ModRefInfo::NoModRef;
+    if (facts->readsArgMem)
+        argMem |= ModRefInfo::Ref;
+    if (facts->writesArgMem)
+        argMem |= ModRefInfo::Mod;
+    ModRefInfo otherMem = ModRefInfo::NoModRef;
+    if (facts->readsOtherMem)
+        otherMem |= ModRefInfo::Ref;
+    if (facts->writesOtherMem)
+        otherMem |= ModRefInfo::Mod;
+
+    if (isNoModRef(otherMem)) {
+        // memory(none) or memory(argmem: ...)
+        function->setMemoryEffects(MemoryEffects::argMemOnly(argMem));
+    } else if (!isModSet(otherMem) && !isModSet(argMem)) {
+        function->setMemoryEffects(MemoryEffects::readOnly());
+    }
+}
+
 void CodeGen::visitFunctionDefinition(FunctionDeclNode* node) {
     Function* function = m_module->getFunction(node->identifier);
     if (!function) {
@@ -90,18 +270,18 @@ void CodeGen::visitFunctionDefinition(FunctionDeclNode* node) {
         function = m_module->getFunction(node->identifier);
     }
 
-    // skip generation of body if its empty, this is workaround for poor ast so I can add runtime functions like print_number;
-    if (node->body->body.size() == 0)
-        return;
+    createDebugScope(function, node->location.line);
+
+    m_arrayUsage = analyzeArrayUsage(node);
 
     // gen function body
     BasicBlock* entry = BasicBlock::Create(*m_context, "entry", function);
     m_builder->SetInsertPoint(entry);
+    emitLocation(node->location);
 
 
     // Add parameters to symbol table
     m_scopeCtx = Context::create(std::move(m_scopeCtx));
-    unsigned idx = 0;
     for (auto& arg : function->args()) {
         std::string argName = std::string(arg.getName());
         Type* argType = arg.getType();  // Get type directly from LLVM argument
@@ -113,56 +293,446 @@ void CodeGen::visitFunctionDefinition(FunctionDeclNode* node) {
 
         m_scopeCtx->set(argName, alloca);
         m_scopeCtx->setType(argName, argType);
-        m_scopeCtx->setTypeNode(argName, node->parameters[idx]->type);  // Track AST type
-        idx++;
     }
 
     visitBlockStatement(node->body);
 
     BasicBlock* currentBB = m_builder->GetInsertBlock();
     if (!currentBB->getTerminator()) {
-        // Check if return type is void using the LLVM type
-        Type* returnType = node->returnType->accept(*this);
-        if (returnType->isVoidTy()) {
+        if (function->getReturnType()->isVoidTy()) {
             m_builder->CreateRetVoid();
         } else {
             throw std::runtime_error("Missing return in non-void function: " + node->identifier);
         }
     }
 
+    markTailCalls(function);
     verifyFunction(*function);
 
     m_scopeCtx = m_scopeCtx->destroy();
+    m_debugScope = nullptr;
+    m_builder->SetCurrentDebugLocation(DebugLoc());
 }
-//TODO global and constant variables
-void CodeGen::visitVariableDeclaration(VariableDeclNode* node) {
+
+// Locations emitted from now on belong to function, nothing without debug info
+void CodeGen::createDebugScope(Function* function, unsigned line) {
+    if (!m_debugBuilder)
+        return;
+    DISubroutineType* debugType =
+        m_debugBuilder->createSubroutineType(m_debugBuilder->getOrCreateTypeArray({}));
+    m_debugScope = m_debugBuilder->createFunction(
+        m_debugUnit->getFile(),
+        function->getName(),
+        StringRef(),
+        m_debugUnit->getFile(),
+        line,
+        debugType,
+        line,
+        DINode::FlagPrototyped,
+        DISubprogram::SPFlagDefinition
+    );
+    function->setSubprogram(m_debugScope);
+}
+
+// Whether the callee of a tail call could be handed a pointer into this frame. Loads and
+// stores through a local, directly or at an offset, keep it private
+static bool hasEscapingAllocas(Function* function) {
+    std::vector<Value*> worklist;
+    for (Instruction& inst : function->getEntryBlock()) {
+        if (isa<AllocaInst>(inst))
+            worklist.push_back(&inst);
+    }
+    while (!worklist.empty()) {
+        Value* ptr = worklist.back();
+        worklist.pop_back();
+        for (User* user : ptr->users()) {
+            if (isa<LoadInst>(user))
+                continue;
+            if (auto* store = dyn_cast<StoreInst>(user); store && store->getPointerOperand() == ptr)
+                continue;
+            if (isa<GetElementPtrInst>(user)) {
+                worklist.push_back(user);
+                continue;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decided once the whole body is known, a local whose address is taken after a return f(x)
+// in source order may still be live at it inside a loop. musttail is kept at every
+// optimization level, plain tail is a hint unless the callee is tailcc
+void CodeGen::markTailCalls(Function* function) {
+    std::vector<CallInst*> calls = std::move(m_tailCalls);
+    m_tailCalls.clear();
+    if (calls.empty() || hasEscapingAllocas(function))
+        return;
+
+    for (CallInst* call : calls) {
+        Function* callee = call->getCalledFunction();
+        auto* ret = dyn_cast_or_null<ReturnInst>(call->getNextNode());
+        bool returnsResult = ret && ret->getReturnValue() == call;
+        bool sameSignature = callee && callee->getFunctionType() == function->getFunctionType() &&
+                             callee->getCallingConv() == function->getCallingConv();
+        call->setTailCallKind(
+            returnsResult && sameSignature ? CallInst::TCK_MustTail : CallInst::TCK_Tail
+        );
+    }
+}
+
+void CodeGen::visitGlobalVariable(VariableDeclNode* node) {
     Type* type = node->type->accept(*this);
-    AllocaInst* allocaInst = nullptr;
+    Type* varType = type;
     if (node->arraySize) {
         int arrSize = dynamic_cast<IntegerLiteralNode*>(node->arraySize)->value;
-        ArrayType* arrT = ArrayType::get(type, arrSize);
-        allocaInst = m_builder->CreateAlloca(arrT, 0, node->identifier);
+        varType = ArrayType::get(type, arrSize);
+    }
+
+    GlobalVariable* global = nullptr;
+    if (node->isExtern) {
+        // Declaration only, defined by another module
+        global = new GlobalVariable(
+            *m_module, varType, node->isConst, GlobalValue::ExternalLinkage, nullptr, node->identifier
+        );
+    } else {
+        // Zero initializers end up in .bss, anything else must fold to a constant
+        Constant* init = Constant::getNullValue(varType);
+        if (node->initializer) {
+            bool isConstant = true;
+            init = buildConstantImage(node->initializer, varType, isConstant);
+            if (!isConstant)
+                throw std::runtime_error("Global initializer is not constant: " + node->identifier);
+        }
+
+        // With a single module nothing outside can refer to the variable, otherwise the thin
+        // link internalizes whatever no other module uses
+        global = new GlobalVariable(
+            *m_module, varType, node->isConst,
+            m_multiModule ? GlobalValue::ExternalLinkage : GlobalValue::InternalLinkage, init,
+            node->identifier
+        );
+        global->setAlignment(m_module->getDataLayout().getPrefTypeAlign(varType));
+        if (node->isConst) {
+            // .rodata, and identical constants may be merged
+            global->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+        }
+    }
 
-        // TODO: Array initializers not yet supported
-        assert(!node->initializer && "Array initializers not implemented");
+    m_scopeCtx->set(node->identifier, global);
+    m_scopeCtx->setType(node->identifier, varType);
+}
 
+void CodeGen::visitVariableDeclaration(VariableDeclNode* node) {
+    if (m_scopeCtx->type == Context::Global) {
+        visitGlobalVariable(node);
+        return;
+    }
+
+    Type* type = node->type->accept(*this);
+    Type* varType = type;
+    int arrSize = 0;
+    if (node->arraySize) {
+        arrSize = dynamic_cast<IntegerLiteralNode*>(node->arraySize)->value;
+        varType = ArrayType::get(type, arrSize);
+    }
+
+    Value* storage = nullptr;
+    bool isStringArray = node->arraySize && dynamic_cast<StringLiteralNode*>(node->initializer);
+    if (dynamic_cast<InitializerListExprNode*>(node->initializer) || isStringArray) {
+        storage = emitAggregateInitializer(
+            node->identifier, varType, node->initializer, node->isConst
+        );
+    } else if (node->arraySize) {
+        AllocaInst* allocaInst = createEntryAlloca(varType, node->identifier);
+        if (auto* structType = dyn_cast<StructType>(type))
+            initColdStorage(structType, allocaInst, arrSize, true);
+        assert(!node->initializer && "Array can only be initialized with a list or string");
+        storage = allocaInst;
     } else {
-        allocaInst = m_builder->CreateAlloca(type, 0, node->identifier);
+        AllocaInst* allocaInst = createEntryAlloca(type, node->identifier);
+        if (auto* structType = dyn_cast<StructType>(type))
+            initColdStorage(structType, allocaInst, 1, false);
         if (node->initializer) {
             auto* idNode = dynamic_cast<IdentifierExprNode*>(node->initializer);
             Function* func = idNode ? m_module->getFunction(idNode->name) : nullptr;
             if (func) {
                 m_builder->CreateStore(func, allocaInst);
-            } else {
-                Value* initVal = getValueOf(node->initializer);
+            } else if (!copyAggregate(allocaInst, node->initializer, type)) {
+                Value* initVal = coerceForStore(getValueOf(node->initializer), type);
                 m_builder->CreateStore(initVal, allocaInst);
             }
         }
+        storage = allocaInst;
+    }
+
+    m_scopeCtx->set(node->identifier, storage);
+    m_scopeCtx->setType(node->identifier, varType);
+}
+
+// Integer and floating point opcode of each arithmetic operator, 0 when there is no FP version
+static const std::unordered_map<std::string, std::pair<unsigned, unsigned>> arithmeticOpcodes = {
+    {"+", {Instruction::Add, Instruction::FAdd}},
+    {"-", {Instruction::Sub, Instruction::FSub}},
+    {"*", {Instruction::Mul, Instruction::FMul}},
+    {"/", {Instruction::SDiv, Instruction::FDiv}},
+    {"%", {Instruction::SRem, Instruction::FRem}},
+    {"&", {Instruction::And, 0}},
+    {"|", {Instruction::Or, 0}},
+    {"^", {Instruction::Xor, 0}},
+    {"<<", {Instruction::Shl, 0}},
+    {">>", {Instruction::AShr, 0}},
+};
+
+// Signed integer and floating point predicate of each comparison. FP ones are ordered, except
+// != which must be true for NaN like in C
+static const std::unordered_map<std::string, std::pair<CmpInst::Predicate, CmpInst::Predicate>>
+    comparePredicates = {
+        {"<", {CmpInst::ICMP_SLT, CmpInst::FCMP_OLT}},
+        {">", {CmpInst::ICMP_SGT, CmpInst::FCMP_OGT}},
+        {"<=", {CmpInst::ICMP_SLE, CmpInst::FCMP_OLE}},
+        {">=", {CmpInst::ICMP_SGE, CmpInst::FCMP_OGE}},
+        {"==", {CmpInst::ICMP_EQ, CmpInst::FCMP_OEQ}},
+        {"!=", {CmpInst::ICMP_NE, CmpInst::FCMP_UNE}},
+};
+
+Constant* CodeGen::foldConstantExpr(ExpressionNode* node, Type* type) {
+    if (auto* binaryNode = dynamic_cast<BinaryExprNode*>(node)) {
+        auto it = arithmeticOpcodes.find(binaryNode->op);
+        if (it == arithmeticOpcodes.end())
+            return nullptr;
+        unsigned opcode = type->isFPOrFPVectorTy() ? it->second.second : it->second.first;
+        if (!opcode || !(type->isIntOrIntVectorTy() || type->isFPOrFPVectorTy()))
+            return nullptr;
+
+        Constant* left = foldConstantExpr(binaryNode->left, type);
+        Constant* right = foldConstantExpr(binaryNode->right, type);
+        if (!left || !right)
+            return nullptr;
+        // Leave division by zero to runtime instead of folding it to poison
+        if ((opcode == Instruction::SDiv || opcode == Instruction::SRem) && right->isNullValue())
+            return nullptr;
+        return ConstantFoldBinaryOpOperands(opcode, left, right, m_module->getDataLayout());
+    }
+
+    if (auto* unaryNode = dynamic_cast<UnaryExprNode*>(node)) {
+        if (unaryNode->op != "-")
+            return nullptr;
+        Constant* operand = foldConstantExpr(unaryNode->operand, type);
+        if (auto* intConst = dyn_cast_or_null<ConstantInt>(operand))
+            return ConstantInt::get(type, -intConst->getValue());
+        if (auto* fpConst = dyn_cast_or_null<ConstantFP>(operand))
+            return ConstantFP::get(type, -fpConst->getValueAPF().convertToDouble());
+        return nullptr;
+    }
+
+    if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node)) {
+        // Function addresses are link-time constants, e.g. dispatch tables
+        if (type->isPointerTy())
+            return m_module->getFunction(idNode->name);
+        return nullptr;
+    }
+
+    double fpValue = 0;
+    int64_t intValue = 0;
+    if (auto* intLit = dynamic_cast<IntegerLiteralNode*>(node)) {
+        intValue = intLit->value;
+        fpValue = intLit->value;
+    } else if (auto* charLit = dynamic_cast<CharacterLiteralNode*>(node)) {
+        intValue = charLit->value;
+        fpValue = charLit->value;
+    } else if (auto* doubleLit = dynamic_cast<DoubleLiteralNode*>(node)) {
+        intValue = static_cast<int64_t>(doubleLit->value);
+        fpValue = doubleLit->value;
+    } else {
+        return nullptr;
+    }
+
+    // Vectors get the value in every lane
+    if (type->isIntOrIntVectorTy())
+        return ConstantInt::get(type, intValue, true);
+    if (type->isFPOrFPVectorTy())
+        return ConstantFP::get(type, fpValue);
+    return nullptr;
+}
+
+// Constant value of an initializer, non-constant leaves are left as zero and reported
+// through isConstant so they can be stored after the constant part is copied in
+Constant* CodeGen::buildConstantImage(ExpressionNode* init, Type* type, bool& isConstant) {
+    if (auto* list = dynamic_cast<InitializerListExprNode*>(init)) {
+        if (auto* arrayType = dyn_cast<ArrayType>(type)) {
+            uint64_t count = arrayType->getNumElements();
+            if (list->elements.size() > count)
+                throw std::runtime_error("Too many elements in array initializer");
+
+            Type* elemType = arrayType->getElementType();
+            std::vector<Constant*> elems;
+            for (uint64_t i = 0; i < count; i++) {
+                elems.push_back(
+                    i < list->elements.size()
+                        ? buildConstantImage(list->elements[i], elemType, isConstant)
+                        : Constant::getNullValue(elemType)
+                );
+            }
+            return ConstantArray::get(arrayType, elems);
+        }
+
+        if (auto* vectorType = dyn_cast<FixedVectorType>(type)) {
+            if (list->elements.size() > vectorType->getNumElements())
+                throw std::runtime_error("Too many elements in vector initializer");
+
+            Type* elemType = vectorType->getElementType();
+            std::vector<Constant*> lanes;
+            for (unsigned i = 0; i < vectorType->getNumElements(); i++) {
+                lanes.push_back(
+                    i < list->elements.size()
+                        ? buildConstantImage(list->elements[i], elemType, isConstant)
+                        : Constant::getNullValue(elemType)
+                );
+            }
+            return ConstantVector::get(lanes);
+        }
+
+        if (auto* structType = dyn_cast<StructType>(type)) {
+            StructInfo& info = m_structInfos[structType->getName().str()];
+            assert(!info.coldType && "Structs with initializers are never split");
+            if (list->elements.size() > info.fields.size())
+                throw std::runtime_error("Too many elements in struct initializer");
+
+            std::vector<Constant*> fields;
+            for (Type* fieldType : structType->elements()) {
+                fields.push_back(Constant::getNullValue(fieldType));
+            }
+            for (size_t i = 0; i < list->elements.size(); i++) {
+                unsigned index = info.fields[i].index;
+                fields[index] = buildConstantImage(
+                    list->elements[i], structType->getElementType(index), isConstant
+                );
+            }
+            return ConstantStruct::get(structType, fields);
+        }
+
+        // Braces around a scalar, `int x = {1}`
+        if (list->elements.size() == 1)
+            return buildConstantImage(list->elements[0], type, isConstant);
+        throw std::runtime_error("Invalid initializer list for scalar");
     }
 
-    m_scopeCtx->set(node->identifier, allocaInst);
-    m_scopeCtx->setType(node->identifier, type);
-    m_scopeCtx->setTypeNode(node->identifier, node->type);  // Track AST type for opaque pointers
+    if (auto* strNode = dynamic_cast<StringLiteralNode*>(init)) {
+        auto* arrayType = dyn_cast<ArrayType>(type);
+        if (arrayType && arrayType->getElementType()->isIntegerTy(8)) {
+            // Zero padded to the array length, the terminator is dropped when it does not fit
+            std::string bytes = strNode->value;
+            bytes.resize(arrayType->getNumElements(), '\0');
+            return ConstantDataArray::getString(*m_context, bytes, false);
+        }
+    }
+
+    if (Constant* leaf = foldConstantExpr(init, type))
+        return leaf;
+
+    isConstant = false;
+    return Constant::getNullValue(type);
+}
+
+void CodeGen::storeDynamicElements(ExpressionNode* init, Type* type, Value* ptr) {
+    auto* list = dynamic_cast<InitializerListExprNode*>(init);
+    if (!list) {
+        if (dynamic_cast<StringLiteralNode*>(init) && type->isArrayTy())
+            return;
+        if (foldConstantExpr(init, type) || copyAggregate(ptr, init, type))
+            return;
+        m_builder->CreateStore(coerceForStore(getValueOf(init), type), ptr);
+        return;
+    }
+
+    for (size_t i = 0; i < list->elements.size(); i++) {
+        if (auto* arrayType = dyn_cast<ArrayType>(type)) {
+            Value* elemPtr = m_builder->CreateConstInBoundsGEP2_64(arrayType, ptr, 0, i, "init_ptr");
+            storeDynamicElements(list->elements[i], arrayType->getElementType(), elemPtr);
+        } else if (auto* vectorType = dyn_cast<FixedVectorType>(type)) {
+            Type* elemType = vectorType->getElementType();
+            Value* lanePtr = m_builder->CreateConstInBoundsGEP1_64(elemType, ptr, i, "init_ptr");
+            storeDynamicElements(list->elements[i], elemType, lanePtr);
+        } else if (auto* structType = dyn_cast<StructType>(type)) {
+            unsigned index = m_structInfos[structType->getName().str()].fields[i].index;
+            Value* fieldPtr = m_builder->CreateStructGEP(structType, ptr, index, "init_ptr");
+            storeDynamicElements(list->elements[i], structType->getElementType(index), fieldPtr);
+        } else {
+            storeDynamicElements(list->elements[i], type, ptr);
+        }
+    }
+}
+
+GlobalVariable* CodeGen::createConstantGlobal(Constant* image, const std::string& name) {
+    GlobalVariable* global = new GlobalVariable(
+        *m_module, image->getType(), true, GlobalValue::PrivateLinkage, image, name
+    );
+    global->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+    global->setAlignment(m_module->getDataLayout().getPrefTypeAlign(image->getType()));
+    return global;
+}
+
+Value* CodeGen::emitAggregateInitializer(
+    const std::string& name, Type* type, ExpressionNode* init, bool isConst
+) {
+    bool isConstant = true;
+    Constant* image = buildConstantImage(init, type, isConstant);
+    std::string globalName =
+        m_builder->GetInsertBlock()->getParent()->getName().str() + "." + name;
+
+    // Never written, read the table directly from rodata instead of copying it on every call
+    if (isConstant && (isConst || (type->isArrayTy() && m_arrayUsage.isReadOnly(name)))) {
+        return createConstantGlobal(image, globalName);
+    }
+
+    const DataLayout& DL = m_module->getDataLayout();
+    AllocaInst* allocaInst = createEntryAlloca(type, name);
+    Align align = allocaInst->getAlign();
+
+    // Copy up to the last non-zero element from rodata and memset the zero tail
+    uint64_t count = 1;
+    uint64_t prefix = image->isNullValue() ? 0 : 1;
+    uint64_t elemSize = DL.getTypeAllocSize(type).getFixedValue();
+    Constant* prefixImage = image;
+    if (auto* arrayType = dyn_cast<ArrayType>(type)) {
+        count = arrayType->getNumElements();
+        elemSize = DL.getTypeAllocSize(arrayType->getElementType()).getFixedValue();
+        prefix = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!image->getAggregateElement(i)->isNullValue())
+                prefix = i + 1;
+        }
+
+        std::vector<Constant*> elems;
+        for (uint64_t i = 0; i < prefix; i++) {
+            elems.push_back(image->getAggregateElement(i));
+        }
+        prefixImage =
+            ConstantArray::get(ArrayType::get(arrayType->getElementType(), prefix), elems);
+    }
+
+    if (prefix > 0) {
+        GlobalVariable* global = createConstantGlobal(prefixImage, globalName + ".init");
+        m_builder->CreateMemCpy(
+            allocaInst, align, global, global->getAlign(), prefix * elemSize
+        );
+    }
+    if (prefix < count) {
+        Value* tail = allocaInst;
+        if (prefix > 0)
+            tail = m_builder->CreateConstInBoundsGEP2_64(type, allocaInst, 0, prefix, "zero_tail");
+        m_builder->CreateMemSet(
+            tail,
+            m_builder->getInt8(0),
+            (count - prefix) * elemSize,
+            commonAlignment(align, prefix * elemSize)
+        );
+    }
+
+    if (!isConstant)
+        storeDynamicElements(init, type, allocaInst);
+    return allocaInst;
 }
 
 void CodeGen::visitStructDeclaration(StructDeclNode* node) {
@@ -182,14 +752,129 @@ void CodeGen::visitStructDefinition(StructDeclNode* node) {
 
     std::vector<Type*> fieldTypes;
     StructInfo& info = m_structInfos[node->identifier];
+    if (m_structLayout == StructLayoutMode::Declared) {
+        for (VariableDeclNode* field : node->fields) {
+            Type* fieldType = field->type->accept(*this);
+            info.fields.push_back({static_cast<unsigned>(fieldTypes.size()), fieldType});
+            fieldTypes.push_back(fieldType);
+        }
+
+        type->setBody(fieldTypes);
+        return;
+    }
+
+    const DataLayout& DL = m_module->getDataLayout();
+    // Declaration order position and type of each field
+    std::vector<std::pair<unsigned, Type*>> hot;
+    std::vector<std::pair<unsigned, Type*>> cold;
+    std::vector<Type*> declaredTypes;
     for (VariableDeclNode* field : node->fields) {
         Type* fieldType = field->type->accept(*this);
+        hot.push_back({static_cast<unsigned>(declaredTypes.size()), fieldType});
+        declaredTypes.push_back(fieldType);
+    }
+    info.fields.resize(node->fields.size());
+
+    // Fields accessed less than a tenth as often as the hottest one go to the cold part
+    if (m_structLayout == StructLayoutMode::HotCold && m_structUsage.canSplit(node->identifier)) {
+        uint64_t maxHeat = 0;
+        for (VariableDeclNode* field : node->fields) {
+            maxHeat = std::max(maxHeat, m_structUsage.fieldHeat(node->identifier, field->identifier));
+        }
+        auto isCold = [&](const std::pair<unsigned, Type*>& field) {
+            const std::string& name = node->fields[field.first]->identifier;
+            return m_structUsage.fieldHeat(node->identifier, name) * 10 < maxHeat;
+        };
+        std::copy_if(hot.begin(), hot.end(), std::back_inserter(cold), isCold);
+        hot.erase(std::remove_if(hot.begin(), hot.end(), isCold), hot.end());
+    }
+
+    // Decreasing alignment leaves no padding between fields with power of two alignments
+    auto byAlignment = [&](const std::pair<unsigned, Type*>& a,
+                           const std::pair<unsigned, Type*>& b) {
+        return DL.getABITypeAlign(a.second) > DL.getABITypeAlign(b.second);
+    };
+    std::stable_sort(hot.begin(), hot.end(), byAlignment);
+    std::stable_sort(cold.begin(), cold.end(), byAlignment);
+
+    for (auto& [position, fieldType] : hot) {
+        info.fields[position] = {static_cast<unsigned>(fieldTypes.size()), fieldType};
         fieldTypes.push_back(fieldType);
-        unsigned fieldIndex = static_cast<unsigned>(fieldTypes.size() - 1);
-        info.fields[field->identifier] = {fieldIndex, fieldType};
+    }
+
+    if (!cold.empty()) {
+        std::vector<Type*> coldTypes;
+        for (auto& [position, fieldType] : cold) {
+            info.fields[position] = {static_cast<unsigned>(coldTypes.size()), fieldType, true};
+            coldTypes.push_back(fieldType);
+        }
+        info.coldType = StructType::create(*m_context, coldTypes, node->identifier + ".cold");
+        info.coldIndex = static_cast<unsigned>(fieldTypes.size());
+        fieldTypes.push_back(m_builder->getPtrTy());
     }
 
     type->setBody(fieldTypes);
+
+    uint64_t declaredSize =
+        DL.getTypeAllocSize(StructType::get(*m_context, declaredTypes)).getFixedValue();
+    std::cout << "struct " << node->identifier << ": sizeof " << declaredSize << " -> "
+              << DL.getTypeAllocSize(type).getFixedValue();
+    if (info.coldType) {
+        std::cout << " (+" << DL.getTypeAllocSize(info.coldType).getFixedValue() << " cold, "
+                  << cold.size()
+                  << " fields)";
+    }
+    std::cout << "\n";
+}
+
+AllocaInst* CodeGen::createEntryAlloca(Type* type, const Twine& name) {
+    // Always in the entry block, a declaration inside a loop must not grow the stack on every
+    // iteration and only static allocas are promoted to registers
+    BasicBlock& entry = m_builder->GetInsertBlock()->getParent()->getEntryBlock();
+    IRBuilder<> entryBuilder(&entry, entry.getFirstInsertionPt());
+    return entryBuilder.CreateAlloca(type, nullptr, name);
+}
+
+void CodeGen::initColdStorage(StructType* type, Value* ptr, uint64_t count, bool isArray) {
+    if (!type->hasName())
+        return;
+    auto it = m_structInfos.find(type->getName().str());
+    if (it == m_structInfos.end() || !it->second.coldType)
+        return;
+    StructInfo& info = it->second;
+
+    if (!isArray) {
+        AllocaInst* cold = createEntryAlloca(info.coldType, "cold");
+        m_builder->CreateStore(cold, m_builder->CreateStructGEP(type, ptr, info.coldIndex));
+        return;
+    }
+
+    // Every element points to its own entry in a parallel array of cold parts
+    ArrayType* hotArrayType = ArrayType::get(type, count);
+    ArrayType* coldArrayType = ArrayType::get(info.coldType, count);
+    AllocaInst* cold = createEntryAlloca(coldArrayType, "cold");
+
+    Function* func = m_builder->GetInsertBlock()->getParent();
+    BasicBlock* preheaderBB = m_builder->GetInsertBlock();
+    BasicBlock* loopBB = BasicBlock::Create(*m_context, "cold.init");
+    BasicBlock* endBB = BasicBlock::Create(*m_context, "cold.init.end");
+    m_builder->CreateBr(loopBB);
+
+    func->insert(func->end(), loopBB);
+    m_builder->SetInsertPoint(loopBB);
+    PHINode* idx = m_builder->CreatePHI(m_builder->getInt64Ty(), 2, "idx");
+    idx->addIncoming(m_builder->getInt64(0), preheaderBB);
+    Value* hotElem =
+        m_builder->CreateInBoundsGEP(hotArrayType, ptr, {m_builder->getInt64(0), idx});
+    Value* coldElem =
+        m_builder->CreateInBoundsGEP(coldArrayType, cold, {m_builder->getInt64(0), idx});
+    m_builder->CreateStore(coldElem, m_builder->CreateStructGEP(type, hotElem, info.coldIndex));
+    Value* next = m_builder->CreateAdd(idx, m_builder->getInt64(1), "idx.next");
+    idx->addIncoming(next, loopBB);
+    m_builder->CreateCondBr(m_builder->CreateICmpULT(next, m_builder->getInt64(count)), loopBB, endBB);
+
+    func->insert(func->end(), endBB);
+    m_builder->SetInsertPoint(endBB);
 }
 
 void CodeGen::visitFunctionPtrDeclaration(FunctionPtrDeclNode* node) {
@@ -198,61 +883,210 @@ void CodeGen::visitFunctionPtrDeclaration(FunctionPtrDeclNode* node) {
     for (auto* param : node->parameters) {
         paramTypes.push_back(param->type->accept(*this));
     }
-    FunctionType* funcType = FunctionType::get(returnType, paramTypes, false);
-
-    // For opaque pointers, just store the FunctionType (not PointerType)
-    // When creating variables with this type, they'll be pointers automatically
-    m_namedTypes[node->identifier] = funcType;
+    // Variables of this type are opaque pointers, calls through them need the signature
+    m_functionPtrTypes[node->identifier] = FunctionType::get(returnType, paramTypes, false);
+    m_namedTypes[node->identifier] = m_builder->getPtrTy();
 }
 
 // ==== Statement visitors ====
 void CodeGen::visitBlockStatement(BlockStatementNode* node) {
     for (auto* stmt : node->body) {
+        emitLocation(stmt->location);
         stmt->accept(*this);
     }
 }
 
 Value* CodeGen::convertToBoolean(Value* condValue) {
-    if (condValue->getType()->isIntegerTy()) {
+    if (condValue->getType()->isIntegerTy(1)) {
+        // Already a boolean (i1), e.g. result of a comparison
+        return condValue;
+    } else if (condValue->getType()->isIntegerTy()) {
         // Integer: compare with 0
         return m_builder->CreateICmpNE(
-            condValue, ConstantInt::get(condValue->getType(), 0), "ifcond"
+            condValue, ConstantInt::get(condValue->getType(), 0), "tobool"
         );
     } else if (condValue->getType()->isFloatingPointTy()) {
-        // Float: compare with 0.0
-        return m_builder->CreateFCmpONE(
-            condValue, ConstantFP::get(condValue->getType(), 0.0), "ifcond"
+        // Float: compare with 0.0, unordered so NaN is true as in C
+        return m_builder->CreateFCmpUNE(
+            condValue, ConstantFP::get(condValue->getType(), 0.0), "tobool"
         );
     } else if (condValue->getType()->isPointerTy()) {
         // Pointer: compare with null
         return m_builder->CreateICmpNE(
-            condValue, ConstantPointerNull::get(cast<PointerType>(condValue->getType())), "ifcond"
+            condValue, ConstantPointerNull::get(cast<PointerType>(condValue->getType())), "tobool"
         );
-    } else {
-        // Already a boolean (i1)
-        return condValue;
     }
     return nullptr;
 }
 
-void CodeGen::visitIfStatement(IfStatementNode* node) {
-    Value* condValue = getValueOf(node->condition);
+Value* CodeGen::coerceForStore(Value* value, Type* destType) {
+    Type* srcType = value->getType();
+    if (srcType == destType)
+        return value;
+
+    // A scalar stored to a vector fills every lane
+    auto* vectorType = dyn_cast<VectorType>(destType);
+    if (vectorType && !srcType->isVectorTy()) {
+        Value* lane = coerceForStore(value, vectorType->getElementType());
+        return m_builder->CreateVectorSplat(vectorType->getElementCount(), lane, "splat");
+    }
+
+    // Booleans (comparisons, && and ||) are 0/1 so they must be zero extended. Vectors of the
+    // same length are converted lane by lane
+    bool isBoolean = srcType->isIntOrIntVectorTy(1);
+    bool srcIsInt = srcType->isIntOrIntVectorTy(), destIsInt = destType->isIntOrIntVectorTy();
+    if (srcIsInt && destType->isFPOrFPVectorTy()) {
+        return isBoolean ? m_builder->CreateUIToFP(value, destType, "conv")
+                         : m_builder->CreateSIToFP(value, destType, "conv");
+    }
+    // double to int truncates toward zero like C
+    if (srcType->isFPOrFPVectorTy() && destIsInt)
+        return m_builder->CreateFPToSI(value, destType, "conv");
+    if (!srcIsInt || !destIsInt)
+        return value;
+
+    if (isBoolean)
+        return m_builder->CreateZExt(value, destType, "conv");
+    return m_builder->CreateSExtOrTrunc(value, destType, "conv");
+}
+
+// Structs in memory are copied with llvm.memcpy, a first-class load and store of the whole
+// struct is split into one move per field. False when source has no address, e.g. a call result
+bool CodeGen::copyAggregate(Value* dest, ExpressionNode* source, Type* type) {
+    if (!type->isStructTy() || !source->isLValue)
+        return false;
+    Value* src = getAddressOf(source);
+    const DataLayout& DL = m_module->getDataLayout();
+    Align align = DL.getABITypeAlign(type);
+    m_builder->CreateMemCpy(dest, align, src, align, DL.getTypeStoreSize(type).getFixedValue());
+    return true;
+}
+
+// Conditions that are cheap enough and cannot trap or write memory, so both sides of && and ||
+// can be evaluated unconditionally without changing program behaviour
+static bool isCheapAndPure(ExpressionNode* node, int& budget) {
+    if (--budget < 0)
+        return false;
+
+    if (dynamic_cast<IntegerLiteralNode*>(node) || dynamic_cast<CharacterLiteralNode*>(node) ||
+        dynamic_cast<DoubleLiteralNode*>(node) || dynamic_cast<IdentifierExprNode*>(node)) {
+        return true;
+    }
+    if (auto* memberNode = dynamic_cast<MemberExprNode*>(node)) {
+        // obj.field on a local is a plain load, obj->field may dereference null
+        return !memberNode->arrowAccess && isCheapAndPure(memberNode->object, budget);
+    }
+    if (auto* unaryNode = dynamic_cast<UnaryExprNode*>(node)) {
+        if (unaryNode->op == "-" || unaryNode->op == "!" || unaryNode->op == "~")
+            return isCheapAndPure(unaryNode->operand, budget);
+        return false;
+    }
+    if (auto* binaryNode = dynamic_cast<BinaryExprNode*>(node)) {
+        // division can trap, assignment has side effects
+        if (binaryNode->op == "=" || binaryNode->op == "/" || binaryNode->op == "%")
+            return false;
+        return isCheapAndPure(binaryNode->left, budget) &&
+               isCheapAndPure(binaryNode->right, budget);
+    }
+    return false;
+}
+
+static bool isLogicalOp(ExpressionNode* node) {
+    auto* binaryNode = dynamic_cast<BinaryExprNode*>(node);
+    return binaryNode && (binaryNode->op == "&&" || binaryNode->op == "||");
+}
+
+bool CodeGen::isBranchlessLogical(BinaryExprNode* node) {
+    int budget = 8;
+    return isCheapAndPure(node->left, budget) && isCheapAndPure(node->right, budget);
+}
+
+void CodeGen::emitConditionalBranch(ExpressionNode* cond, BasicBlock* trueBB, BasicBlock* falseBB) {
+    emitLocation(cond->location);
+    if (isLogicalOp(cond) && !isBranchlessLogical(static_cast<BinaryExprNode*>(cond))) {
+        auto* binaryNode = static_cast<BinaryExprNode*>(cond);
+        bool isAnd = binaryNode->op == "&&";
+
+        // Jump straight to the target when the left side decides the result
+        Function* func = m_builder->GetInsertBlock()->getParent();
+        BasicBlock* rhsBB = BasicBlock::Create(*m_context, isAnd ? "land.rhs" : "lor.rhs");
+        if (isAnd) {
+            emitConditionalBranch(binaryNode->left, rhsBB, falseBB);
+        } else {
+            emitConditionalBranch(binaryNode->left, trueBB, rhsBB);
+        }
+
+        func->insert(func->end(), rhsBB);
+        m_builder->SetInsertPoint(rhsBB);
+        emitConditionalBranch(binaryNode->right, trueBB, falseBB);
+        return;
+    }
+
+    if (auto* unaryNode = dynamic_cast<UnaryExprNode*>(cond)) {
+        if (unaryNode->op == "!" && isLogicalOp(unaryNode->operand)) {
+            emitConditionalBranch(unaryNode->operand, falseBB, trueBB);
+            return;
+        }
+    }
+
+    Value* condValue = getValueOf(cond);
     assert(condValue != nullptr && "Condition is nullptr");
-    // Convert condition to boolean (i1)
     Value* condition = convertToBoolean(condValue);
     assert(condition != nullptr && "Condition is nullptr");
+    m_builder->CreateCondBr(condition, trueBB, falseBB);
+}
+
+Value* CodeGen::visitLogicalExpr(BinaryExprNode* node) {
+    bool isAnd = node->op == "&&";
+
+    // Both operands are side-effect free, evaluate them and combine without branching
+    if (isBranchlessLogical(node)) {
+        Value* left = convertToBoolean(getValueOf(node->left));
+        Value* right = convertToBoolean(getValueOf(node->right));
+        return isAnd ? m_builder->CreateAnd(left, right, "land")
+                     : m_builder->CreateOr(left, right, "lor");
+    }
 
+    Function* func = m_builder->GetInsertBlock()->getParent();
+    BasicBlock* rhsBB = BasicBlock::Create(*m_context, isAnd ? "land.rhs" : "lor.rhs");
+    BasicBlock* endBB = BasicBlock::Create(*m_context, isAnd ? "land.end" : "lor.end");
+
+    Value* left = convertToBoolean(getValueOf(node->left));
+    BasicBlock* lhsBB = m_builder->GetInsertBlock();
+    if (isAnd) {
+        m_builder->CreateCondBr(left, rhsBB, endBB);
+    } else {
+        m_builder->CreateCondBr(left, endBB, rhsBB);
+    }
+
+    func->insert(func->end(), rhsBB);
+    m_builder->SetInsertPoint(rhsBB);
+    Value* right = convertToBoolean(getValueOf(node->right));
+    // rhs may have emitted its own blocks (nested && / ||)
+    BasicBlock* rhsEndBB = m_builder->GetInsertBlock();
+    m_builder->CreateBr(endBB);
+
+    func->insert(func->end(), endBB);
+    m_builder->SetInsertPoint(endBB);
+    PHINode* phi = m_builder->CreatePHI(m_builder->getInt1Ty(), 2, isAnd ? "land" : "lor");
+    phi->addIncoming(m_builder->getInt1(!isAnd), lhsBB);
+    phi->addIncoming(right, rhsEndBB);
+    return phi;
+}
+
+void CodeGen::visitIfStatement(IfStatementNode* node) {
     Function* func = m_builder->GetInsertBlock()->getParent();
 
     // Create basic blocks
-    BasicBlock* thenBB = BasicBlock::Create(*m_context, "if.then", func);
+    BasicBlock* thenBB = BasicBlock::Create(*m_context, "if.then");
     BasicBlock* mergeBB = BasicBlock::Create(*m_context, "if.end");
     BasicBlock* elseBB = node->elseBody ? BasicBlock::Create(*m_context, "if.else") : mergeBB;
 
     // Branch based on condition
-    m_builder->CreateCondBr(condition, thenBB, elseBB);
+    emitConditionalBranch(node->condition, thenBB, elseBB);
 
     // Emit then block
+    func->insert(func->end(), thenBB);
     m_builder->SetInsertPoint(thenBB);
     node->thenBody->accept(*this);
     if (!m_builder->GetInsertBlock()->getTerminator()) {
@@ -274,32 +1108,112 @@ void CodeGen::visitIfStatement(IfStatementNode* node) {
     m_builder->SetInsertPoint(mergeBB);
 }
 
+// Loops without a constant controlling expression may be assumed to terminate (C11 6.8.5p6)
+static bool loopMustProgress(ExpressionNode* condition) {
+    return condition && !dynamic_cast<IntegerLiteralNode*>(condition) &&
+           !dynamic_cast<CharacterLiteralNode*>(condition);
+}
+
+MDNode* CodeGen::createLoopMetadata(const LoopAttributes& attributes, bool mustProgress) {
+    // First operand is a self reference filled in below, so the loop ID stays distinct
+    SmallVector<Metadata*, 8> ops = {nullptr};
+
+    auto addFlag = [&](const char* name) {
+        ops.push_back(MDNode::get(*m_context, MDString::get(*m_context, name)));
+    };
+    auto addValue = [&](const char* name, Constant* value) {
+        ops.push_back(MDNode::get(
+            *m_context, {MDString::get(*m_context, name), ConstantAsMetadata::get(value)}
+        ));
+    };
+
+    if (mustProgress)
+        addFlag("llvm.loop.mustprogress");
+
+    if (attributes.unrollCount == 1) {
+        addFlag("llvm.loop.unroll.disable");
+    } else if (attributes.unrollCount > 1) {
+        addValue("llvm.loop.unroll.count", m_builder->getInt32(attributes.unrollCount));
+    }
+
+    if (attributes.vectorizeWidth > 0) {
+        addValue("llvm.loop.vectorize.width", m_builder->getInt32(attributes.vectorizeWidth));
+        addValue("llvm.loop.vectorize.enable", m_builder->getInt1(attributes.vectorizeWidth > 1));
+    }
+    if (attributes.interleaveCount > 0)
+        addValue("llvm.loop.interleave.count", m_builder->getInt32(attributes.interleaveCount));
+    if (attributes.distribute)
+        addValue("llvm.loop.distribute.enable", m_builder->getInt1(true));
+
+    if (ops.size() == 1)
+        return nullptr;
+
+    MDNode* loopID = MDNode::getDistinct(*m_context, ops);
+    loopID->replaceOperandWith(0, loopID);
+    return loopID;
+}
+
+void CodeGen::emitLoopLatch(
+    ExpressionNode* condition,
+    BasicBlock* headerBB,
+    BasicBlock* exitBB,
+    const LoopAttributes& attributes
+) {
+    BasicBlock* latchBB = m_builder->GetInsertBlock();
+    if (condition) {
+        emitConditionalBranch(condition, headerBB, exitBB);
+    } else {
+        m_builder->CreateBr(headerBB);
+    }
+
+    MDNode* loopID = createLoopMetadata(attributes, loopMustProgress(condition));
+    if (!loopID)
+        return;
+
+    // A short-circuit condition can split the latch into several blocks, tag every backedge
+    Function* func = latchBB->getParent();
+    for (auto it = latchBB->getIterator(); it != func->end(); ++it) {
+        Instruction* term = it->getTerminator();
+        if (!term)
+            continue;
+        for (BasicBlock* succ : successors(term)) {
+            if (succ == headerBB) {
+                term->setMetadata(LLVMContext::MD_loop, loopID);
+                break;
+            }
+        }
+    }
+}
+
+// Loops are emitted rotated: a guard in front of the loop and the condition at the bottom,
+// so the body is the header and the latch is a conditional branch back to it
 void CodeGen::visitWhileStatement(WhileStatementNode* node) {
     Function* func = m_builder->GetInsertBlock()->getParent();
 
-    BasicBlock* condBB = BasicBlock::Create(*m_context, "while.cond", func);
     BasicBlock* bodyBB = BasicBlock::Create(*m_context, "while.body");
+    BasicBlock* condBB = BasicBlock::Create(*m_context, "while.cond");
     BasicBlock* endBB = BasicBlock::Create(*m_context, "while.end");
 
-    m_builder->CreateBr(condBB);
-    m_builder->SetInsertPoint(condBB);
+    // Guard, skip the loop entirely if the condition is false on entry
     if (node->condition) {
-        Value* condValue = getValueOf(node->condition);
-        assert(condValue != nullptr && "Condition is nullptr");
-        Value* condition = convertToBoolean(condValue);
-        assert(condition != nullptr && "Condition is nullptr");
-        m_builder->CreateCondBr(condition, bodyBB, endBB);
+        emitConditionalBranch(node->condition, bodyBB, endBB);
     } else {
         m_builder->CreateBr(bodyBB);
     }
 
     func->insert(func->end(), bodyBB);
     m_builder->SetInsertPoint(bodyBB);
+    m_jumpTargets.push_back({endBB, condBB});
     node->loopBody->accept(*this);
+    m_jumpTargets.pop_back();
     if (!m_builder->GetInsertBlock()->getTerminator()) {
         m_builder->CreateBr(condBB);
     }
 
+    func->insert(func->end(), condBB);
+    m_builder->SetInsertPoint(condBB);
+    emitLoopLatch(node->condition, bodyBB, endBB, node->attributes);
+
     func->insert(func->end(), endBB);
     m_builder->SetInsertPoint(endBB);
 }
@@ -314,22 +1228,16 @@ void CodeGen::visitDoWhileStatement(DoWhileStatementNode* node) {
     m_builder->CreateBr(bodyBB);
     func->insert(func->end(), bodyBB);
     m_builder->SetInsertPoint(bodyBB);
+    m_jumpTargets.push_back({endBB, condBB});
     node->loopBody->accept(*this);
+    m_jumpTargets.pop_back();
     if (!m_builder->GetInsertBlock()->getTerminator()) {
         m_builder->CreateBr(condBB);
     }
 
     func->insert(func->end(), condBB);
     m_builder->SetInsertPoint(condBB);
-    if (node->condition) {
-        Value* condValue = getValueOf(node->condition);
-        assert(condValue != nullptr && "Condition is nullptr");
-        Value* condition = convertToBoolean(condValue);
-        assert(condition != nullptr && "Condition is nullptr");
-        m_builder->CreateCondBr(condition, bodyBB, endBB);
-    } else {
-        m_builder->CreateBr(bodyBB);
-    }
+    emitLoopLatch(node->condition, bodyBB, endBB, node->attributes);
 
     func->insert(func->end(), endBB);
     m_builder->SetInsertPoint(endBB);
@@ -344,54 +1252,276 @@ void CodeGen::visitForStatement(ForStatementNode* node) {
     m_builder->SetInsertPoint(preheaderBB);
 
     if (std::holds_alternative<ExpressionNode*>(node->init)) {
-        std::get<ExpressionNode*>(node->init)->accept(*this);
+        if (auto* initExpr = std::get<ExpressionNode*>(node->init))
+            initExpr->accept(*this);
     } else {
         std::get<DeclarationNode*>(node->init)->accept(*this);
     }
 
 
-    BasicBlock* condBB = BasicBlock::Create(*m_context, "for.cond", func);
     BasicBlock* bodyBB = BasicBlock::Create(*m_context, "for.body");
     BasicBlock* incBB = BasicBlock::Create(*m_context, "for.increment");
     BasicBlock* endBB = BasicBlock::Create(*m_context, "for.end");
 
-    m_builder->CreateBr(condBB);
-    m_builder->SetInsertPoint(condBB);
+    // Guard, skip the loop entirely if the condition is false on entry
     if (node->condition) {
-        Value* condValue = getValueOf(node->condition);
-        assert(condValue != nullptr && "Condition is nullptr");
-        Value* condition = convertToBoolean(condValue);
-        assert(condition != nullptr && "Condition is nullptr");
-        m_builder->CreateCondBr(condition, bodyBB, endBB);
+        emitConditionalBranch(node->condition, bodyBB, endBB);
     } else {
         m_builder->CreateBr(bodyBB);
     }
 
     func->insert(func->end(), bodyBB);
     m_builder->SetInsertPoint(bodyBB);
+    m_jumpTargets.push_back({endBB, incBB});
     node->body->accept(*this);
+    m_jumpTargets.pop_back();
     if (!m_builder->GetInsertBlock()->getTerminator()) {
         m_builder->CreateBr(incBB);
     }
 
+    // Increment and condition share the latch
     func->insert(func->end(), incBB);
     m_builder->SetInsertPoint(incBB);
     if (node->update) {
         node->update->accept(*this);
     }
-    m_builder->CreateBr(condBB);
+    emitLoopLatch(node->condition, bodyBB, endBB, node->attributes);
+
+    func->insert(func->end(), endBB);
+    m_builder->SetInsertPoint(endBB);
+}
+
+// The body becomes <function>.parallel_for(captures, begin, end), running iterations
+// [begin, end). __parallel_for in the runtime calls it on chunks of the iteration space from
+// every thread of its pool, the calling thread included, and returns when all are done
+void CodeGen::visitParallelForStatement(ParallelForStatementNode* node) {
+    auto* counter = static_cast<VariableDeclNode*>(std::get<DeclarationNode*>(node->init));
+    auto* condition = static_cast<BinaryExprNode*>(node->condition);
+    emitLocation(node->location);
+
+    // Bounds are evaluated once, in 64 bits so that i <= INT_MAX ends
+    Type* int32Ty = m_builder->getInt32Ty();
+    Type* int64Ty = m_builder->getInt64Ty();
+    Value* begin = coerceForStore(getValueOf(counter->initializer), int32Ty);
+    begin = m_builder->CreateSExt(begin, int64Ty, "parallel.begin");
+    Value* end = coerceForStore(getValueOf(condition->right), int32Ty);
+    end = m_builder->CreateSExt(end, int64Ty, "parallel.end");
+    if (condition->op == "<=")
+        end = m_builder->CreateNSWAdd(end, m_builder->getInt64(1), "parallel.end");
+
+    // Locals the body uses go into a struct, by value when the body never changes them so
+    // each thread has its own copy to keep in registers, otherwise as a pointer every thread
+    // shares. Globals and functions are used directly
+    LoopCaptures usage = analyzeLoopCaptures(node->body);
+    std::vector<LoopCapture> captures;
+    std::vector<Value*> addresses;
+    std::vector<Type*> fieldTypes;
+    for (const std::string& name : usage.used) {
+        Value* address = m_scopeCtx->get(name);
+        if (name == counter->identifier || !address || isa<GlobalValue>(address))
+            continue;
+        Type* type = m_scopeCtx->getType(name);
+        bool byValue = usage.isReadOnly(name) && !type->isAggregateType();
+        captures.push_back({name, type, byValue});
+        addresses.push_back(address);
+        fieldTypes.push_back(byValue ? type : m_builder->getPtrTy());
+    }
+    StructType* capturesType = StructType::get(*m_context, fieldTypes);
+    AllocaInst* capturesPtr = createEntryAlloca(capturesType, "captures");
+    for (size_t i = 0; i < captures.size(); i++) {
+        Value* value = addresses[i];
+        if (captures[i].byValue)
+            value = m_builder->CreateLoad(captures[i].type, value, captures[i].name);
+        m_builder->CreateStore(value, m_builder->CreateStructGEP(capturesType, capturesPtr, i));
+    }
+
+    Function* body = outlineParallelBody(node, capturesType, captures);
+    FunctionCallee parallelFor = m_module->getOrInsertFunction(
+        "__parallel_for",
+        m_builder->getVoidTy(),
+        m_builder->getPtrTy(),
+        m_builder->getPtrTy(),
+        int64Ty,
+        int64Ty,
+        int32Ty,
+        int64Ty
+    );
+    m_builder->CreateCall(
+        parallelFor,
+        {body, capturesPtr, begin, end, m_builder->getInt32(node->schedule),
+         m_builder->getInt64(node->chunk)}
+    );
+}
+
+Function* CodeGen::outlineParallelBody(
+    ParallelForStatementNode* node,
+    StructType* capturesType,
+    const std::vector<LoopCapture>& captures
+) {
+    Function* parent = m_builder->GetInsertBlock()->getParent();
+    Type* int64Ty = m_builder->getInt64Ty();
+    FunctionType* type = FunctionType::get(
+        m_builder->getVoidTy(), {m_builder->getPtrTy(), int64Ty, int64Ty}, false
+    );
+    Function* function = Function::Create(
+        type, GlobalValue::InternalLinkage, parent->getName() + ".parallel_for", m_module.get()
+    );
+    function->addFnAttr(Attribute::NoUnwind);
+    for (const char* kind : {"target-cpu", "target-features"}) {
+        if (parent->hasFnAttribute(kind))
+            function->addFnAttr(parent->getFnAttribute(kind));
+    }
+    Argument* capturesArg = function->getArg(0);
+    Argument* beginArg = function->getArg(1);
+    Argument* endArg = function->getArg(2);
+    capturesArg->setName("captures");
+    beginArg->setName("begin");
+    endArg->setName("end");
+
+    // Generated in between the enclosing function's code, which continues afterwards
+    IRBuilderBase::InsertPointGuard insertPoint(*m_builder);
+    std::vector<JumpTargets> jumpTargets = std::move(m_jumpTargets);
+    m_jumpTargets.clear();
+    DISubprogram* debugScope = m_debugScope;
+    m_builder->SetCurrentDebugLocation(DebugLoc());
+    createDebugScope(function, node->location.line);
+
+    BasicBlock* entry = BasicBlock::Create(*m_context, "entry", function);
+    m_builder->SetInsertPoint(entry);
+    emitLocation(node->location);
+
+    m_scopeCtx = Context::create(std::move(m_scopeCtx));
+    for (size_t i = 0; i < captures.size(); i++) {
+        const LoopCapture& capture = captures[i];
+        Value* field = m_builder->CreateStructGEP(capturesType, capturesArg, i);
+        if (capture.byValue) {
+            AllocaInst* copy = createEntryAlloca(capture.type, capture.name);
+            m_builder->CreateStore(m_builder->CreateLoad(capture.type, field), copy);
+            m_scopeCtx->set(capture.name, copy);
+        } else {
+            m_scopeCtx->set(
+                capture.name, m_builder->CreateLoad(m_builder->getPtrTy(), field, capture.name)
+            );
+        }
+        m_scopeCtx->setType(capture.name, capture.type);
+    }
+    auto* counterDecl = static_cast<VariableDeclNode*>(std::get<DeclarationNode*>(node->init));
+    AllocaInst* counter = createEntryAlloca(m_builder->getInt32Ty(), counterDecl->identifier);
+    m_scopeCtx->set(counterDecl->identifier, counter);
+    m_scopeCtx->setType(counterDecl->identifier, m_builder->getInt32Ty());
+
+    // The runtime never passes an empty chunk, so there is no guard
+    BasicBlock* bodyBB = BasicBlock::Create(*m_context, "parallel.body");
+    BasicBlock* incBB = BasicBlock::Create(*m_context, "parallel.increment");
+    BasicBlock* endBB = BasicBlock::Create(*m_context, "parallel.end");
+    m_builder->CreateBr(bodyBB);
+
+    function->insert(function->end(), bodyBB);
+    m_builder->SetInsertPoint(bodyBB);
+    PHINode* index = m_builder->CreatePHI(int64Ty, 2, "index");
+    index->addIncoming(beginArg, entry);
+    m_builder->CreateStore(m_builder->CreateTrunc(index, m_builder->getInt32Ty()), counter);
+    m_jumpTargets.push_back({endBB, incBB});
+    node->body->accept(*this);
+    m_jumpTargets.pop_back();
+    if (!m_builder->GetInsertBlock()->getTerminator())
+        m_builder->CreateBr(incBB);
+
+    function->insert(function->end(), incBB);
+    m_builder->SetInsertPoint(incBB);
+    Value* next = m_builder->CreateNSWAdd(index, m_builder->getInt64(1), "index.next");
+    index->addIncoming(next, incBB);
+    BranchInst* latch =
+        m_builder->CreateCondBr(m_builder->CreateICmpSLT(next, endArg), bodyBB, endBB);
+    if (MDNode* loopID = createLoopMetadata(node->attributes, true))
+        latch->setMetadata(LLVMContext::MD_loop, loopID);
+
+    function->insert(function->end(), endBB);
+    m_builder->SetInsertPoint(endBB);
+    m_builder->CreateRetVoid();
+
+    m_scopeCtx = m_scopeCtx->destroy();
+    m_jumpTargets = std::move(jumpTargets);
+    m_debugScope = debugScope;
+    return function;
+}
+
+void CodeGen::visitSwitchStatement(SwitchStatementNode* node) {
+    Function* func = m_builder->GetInsertBlock()->getParent();
+
+    Value* condition = coerceForStore(getValueOf(node->condition), m_builder->getInt32Ty());
+    BasicBlock* endBB = BasicBlock::Create(*m_context, "switch.end");
+    // Without a default case values matching no case skip the switch
+    SwitchInst* switchInst = m_builder->CreateSwitch(condition, endBB, node->cases.size());
+
+    BasicBlock* continueBB = m_jumpTargets.empty() ? nullptr : m_jumpTargets.back().continueBB;
+    m_jumpTargets.push_back({endBB, continueBB});
+
+    // Bodies are laid out in source order, default included, a case without break falls
+    // through into the next one
+    for (auto* caseNode : node->cases) {
+        BasicBlock* caseBB = BasicBlock::Create(
+            *m_context, caseNode->isDefault() ? "switch.default" : "switch.case", func
+        );
+        if (!m_builder->GetInsertBlock()->getTerminator()) {
+            m_builder->CreateBr(caseBB);
+        }
+        if (caseNode->isDefault())
+            switchInst->setDefaultDest(caseBB);
+        else
+            switchInst->addCase(cast<ConstantInt>(visitIntegerLiteral(caseNode->value)), caseBB);
+        m_builder->SetInsertPoint(caseBB);
+        visitCaseStatement(caseNode);
+    }
+    m_jumpTargets.pop_back();
 
+    if (!m_builder->GetInsertBlock()->getTerminator()) {
+        m_builder->CreateBr(endBB);
+    }
     func->insert(func->end(), endBB);
     m_builder->SetInsertPoint(endBB);
 }
 
+void CodeGen::visitCaseStatement(CaseStatementNode* node) {
+    node->body->accept(*this);
+}
+
+void CodeGen::visitBreakStatement(BreakStatementNode* node) {
+    if (m_jumpTargets.empty()) {
+        throw std::runtime_error("break outside of a loop or switch");
+    }
+    m_builder->CreateBr(m_jumpTargets.back().breakBB);
+    startUnreachableBlock();
+}
+
+void CodeGen::visitContinueStatement(ContinueStatementNode* node) {
+    if (m_jumpTargets.empty() || !m_jumpTargets.back().continueBB) {
+        throw std::runtime_error("continue outside of a loop");
+    }
+    m_builder->CreateBr(m_jumpTargets.back().continueBB);
+    startUnreachableBlock();
+}
+
+// Statements after a jump still need a block to go into, it has no predecessors and is
+// dropped by the first simplifycfg
+void CodeGen::startUnreachableBlock() {
+    Function* func = m_builder->GetInsertBlock()->getParent();
+    m_builder->SetInsertPoint(BasicBlock::Create(*m_context, "unreachable", func));
+}
+
 void CodeGen::visitReturnStatement(ReturnStatementNode* node) {
-    if (node->returnValue) {
-        Value* retVal = getValueOf(node->returnValue);
-        m_builder->CreateRet(retVal);
-    } else {
+    if (!node->returnValue) {
         m_builder->CreateRetVoid();
+        return;
     }
+
+    Value* retVal = getValueOf(node->returnValue);
+    // Promoted indirect calls return a phi, their direct calls aren't in tail position
+    auto* call = dyn_cast<CallInst>(retVal);
+    if (call && dynamic_cast<CallExprNode*>(node->returnValue))
+        m_tailCalls.push_back(call);
+    Type* returnType = m_builder->GetInsertBlock()->getParent()->getReturnType();
+    m_builder->CreateRet(coerceForStore(retVal, returnType));
 }
 
 // ==== Expression visitors ====
@@ -427,40 +1557,29 @@ Value* CodeGen::getValueOf(ExpressionNode* node) {
     if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node)) {
         Value* ptr = m_scopeCtx->get(idNode->name);
         if (!ptr) {
+            // A function name used as a value is its address
+            if (Function* func = m_module->getFunction(idNode->name))
+                return func;
             std::cerr << "Unknown variable name: " << idNode->name << "\n";
             return nullptr;
         }
         Type* type = m_scopeCtx->getType(idNode->name);
         return m_builder->CreateLoad(type, ptr, idNode->name);
     }
+    // Member and element types were resolved by analyzeSemantics
     if (auto* memberNode = dynamic_cast<MemberExprNode*>(node)) {
         Value* ptr = visitMemberExpr(memberNode);
-        // Get field type from struct info
-        IdentifierExprNode* objId = dynamic_cast<IdentifierExprNode*>(memberNode->object);
-        TypeNode* objTypeNode = m_scopeCtx->getTypeNode(objId->name);
-
-        StructType* structType = nullptr;
-        if (memberNode->arrowAccess) {
-            PointerTypeNode* ptrType = dynamic_cast<PointerTypeNode*>(objTypeNode);
-            structType = cast<StructType>(ptrType->baseType->accept(*this));
-        } else {
-            structType = cast<StructType>(objTypeNode->accept(*this));
-        }
-
-        std::string structName = structType->getName().str();
-        Type* fieldType = m_structInfos[structName].fields[memberNode->member].second;
-        return m_builder->CreateLoad(fieldType, ptr, "member");
+        return m_builder->CreateLoad(node->resolvedType->accept(*this), ptr, "member");
     }
 
     if (auto* indexNode = dynamic_cast<IndexExprNode*>(node)) {
+        // A vector lane is read from the value, which needn't be in memory
+        if (indexNode->array->resolvedType->accept(*this)->isVectorTy()) {
+            Value* vector = getValueOf(indexNode->array);
+            return m_builder->CreateExtractElement(vector, getValueOf(indexNode->index), "lane");
+        }
         Value* ptr = visitIndexExpr(indexNode);
-        // Get element type from array type
-        IdentifierExprNode* arrId = dynamic_cast<IdentifierExprNode*>(indexNode->array);
-        Type* arrayType = m_scopeCtx->getType(arrId->name);
-
-        // arrayType is [N x T], get T
-        Type* elemType = cast<ArrayType>(arrayType)->getElementType();
-        return m_builder->CreateLoad(elemType, ptr, "elem");
+        return m_builder->CreateLoad(node->resolvedType->accept(*this), ptr, "elem");
     }
 
     // For everything else (literals, expressions, calls, etc.)
@@ -470,58 +1589,121 @@ Value* CodeGen::getValueOf(ExpressionNode* node) {
 Value* CodeGen::visitBinaryExpr(BinaryExprNode* node) {
     if (node->op == "=") {
         Value* leftAddr = getAddressOf(node->left);  // Get address for l-value
-        Value* rightVal = getValueOf(node->right);   // Get value for r-value
+        Type* leftType = node->left->resolvedType->accept(*this);
+        // The value of a struct assignment is reloaded from the destination, dead when unused
+        if (copyAggregate(leftAddr, node->right, leftType))
+            return m_builder->CreateLoad(leftType, leftAddr, "assign");
+        Value* rightVal = getValueOf(node->right);  // Get value for r-value
+        rightVal = coerceForStore(rightVal, leftType);
         m_builder->CreateStore(rightVal, leftAddr);
         return rightVal;
     }
 
+    // Right side is only evaluated when needed
+    if (node->op == "&&" || node->op == "||") {
+        return visitLogicalExpr(node);
+    }
+
     // Both sides as r-values
     Value* left = getValueOf(node->left);
     Value* right = getValueOf(node->right);
+    if (left->getType()->isPointerTy() || right->getType()->isPointerTy())
+        return visitPointerArithmetic(node, left, right);
+
+    // Usual arithmetic conversions: double when either side is, char and booleans become int.
+    // Vector operators work lane by lane, a scalar operand is splatted
+    Type* type = nullptr;
+    if (left->getType()->isVectorTy() || right->getType()->isVectorTy()) {
+        type = left->getType()->isVectorTy() ? left->getType() : right->getType();
+    } else if (left->getType()->isFloatingPointTy() || right->getType()->isFloatingPointTy()) {
+        type = m_builder->getDoubleTy();
+    } else {
+        type = m_builder->getInt32Ty();
+    }
+    bool isFP = type->isFPOrFPVectorTy();
+    left = coerceForStore(left, type);
+    right = coerceForStore(right, type);
+
+    // FP instructions get the builder's fast-math flags, see setFastMath
+    auto predicate = comparePredicates.find(node->op);
+    if (predicate != comparePredicates.end()) {
+        Value* cmp = isFP ? m_builder->CreateFCmp(predicate->second.second, left, right, "cmp")
+                          : m_builder->CreateICmp(predicate->second.first, left, right, "cmp");
+        // Vector comparisons give int lanes with all bits set where they hold
+        if (auto* vectorType = dyn_cast<VectorType>(type)) {
+            Type* maskType = VectorType::get(m_builder->getInt32Ty(), vectorType);
+            return m_builder->CreateSExt(cmp, maskType, "mask");
+        }
+        return cmp;
+    }
 
-    if (node->op == "+") {
-        return m_builder->CreateAdd(left, right, "add");
-    } else if (node->op == "-") {
-        return m_builder->CreateSub(left, right, "sub");
-    } else if (node->op == "*") {
-        return m_builder->CreateMul(left, right, "mul");
-    } else if (node->op == "/") {
-        return m_builder->CreateSDiv(left, right, "div");
-    } else if (node->op == "<") {
-        return m_builder->CreateICmpSLT(left, right, "cmp_lt");
-    } else if (node->op == ">") {
-        return m_builder->CreateICmpSGT(left, right, "cmp_gt");
-    } else if (node->op == "==") {
-        return m_builder->CreateICmpEQ(left, right, "cmp_eq");
-    } else if (node->op == "!=") {
-        return m_builder->CreateICmpNE(left, right, "cmp_ne");
+    auto opcode = arithmeticOpcodes.find(node->op);
+    if (opcode == arithmeticOpcodes.end())
+        llvm_unreachable("Unknown binary operator");
+    auto binOp = Instruction::BinaryOps(isFP ? opcode->second.second : opcode->second.first);
+    if (!binOp)
+        throw std::runtime_error("Operator " + node->op + " needs integer operands");
+    return m_builder->CreateBinOp(binOp, left, right, Instruction::getOpcodeName(binOp));
+}
+
+Type* CodeGen::pointeeType(ExpressionNode* pointer) {
+    auto* type = dynamic_cast<PointerTypeNode*>(pointer->resolvedType);
+    if (!type)
+        throw std::runtime_error("Pointer arithmetic on a non-pointer operand");
+    return type->baseType->accept(*this);
+}
+
+// p + n and p - n step over elements, p - q counts them. Comparisons are unsigned and an
+// integer operand, e.g. the literal 0, is converted to a pointer
+Value* CodeGen::visitPointerArithmetic(BinaryExprNode* node, Value* left, Value* right) {
+    bool leftIsPointer = left->getType()->isPointerTy();
+    bool rightIsPointer = right->getType()->isPointerTy();
+    if (leftIsPointer && rightIsPointer && node->op == "-") {
+        Value* diff = m_builder->CreatePtrDiff(pointeeType(node->left), left, right, "ptrdiff");
+        return m_builder->CreateTrunc(diff, m_builder->getInt32Ty(), "ptrdiff");
+    }
+    if (node->op == "+" || node->op == "-") {
+        if (leftIsPointer == rightIsPointer)
+            throw std::runtime_error("Invalid operands to pointer " + node->op);
+        Value* offset = coerceForStore(leftIsPointer ? right : left, m_builder->getInt64Ty());
+        if (node->op == "-")
+            offset = m_builder->CreateNeg(offset, "neg");
+        ExpressionNode* pointer = leftIsPointer ? node->left : node->right;
+        return m_builder->CreateGEP(
+            pointeeType(pointer), leftIsPointer ? left : right, offset, "ptr.add"
+        );
     }
 
-    llvm_unreachable("Unknown binary operator");
+    auto predicate = comparePredicates.find(node->op);
+    if (predicate == comparePredicates.end())
+        throw std::runtime_error("Invalid operands to pointer " + node->op);
+    Type* ptrType = m_builder->getPtrTy();
+    if (!leftIsPointer)
+        left = m_builder->CreateIntToPtr(coerceForStore(left, m_builder->getInt64Ty()), ptrType);
+    if (!rightIsPointer)
+        right = m_builder->CreateIntToPtr(coerceForStore(right, m_builder->getInt64Ty()), ptrType);
+    CmpInst::Predicate unsignedPredicate =
+        ICmpInst::getUnsignedPredicate(predicate->second.first);
+    return m_builder->CreateICmp(unsignedPredicate, left, right, "cmp");
 }
 
 Value* CodeGen::visitUnaryExpr(UnaryExprNode* node) {
     if (node->op == "++" || node->op == "--") {
         Value* addr = getAddressOf(node->operand);
-        // Get the type for the load
-        Type* type = nullptr;
-        if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node->operand)) {
-            type = m_scopeCtx->getType(idNode->name);
-        } else {
-            // For member/index expressions, get from allocaInst
-            if (auto* allocaInst = dyn_cast<AllocaInst>(addr)) {
-                type = allocaInst->getAllocatedType();
-            } else {
-                llvm_unreachable("Cannot determine type for increment/decrement");
-            }
-        }
+        Type* type = node->operand->resolvedType->accept(*this);
         Value* oldVal = m_builder->CreateLoad(type, addr);
         Value* newVal = nullptr;
 
-        if (node->op == "++") {
-            newVal = m_builder->CreateAdd(oldVal, m_builder->getInt32(1), "inc");
+        int step = node->op == "++" ? 1 : -1;
+        const char* name = node->op == "++" ? "inc" : "dec";
+        if (type->isFPOrFPVectorTy()) {
+            newVal = m_builder->CreateFAdd(oldVal, ConstantFP::get(type, step), name);
+        } else if (type->isPointerTy()) {
+            newVal = m_builder->CreateGEP(
+                pointeeType(node->operand), oldVal, m_builder->getInt64(step), name
+            );
         } else {
-            newVal = m_builder->CreateSub(oldVal, m_builder->getInt32(1), "dec");
+            newVal = m_builder->CreateAdd(oldVal, ConstantInt::get(type, step, true), name);
         }
 
         m_builder->CreateStore(newVal, addr);
@@ -530,11 +1712,15 @@ Value* CodeGen::visitUnaryExpr(UnaryExprNode* node) {
 
     if (node->op == "-") {
         Value* operand = getValueOf(node->operand);
-        return m_builder->CreateNeg(operand, "neg");
+        if (operand->getType()->isFPOrFPVectorTy())
+            return m_builder->CreateFNeg(operand, "neg");
+        return m_builder->CreateNeg(coerceForStore(operand, m_builder->getInt32Ty()), "neg");
     } else if (node->op == "!") {
         // compare to zero and return 1 if zero, 0 if non-zero
         Value* operand = getValueOf(node->operand);
         Value* zero = Constant::getNullValue(operand->getType());
+        if (operand->getType()->isFloatingPointTy())
+            return m_builder->CreateFCmpOEQ(operand, zero, "lnot");
         return m_builder->CreateICmpEQ(operand, zero, "lnot");
     } else if (node->op == "~") {
         Value* operand = getValueOf(node->operand);
@@ -543,15 +1729,7 @@ Value* CodeGen::visitUnaryExpr(UnaryExprNode* node) {
         return getAddressOf(node->operand);
     } else if (node->op == "*") {
         Value* ptr = getValueOf(node->operand);
-        // For dereference, we need the pointee type
-        // Get from the TypeNode - the operand should have a pointer type
-        if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node->operand)) {
-            TypeNode* astType = m_scopeCtx->getTypeNode(idNode->name);
-            PointerTypeNode* ptrType = dynamic_cast<PointerTypeNode*>(astType);
-            Type* pointeeType = ptrType->baseType->accept(*this);
-            return m_builder->CreateLoad(pointeeType, ptr, "deref");
-        }
-        llvm_unreachable("Dereference on complex expressions not yet supported");
+        return m_builder->CreateLoad(node->resolvedType->accept(*this), ptr, "deref");
     }
 
     llvm_unreachable("Unknown unary operator");
@@ -601,97 +1779,356 @@ Value* CodeGen::visitIdentifierExpr(IdentifierExprNode* node) {
 }
 
 Value* CodeGen::visitCallExpr(CallExprNode* node) {
+    if (node->builtin)
+        return visitBuiltinCall(node);
+
     std::vector<Value*> args;
     for (auto* arg : node->arguments) {
         args.push_back(getValueOf(arg));
     }
+    // Arguments are converted like an assignment to the parameter, e.g. int to double
+    auto convertArguments = [&](FunctionType* type) {
+        for (size_t i = 0; i < args.size() && i < type->getNumParams(); i++) {
+            args[i] = coerceForStore(args[i], type->getParamType(i));
+        }
+    };
 
+    // Local function pointers may shadow a function of the same name
     Function* func = m_module->getFunction(node->callee->name);
-    if (func) {
+    if (func && !m_scopeCtx->get(node->callee->name)) {
+        convertArguments(func->getFunctionType());
+        if (Value* allocation = emitAllocationCall(func, args))
+            return allocation;
         // Direct function call: foo(args)
         // Only give it a name if it returns a value (not void)
         const char* name = func->getReturnType()->isVoidTy() ? "" : "direct_call";
-        return m_builder->CreateCall(func, args, name);
+        CallInst* call = m_builder->CreateCall(func, args, name);
+        call->setCallingConv(func->getCallingConv());
+        return call;
     }
 
-    // Indirect call through function pointer
+    // Indirect call through function pointer, the signature comes from its typedef
     Value* funcPtr = getValueOf(node->callee);
-
-    // For opaque pointers, we need the FunctionType
-    // The variable's type is the function type (we stored it when creating the variable)
-    // For function pointer variables, the stored type should be the function type
-    Type* varType = m_scopeCtx->getType(node->callee->name);
-    FunctionType* funcType = cast<FunctionType>(varType);
+    auto* typeName = dynamic_cast<NamedTypeNode*>(node->callee->resolvedType);
+    if (!typeName || !m_functionPtrTypes.count(typeName->identifier))
+        throw std::runtime_error("Called object is not a function: " + node->callee->name);
+    FunctionType* funcType = m_functionPtrTypes[typeName->identifier];
+    convertArguments(funcType);
+
+    std::string caller = m_builder->GetInsertBlock()->getParent()->getName().str();
+    std::vector<CallTargets::Target> targets =
+        m_callTargets.promote(caller, node->callee->name, node->callee->declaration);
+    if (!targets.empty())
+        return emitPromotedCall(funcType, funcPtr, targets, args);
 
     // Only give it a name if it returns a value (not void)
     const char* name = funcType->getReturnType()->isVoidTy() ? "" : "indirect_call";
     return m_builder->CreateCall(funcType, funcPtr, args, name);
 }
 
+// Must match ALLOC_ALIGN and MAX_POOL_SIZE in test/runtime.c
+static constexpr uint64_t allocationAlign = 16;
+static constexpr uint64_t maxPoolSize = 256;
+
+// arena_alloc, pool_alloc and pool_free of the runtime with a constant size, which the builder
+// has folded by now. The size is rounded, or turned into a size class, here and the runtime entry
+// taking it is inlined even at -O0, leaving a bump or a free list pop. Null for any other call
+Value* CodeGen::emitAllocationCall(Function* func, const std::vector<Value*>& args) {
+    StringRef name = func->getName();
+    bool isFree = name == "pool_free";
+    if (!func->isDeclaration() || (name != "arena_alloc" && name != "pool_alloc" && !isFree))
+        return nullptr;
+    Type* ptrTy = m_builder->getPtrTy();
+    Type* int32Ty = m_builder->getInt32Ty();
+    FunctionType* expected = isFree
+        ? FunctionType::get(m_builder->getVoidTy(), {ptrTy, int32Ty}, false)
+        : FunctionType::get(ptrTy, {int32Ty}, false);
+    if (func->getFunctionType() != expected)
+        return nullptr;
+    auto* size = dyn_cast<ConstantInt>(args[isFree ? 1 : 0]);
+    if (!size || size->isNegative() || size->isZero())
+        return nullptr;
+    uint64_t rounded = alignTo(size->getZExtValue(), allocationAlign);
+
+    CallInst* call;
+    if (name == "arena_alloc") {
+        FunctionCallee alloc = m_module->getOrInsertFunction(
+            "__arena_alloc_rounded", ptrTy, m_builder->getInt64Ty()
+        );
+        call = m_builder->CreateCall(alloc, {m_builder->getInt64(rounded)}, "arena_alloc");
+    } else {
+        // Larger sizes are a malloc either way
+        if (rounded > maxPoolSize)
+            return nullptr;
+        Value* sizeClass = m_builder->getInt32(rounded / allocationAlign - 1);
+        if (isFree) {
+            FunctionCallee release = m_module->getOrInsertFunction(
+                "__pool_free_class", m_builder->getVoidTy(), ptrTy, int32Ty
+            );
+            call = m_builder->CreateCall(release, {args[0], sizeClass});
+        } else {
+            FunctionCallee alloc =
+                m_module->getOrInsertFunction("__pool_alloc_class", ptrTy, int32Ty);
+            call = m_builder->CreateCall(alloc, {sizeClass}, "pool_alloc");
+        }
+    }
+    call->addFnAttr(Attribute::AlwaysInline);
+    call->addFnAttr(Attribute::NoUnwind);
+    if (!isFree) {
+        // Fresh memory like malloc's, nothing else points into it
+        call->addRetAttr(Attribute::NoAlias);
+        call->addRetAttr(Attribute::getWithAlignment(*m_context, Align(allocationAlign)));
+        call->addRetAttr(Attribute::getWithDereferenceableBytes(*m_context, rounded));
+    }
+    return call;
+}
+
+// if (p == f) f(args) else if (p == g) g(args) ... else p(args), the direct calls can be inlined.
+// Profile counts become branch weights
+Value* CodeGen::emitPromotedCall(
+    FunctionType* type,
+    Value* funcPtr,
+    const std::vector<CallTargets::Target>& targets,
+    const std::vector<Value*>& args
+) {
+    Function* func = m_builder->GetInsertBlock()->getParent();
+    BasicBlock* mergeBB = BasicBlock::Create(*m_context, "icp.merge");
+    bool isVoid = type->getReturnType()->isVoidTy();
+    std::vector<std::pair<Value*, BasicBlock*>> results;
+
+    uint64_t remaining = 0;
+    for (const CallTargets::Target& target : targets) {
+        remaining += target.count;
+    }
+    for (const CallTargets::Target& target : targets) {
+        // The profile may name functions of other modules or with another signature
+        Function* callee = m_module->getFunction(target.function);
+        remaining -= target.count;
+        if (!callee || callee->getFunctionType() != type)
+            continue;
+
+        BasicBlock* callBB = BasicBlock::Create(*m_context, "icp.direct", func);
+        BasicBlock* nextBB = BasicBlock::Create(*m_context, "icp.next", func);
+        Value* isTarget = m_builder->CreateICmpEQ(funcPtr, callee, "icp.is." + target.function);
+        BranchInst* branch = m_builder->CreateCondBr(isTarget, callBB, nextBB);
+        if (target.count > 0) {
+            // Weights are 32-bit, scale down huge counts
+            uint64_t scale = std::max(target.count, remaining) / UINT32_MAX + 1;
+            branch->setMetadata(
+                LLVMContext::MD_prof,
+                MDBuilder(*m_context).createBranchWeights(
+                    uint32_t(target.count / scale), uint32_t(remaining / scale)
+                )
+            );
+        }
+
+        m_builder->SetInsertPoint(callBB);
+        CallInst* call = m_builder->CreateCall(callee, args, isVoid ? "" : "icp.call");
+        call->setCallingConv(callee->getCallingConv());
+        m_builder->CreateBr(mergeBB);
+        results.push_back({call, callBB});
+        m_builder->SetInsertPoint(nextBB);
+    }
+
+    CallInst* fallback = m_builder->CreateCall(type, funcPtr, args, isVoid ? "" : "indirect_call");
+    results.push_back({fallback, m_builder->GetInsertBlock()});
+    m_builder->CreateBr(mergeBB);
+
+    func->insert(func->end(), mergeBB);
+    m_builder->SetInsertPoint(mergeBB);
+    if (isVoid)
+        return fallback;
+    PHINode* phi = m_builder->CreatePHI(type->getReturnType(), results.size(), "icp.result");
+    for (const auto& [value, block] : results) {
+        phi->addIncoming(value, block);
+    }
+    return phi;
+}
+
+// Builtins that are one intrinsic, overloaded on the operand type
+static const std::unordered_map<BuiltinKind, Intrinsic::ID> builtinIntrinsics = {
+    {BuiltinKind::Sqrt, Intrinsic::sqrt},
+    {BuiltinKind::Fabs, Intrinsic::fabs},
+    {BuiltinKind::Floor, Intrinsic::floor},
+    {BuiltinKind::Ceil, Intrinsic::ceil},
+    {BuiltinKind::Trunc, Intrinsic::trunc},
+    {BuiltinKind::Round, Intrinsic::round},
+    {BuiltinKind::Fmin, Intrinsic::minnum},
+    {BuiltinKind::Fmax, Intrinsic::maxnum},
+    {BuiltinKind::Fma, Intrinsic::fma},
+    {BuiltinKind::Popcount, Intrinsic::ctpop},
+    {BuiltinKind::Clz, Intrinsic::ctlz},
+    {BuiltinKind::Ctz, Intrinsic::cttz},
+    {BuiltinKind::Expect, Intrinsic::expect},
+};
+
+// Sema checked the arguments, see Builtins.h
+Value* CodeGen::visitBuiltinCall(CallExprNode* node) {
+    const Builtin& builtin = *node->builtin;
+    const auto& arguments = node->arguments;
+    // Arrays are passed by address, the first element is the start
+    auto pointerArgument = [&](ExpressionNode* argument) {
+        if (dynamic_cast<ArrayTypeNode*>(argument->resolvedType))
+            return getAddressOf(argument);
+        return getValueOf(argument);
+    };
+
+    switch (builtin.kind) {
+        case BuiltinKind::ShuffleVector: {
+            Value* a = getValueOf(arguments[0]);
+            Value* b = getValueOf(arguments[1]);
+            std::vector<int> mask;
+            for (size_t i = 2; i < arguments.size(); i++) {
+                mask.push_back(static_cast<IntegerLiteralNode*>(arguments[i])->value);
+            }
+            return m_builder->CreateShuffleVector(a, b, mask, "shuffle");
+        }
+        case BuiltinKind::ReduceAdd:
+        case BuiltinKind::ReduceMul:
+        case BuiltinKind::ReduceMin:
+        case BuiltinKind::ReduceMax:
+        case BuiltinKind::ReduceAnd:
+        case BuiltinKind::ReduceOr:
+        case BuiltinKind::ReduceXor: {
+            Value* vector = getValueOf(arguments[0]);
+            bool isFP = vector->getType()->isFPOrFPVectorTy();
+            Type* elemType = vector->getType()->getScalarType();
+            switch (builtin.kind) {
+                // In lane order unless reassociation is allowed, see setFastMath
+                case BuiltinKind::ReduceAdd:
+                    if (isFP)
+                        return m_builder->CreateFAddReduce(ConstantFP::get(elemType, -0.0), vector);
+                    return m_builder->CreateAddReduce(vector);
+                case BuiltinKind::ReduceMul:
+                    if (isFP)
+                        return m_builder->CreateFMulReduce(ConstantFP::get(elemType, 1.0), vector);
+                    return m_builder->CreateMulReduce(vector);
+                case BuiltinKind::ReduceMin:
+                    return isFP ? m_builder->CreateFPMinReduce(vector)
+                                : m_builder->CreateIntMinReduce(vector, true);
+                case BuiltinKind::ReduceMax:
+                    return isFP ? m_builder->CreateFPMaxReduce(vector)
+                                : m_builder->CreateIntMaxReduce(vector, true);
+                case BuiltinKind::ReduceAnd: return m_builder->CreateAndReduce(vector);
+                case BuiltinKind::ReduceOr: return m_builder->CreateOrReduce(vector);
+                default: return m_builder->CreateXorReduce(vector);
+            }
+        }
+        case BuiltinKind::VectorLoad:
+        case BuiltinKind::VectorStore: {
+            PrimitiveTypeNode vectorNode(PrimitiveTypeNode::kindFromString(builtin.vectorType));
+            auto* vectorType = cast<FixedVectorType>(visitPrimitiveType(&vectorNode));
+            Value* ptr = pointerArgument(arguments[0]);
+            const DataLayout& DL = m_module->getDataLayout();
+            Align align = builtin.aligned
+                              ? Align(DL.getTypeStoreSize(vectorType).getFixedValue())
+                              : DL.getABITypeAlign(vectorType->getElementType());
+            if (builtin.kind == BuiltinKind::VectorLoad)
+                return m_builder->CreateAlignedLoad(vectorType, ptr, align, "vload");
+            Value* value = coerceForStore(getValueOf(arguments[1]), vectorType);
+            return m_builder->CreateAlignedStore(value, ptr, align);
+        }
+        case BuiltinKind::Sqrt:
+        case BuiltinKind::Fabs:
+        case BuiltinKind::Floor:
+        case BuiltinKind::Ceil:
+        case BuiltinKind::Trunc:
+        case BuiltinKind::Round:
+        case BuiltinKind::Fmin:
+        case BuiltinKind::Fmax:
+        case BuiltinKind::Fma:
+        case BuiltinKind::Popcount:
+        case BuiltinKind::Clz:
+        case BuiltinKind::Ctz:
+        case BuiltinKind::Expect: {
+            // Operands have the result type, the expected value is a constant. FP ones get the
+            // builder's fast-math flags
+            Type* type = node->resolvedType->accept(*this);
+            std::vector<Value*> args;
+            for (auto* argument : arguments) {
+                args.push_back(coerceForStore(getValueOf(argument), type));
+            }
+            if (builtin.kind == BuiltinKind::Expect)
+                args[1] = foldConstantExpr(arguments[1], type);
+            // The zero count of 0 is poison, like __builtin_clz(0) is undefined
+            if (builtin.kind == BuiltinKind::Clz || builtin.kind == BuiltinKind::Ctz)
+                args.push_back(m_builder->getTrue());
+            Intrinsic::ID id = builtinIntrinsics.at(builtin.kind);
+            return m_builder->CreateIntrinsic(id, {type}, args, {}, node->callee->name);
+        }
+        case BuiltinKind::Prefetch: {
+            Value* ptr = pointerArgument(arguments[0]);
+            // Read with high locality by default, always the data cache
+            auto constant = [&](size_t i, int64_t fallback) {
+                if (i >= arguments.size())
+                    return m_builder->getInt32(fallback);
+                return m_builder->getInt32(static_cast<IntegerLiteralNode*>(arguments[i])->value);
+            };
+            return m_builder->CreateIntrinsic(
+                Intrinsic::prefetch, {ptr->getType()},
+                {ptr, constant(1, 0), constant(2, 3), m_builder->getInt32(1)}
+            );
+        }
+    }
+    llvm_unreachable("Unknown builtin");
+}
+
 Value* CodeGen::visitCastExpr(CastExprNode* node) {
     // TODO: Implement casts
     std::cout << "Generating cast expression\n";
     return nullptr;
 }
 
-// This is mostly ai work, i implemented it myself with llvm docs but it was not working on llvm ir v22 due to opaque pointers stuff i dont understand. my solution was 5 lines using getPointerElementType, now i need to track all types
 Value* CodeGen::visitMemberExpr(MemberExprNode* node) {
-    Value* structPtr = node->arrowAccess ? getValueOf(node->object) : getAddressOf(node->object);
-
-    // For opaque pointers (LLVM 15+), get the type from the value itself
-    Type* structType = nullptr;
-
+    Value* structPtr = nullptr;
     if (node->arrowAccess) {
-        // obj->field: structPtr is a loaded pointer value
-        // For a pointer loaded from an allocaInst, we need to know what it points to
-        // Use the stored type from Context
-        if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node->object)) {
-            Type* varType = m_scopeCtx->getType(idNode->name);
-            // varType should be the struct type (stored when variable was created)
-            structType = varType;
-        }
+        structPtr = getValueOf(node->object);
+    } else if (node->object->isLValue) {
+        structPtr = getAddressOf(node->object);
     } else {
-        // obj.field: structPtr is a pointer to struct (AllocaInst or Argument)
-        if (auto* allocaInst = dyn_cast<AllocaInst>(structPtr)) {
-            // Use getAllocatedType() as per LLVM opaque pointer migration guide
-            structType = allocaInst->getAllocatedType();
-        } else if (isa<Argument>(structPtr)) {
-            // For arguments, we need to use stored type
-            if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node->object)) {
-                structType = m_scopeCtx->getType(idNode->name);
-            }
-        }
+        // Struct returned by a call, give it an address to index from
+        Value* value = getValueOf(node->object);
+        structPtr = createEntryAlloca(value->getType(), "tmp");
+        m_builder->CreateStore(value, structPtr);
     }
 
-    StructType* st = cast<StructType>(structType);
-    std::string structName = st->getName().str();
-    unsigned fieldIndex = m_structInfos[structName].fields[node->member].first;
+    StructInfo& info = m_structInfos[node->structDecl->identifier];
+    StructType* st = cast<StructType>(info.type);
+    const StructInfo::Field& field = info.fields[node->fieldIndex];
+
+    if (field.cold) {
+        Value* coldSlot = m_builder->CreateStructGEP(st, structPtr, info.coldIndex, "cold_slot");
+        Value* coldPtr = m_builder->CreateLoad(m_builder->getPtrTy(), coldSlot, "cold_ptr");
+        return m_builder->CreateStructGEP(info.coldType, coldPtr, field.index, "field_ptr");
+    }
 
-    return m_builder->CreateStructGEP(st, structPtr, fieldIndex, "field_ptr");
+    return m_builder->CreateStructGEP(st, structPtr, field.index, "field_ptr");
 }
 
 Value* CodeGen::visitIndexExpr(IndexExprNode* node) {
-    Value* arrayPtr = getAddressOf(node->array);
-    Value* index = getValueOf(node->index);
+    // Arrays are indexed in place through [0, index], pointers are loaded first
+    if (auto* arrayType = dynamic_cast<ArrayTypeNode*>(node->array->resolvedType)) {
+        Value* arrayPtr = getAddressOf(node->array);
+        Value* index = getValueOf(node->index);
+        std::vector<Value*> indices = {m_builder->getInt32(0), index};
+        return m_builder->CreateGEP(arrayType->accept(*this), arrayPtr, indices, "elem_ptr");
+    }
 
-    // For opaque pointers, we need the array/element type
-    Type* arrayType = nullptr;
-    if (auto* allocaInst = dyn_cast<AllocaInst>(arrayPtr)) {
-        // Use getAllocatedType() for allocas (LLVM migration guide)
-        arrayType = allocaInst->getAllocatedType();
-    } else if (auto* idNode = dynamic_cast<IdentifierExprNode*>(node->array)) {
-        // For arguments or other cases, use stored type
-        arrayType = m_scopeCtx->getType(idNode->name);
-    } else {
-        llvm_unreachable("Array indexing on complex expressions requires type tracking");
+    // Vector lanes in memory are laid out like an array of the element type
+    if (node->array->resolvedType->accept(*this)->isVectorTy()) {
+        Value* vectorPtr = getAddressOf(node->array);
+        Value* index = getValueOf(node->index);
+        Type* elemType = node->resolvedType->accept(*this);
+        return m_builder->CreateGEP(elemType, vectorPtr, index, "lane_ptr");
     }
 
-    // For arrays allocated with allocaInst [N x type], use indices [0, index]
-    // The first 0 gets to the array start, the second is the actual index
-    std::vector<Value*> indices = {m_builder->getInt32(0), index};
+    Value* ptr = getValueOf(node->array);
+    Value* index = getValueOf(node->index);
+    return m_builder->CreateGEP(node->resolvedType->accept(*this), ptr, index, "elem_ptr");
+}
 
-    // For opaque pointers, CreateGEP needs: (Type, ptr, indices)
-    return m_builder->CreateGEP(arrayType, arrayPtr, indices, "elem_ptr");
+Value* CodeGen::visitInitializerList(InitializerListExprNode* node) {
+    throw std::runtime_error("Initializer list is only allowed in a variable declaration");
 }
 
 Value* CodeGen::visitCommaExpr(CommaExprNode* node) {
@@ -709,7 +2146,11 @@ Type* CodeGen::visitPrimitiveType(PrimitiveTypeNode* node) {
         case PrimitiveTypeNode::Char: return Type::getInt8Ty(*m_context);
         case PrimitiveTypeNode::Int: return Type::getInt32Ty(*m_context);
         case PrimitiveTypeNode::Double: return Type::getDoubleTy(*m_context);
-        default: return nullptr;
+        default: {
+            // SIMD vectors
+            PrimitiveTypeNode element(node->elementKind());
+            return FixedVectorType::get(visitPrimitiveType(&element), node->lanes());
+        }
     }
 }
 
@@ -721,3 +2162,7 @@ Type* CodeGen::visitPointerType(PointerTypeNode* node) {
 Type* CodeGen::visitNamedType(NamedTypeNode* node) {
     return m_namedTypes[node->identifier];
 }
+
+Type* CodeGen::visitArrayType(ArrayTypeNode* node) {
+    return ArrayType::get(node->elementType->accept(*this), node->size);
+}
@@ -1,17 +1,27 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "ArrayUsage.h"
+#include "CallTargets.h"
 #include "Context.h"
+#include "FunctionAttrs.h"
+#include "StructLayout.h"
 
 
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Value.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Target/TargetMachine.h>
 
+#include "AST/SourceLocation.h"
 #include "AST/forwardDecl.h"
 
 using namespace llvm;
@@ -25,33 +35,117 @@ class CodeGen {
     std::unique_ptr<Module> m_module;
     std::unique_ptr<IRBuilder<>> m_builder;
 
+    // Line tables, only created when enableDebugInfo is called
+    std::unique_ptr<DIBuilder> m_debugBuilder;
+    DICompileUnit* m_debugUnit = nullptr;
+    DISubprogram* m_debugScope = nullptr;
+
     // Symbol table for namedTypes
     struct StructInfo {
+        struct Field {
+            unsigned index;  // Into coldType for cold fields
+            llvm::Type* type;
+            bool cold = false;
+        };
+
         llvm::Type* type;
-        std::unordered_map<std::string, std::pair<unsigned, llvm::Type*>> fields;
+        std::vector<Field> fields;  // In declaration order, see MemberExprNode::fieldIndex
+
+        // Hot/cold split, the hot struct holds a pointer to the cold part at coldIndex
+        llvm::StructType* coldType = nullptr;
+        unsigned coldIndex = 0;
     };
     std::unordered_map<std::string, StructInfo> m_structInfos;
     std::unordered_map<std::string, llvm::Type*> m_namedTypes;
+    // Signatures of function pointer typedefs, m_namedTypes has them as plain pointers
+    std::unordered_map<std::string, llvm::FunctionType*> m_functionPtrTypes;
+
+    StructLayoutMode m_structLayout = StructLayoutMode::Declared;
+    StructUsage m_structUsage;
+    ArrayUsage m_arrayUsage;  // Of the function being generated
+
+    // Innermost loop or switch last, continueBB is inherited from the loop around a switch
+    struct JumpTargets {
+        llvm::BasicBlock* breakBB;
+        llvm::BasicBlock* continueBB;
+    };
+    std::vector<JumpTargets> m_jumpTargets;
+
+    // Local of the enclosing function passed to an outlined parallel for body
+    struct LoopCapture {
+        std::string name;
+        llvm::Type* type;
+        bool byValue;  // Copied into the captures struct, otherwise its address is
+    };
+
+    // Whole-program mode, set when every function of the program is in this module
+    bool m_wholeProgram = false;
+    FunctionAttrsAnalysis m_functionAttrs;
+
+    // return f(x) calls of the function being generated, see markTailCalls
+    std::vector<llvm::CallInst*> m_tailCalls;
+    bool m_tailRecursionLoops = false;
+
+    // Targets guarded at calls through function pointers, empty unless setCallTargets was called
+    CallTargets m_callTargets;
+
+    // Part of a multi-module ThinLTO build, other modules may refer to our globals
+    bool m_multiModule = false;
+    TargetMachine* m_targetMachine = nullptr;  // Not owned, may be null
+
+    void runModulePasses(const std::function<ModulePassManager(PassBuilder&)>& buildPipeline);
 
   public:
-    CodeGen(const std::string& moduleName);
+    // The module takes triple and DataLayout from targetMachine, functions its CPU and features
+    CodeGen(const std::string& moduleName, TargetMachine* targetMachine = nullptr);
 
     LLVMContext* getContext();
     Module* getModule();
     IRBuilder<>* getBuilder();
 
+    void enableDebugInfo(const std::string& sourceFile);
+    void emitLocation(const SourceLocation& location);
+
     void generate(ProgramNode* program);
+    void verify();  // Throws when the module is invalid
+    void optimize(unsigned level);  // Run the default LLVM pipeline for -O0..-O3
+    void setStructLayout(StructLayoutMode mode, StructUsage usage = {});
+    void setWholeProgram(FunctionAttrsAnalysis analysis);
+    void setMultiModule();
+    // Self-recursive tail calls become loops at -O0 too, higher levels always do it
+    void setTailRecursionLoops();
+    // Calls through function pointers test for these targets and call them directly
+    void setCallTargets(CallTargets targets);
+    // Flags of every floating point operation, -ffast-math and friends
+    void setFastMath(FastMathFlags flags);
+    // ThinLTO pre-link pipeline, then bitcode with a module summary to out
+    void emitThinLTOBitcode(unsigned level, raw_ostream& out);
     void print();                                   // Print IR to stdout
     void printToFile(const std::string& filename);  // Save IR to file
 
     // Visitor methods for declarations
     void visitFunctionDeclaration(FunctionDeclNode* node);
     void visitFunctionDefinition(FunctionDeclNode* node);
+    void applyFunctionAttributes(llvm::Function* function);
+    void createDebugScope(llvm::Function* function, unsigned line);
+    void markTailCalls(llvm::Function* function);
     void visitVariableDeclaration(VariableDeclNode* node);
+    void visitGlobalVariable(VariableDeclNode* node);
+
+    // Array and struct initializer lists
+    llvm::Constant* foldConstantExpr(ExpressionNode* node, llvm::Type* type);
+    llvm::Constant* buildConstantImage(ExpressionNode* init, llvm::Type* type, bool& isConstant);
+    void storeDynamicElements(ExpressionNode* init, llvm::Type* type, llvm::Value* ptr);
+    llvm::GlobalVariable* createConstantGlobal(llvm::Constant* image, const std::string& name);
+    llvm::Value* emitAggregateInitializer(
+        const std::string& name, llvm::Type* type, ExpressionNode* init, bool isConst
+    );
 
     void visitFunctionPtrDeclaration(FunctionPtrDeclNode* node);
     void visitStructDeclaration(StructDeclNode* node);
     void visitStructDefinition(StructDeclNode* node);
+    void initColdStorage(llvm::StructType* type, llvm::Value* ptr, uint64_t count, bool isArray);
+    llvm::AllocaInst* createEntryAlloca(llvm::Type* type, const llvm::Twine& name);
 
     // Visitor methods for statements
     void visitBlockStatement(BlockStatementNode* node);
@@ -60,9 +154,18 @@ class CodeGen {
     void visitWhileStatement(WhileStatementNode* node);
     void visitDoWhileStatement(DoWhileStatementNode* node);
     void visitForStatement(ForStatementNode* node);
+    void visitParallelForStatement(ParallelForStatementNode* node);
+    llvm::Function* outlineParallelBody(
+        ParallelForStatementNode* node,
+        llvm::StructType* capturesType,
+        const std::vector<LoopCapture>& captures
+    );
     void visitReturnStatement(ReturnStatementNode* node);
     void visitCaseStatement(CaseStatementNode* node);
     void visitSwitchStatement(SwitchStatementNode* node);
+    void visitBreakStatement(BreakStatementNode* node);
+    void visitContinueStatement(ContinueStatementNode* node);
+    void startUnreachableBlock();
 
     // Visitor methods for expressions
     llvm::Value* visitBinaryExpr(BinaryExprNode* node);
@@ -72,6 +175,26 @@ class CodeGen {
     llvm::Value* getAddressOf(ExpressionNode* node);  // Get pointer (for l-values)
     llvm::Value* getValueOf(ExpressionNode* node);    // Get loaded value (for r-values)
     llvm::Value* convertToBoolean(llvm::Value* condValue);
+    llvm::Value* coerceForStore(llvm::Value* value, llvm::Type* destType);
+    bool copyAggregate(llvm::Value* dest, ExpressionNode* source, llvm::Type* type);
+    llvm::Type* pointeeType(ExpressionNode* pointer);
+    llvm::Value* visitPointerArithmetic(BinaryExprNode* node, llvm::Value* left, llvm::Value* right);
+
+    // Short-circuit lowering of && and ||
+    bool isBranchlessLogical(BinaryExprNode* node);
+    llvm::Value* visitLogicalExpr(BinaryExprNode* node);
+    void emitConditionalBranch(
+        ExpressionNode* cond, llvm::BasicBlock* trueBB, llvm::BasicBlock* falseBB
+    );
+
+    // Rotated loop emission and llvm.loop metadata
+    llvm::MDNode* createLoopMetadata(const LoopAttributes& attributes, bool mustProgress);
+    void emitLoopLatch(
+        ExpressionNode* condition,
+        llvm::BasicBlock* headerBB,
+        llvm::BasicBlock* exitBB,
+        const LoopAttributes& attributes
+    );
 
     llvm::Value* visitIntegerLiteral(IntegerLiteralNode* node);
     llvm::Value* visitDoubleLiteral(DoubleLiteralNode* node);
@@ -80,13 +203,23 @@ class CodeGen {
 
     llvm::Value* visitIdentifierExpr(IdentifierExprNode* node);
     llvm::Value* visitCallExpr(CallExprNode* node);
+    llvm::Value* visitBuiltinCall(CallExprNode* node);
+    llvm::Value* emitPromotedCall(
+        llvm::FunctionType* type,
+        llvm::Value* funcPtr,
+        const std::vector<CallTargets::Target>& targets,
+        const std::vector<llvm::Value*>& args
+    );
+    llvm::Value* emitAllocationCall(llvm::Function* func, const std::vector<llvm::Value*>& args);
     llvm::Value* visitCastExpr(CastExprNode* node);  // todo
     llvm::Value* visitMemberExpr(MemberExprNode* node);
     llvm::Value* visitIndexExpr(IndexExprNode* node);
     llvm::Value* visitCommaExpr(CommaExprNode* node);
+    llvm::Value* visitInitializerList(InitializerListExprNode* node);
 
     // Visitor methods for types
     llvm::Type* visitPrimitiveType(PrimitiveTypeNode* node);
     llvm::Type* visitPointerType(PointerTypeNode* node);
     llvm::Type* visitNamedType(NamedTypeNode* node);
+    llvm::Type* visitArrayType(ArrayTypeNode* node);
 };
\ No newline at end of file
@@ -6,9 +6,6 @@
 #include <string>
 #include <unordered_map>
 
-// Forward declaration
-struct TypeNode;
-
 struct Context {
     enum Type {
         Global = 1,
@@ -55,22 +52,7 @@ struct Context {
 
     void setType(const std::string& name, llvm::Type* type) { namedTypes[name] = type; }
 
-    // For opaque pointers: also track AST TypeNode to preserve full type info
-    TypeNode* getTypeNode(const std::string& name) {
-        if (astTypes.count(name)) {
-            return astTypes[name];
-        }
-        if (parent) {
-            return parent->getTypeNode(name);
-        }
-        return nullptr;
-    }
-
-    void setTypeNode(const std::string& name, TypeNode* typeNode) { astTypes[name] = typeNode; }
-
-
   private:
     std::unordered_map<std::string, llvm::Value*> namedValues;
     std::unordered_map<std::string, llvm::Type*> namedTypes;
-    std::unordered_map<std::string, TypeNode*> astTypes;  // Track AST types for opaque pointers
 };
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "FunctionAttrs.h"
+
+#include <vector>
+
+#include "AST/ASTWalker.h"
+#include "AST/includeNodes.h"
+
+
+namespace {
+
+    // Memory access recorded while walking a body. Whether a pointer parameter still points to
+    // caller memory is only known once the whole body was seen
+    struct Access {
+        std::string base;  // Pointer parameter the access goes through, empty for other memory
+        bool isWrite;
+    };
+
+    class FunctionFactsWalker : public ASTWalker {
+      public:
+        FunctionAttrsAnalysis analysis;
+
+        void visitDeclaration(DeclarationNode* node) override {
+            if (auto* funcDecl = dynamic_cast<FunctionDeclNode*>(node)) {
+                FunctionFacts& facts = analysis.functions[funcDecl->identifier];
+                if (!funcDecl->body)
+                    return;
+
+                facts.isDefined = true;
+                m_current = &facts;
+                m_locals.clear();
+                m_arrays.clear();
+                m_params.clear();
+                m_reassigned.clear();
+                m_accesses.clear();
+                for (auto* param : funcDecl->parameters) {
+                    m_locals.insert(param->identifier);
+                    m_params.insert(param->identifier);
+                }
+            } else if (auto* varDecl = dynamic_cast<VariableDeclNode*>(node)) {
+                if (!m_current) {
+                    m_globals.insert(varDecl->identifier);
+                    return;
+                }
+                m_locals.insert(varDecl->identifier);
+                if (varDecl->arraySize)
+                    m_arrays.insert(varDecl->identifier);
+            }
+        }
+
+        void visitStatement(StatementNode* node) override {
+            if (m_current &&
+                (dynamic_cast<ForStatementNode*>(node) || dynamic_cast<WhileStatementNode*>(node) ||
+                 dynamic_cast<DoWhileStatementNode*>(node))) {
+                m_current->hasLoops = true;
+            }
+        }
+
+        void visitExpression(ExpressionNode* node) override {
+            if (auto* call = dynamic_cast<CallExprNode*>(node)) {
+                m_directCallees.insert(call->callee);
+                if (!m_current)
+                    return;
+                if (m_locals.count(call->callee->name)) {
+                    m_current->hasIndirectCalls = true;
+                } else {
+                    m_current->callees.insert(call->callee->name);
+                }
+            } else if (auto* id = dynamic_cast<IdentifierExprNode*>(node)) {
+                if (m_locals.count(id->name))
+                    return;
+                auto it = analysis.functions.find(id->name);
+                if (it != analysis.functions.end()) {
+                    if (!m_directCallees.count(id))
+                        it->second.addressTaken = true;
+                } else if (m_current && m_globals.count(id->name)) {
+                    m_current->readsOtherMem = true;
+                }
+            }
+
+            if (!m_current)
+                return;
+
+            if (auto* bin = dynamic_cast<BinaryExprNode*>(node)) {
+                if (bin->op == "=")
+                    recordWrite(bin->left);
+            } else if (auto* un = dynamic_cast<UnaryExprNode*>(node)) {
+                if (un->op == "++" || un->op == "--") {
+                    recordWrite(un->operand);
+                } else if (un->op == "&") {
+                    // A global whose address escapes may be written by anyone
+                    recordWrite(un->operand);
+                } else if (un->op == "*") {
+                    m_accesses.push_back({pointerBase(un->operand), false});
+                }
+            } else if (auto* member = dynamic_cast<MemberExprNode*>(node)) {
+                if (member->arrowAccess)
+                    m_accesses.push_back({pointerBase(member->object), false});
+            } else if (auto* index = dynamic_cast<IndexExprNode*>(node)) {
+                if (!isLocalArray(index->array))
+                    m_accesses.push_back({pointerBase(index->array), false});
+            }
+        }
+
+        void leaveFunction(FunctionDeclNode* node) override {
+            for (const Access& access : m_accesses) {
+                bool viaArg = !access.base.empty() && !m_reassigned.count(access.base);
+                if (viaArg) {
+                    (access.isWrite ? m_current->writesArgMem : m_current->readsArgMem) = true;
+                } else {
+                    (access.isWrite ? m_current->writesOtherMem : m_current->readsOtherMem) = true;
+                }
+            }
+            m_current = nullptr;
+        }
+
+      private:
+        bool isLocalArray(ExpressionNode* expr) const {
+            auto* id = dynamic_cast<IdentifierExprNode*>(expr);
+            return id && m_arrays.count(id->name);
+        }
+
+        // Parameter name when the pointer comes straight from a parameter
+        std::string pointerBase(ExpressionNode* expr) const {
+            auto* id = dynamic_cast<IdentifierExprNode*>(expr);
+            return id && m_params.count(id->name) ? id->name : "";
+        }
+
+        void recordWrite(ExpressionNode* target) {
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(target)) {
+                if (m_params.count(id->name)) {
+                    m_reassigned.insert(id->name);
+                } else if (!m_locals.count(id->name) && m_globals.count(id->name)) {
+                    m_current->writesOtherMem = true;
+                }
+            } else if (auto* un = dynamic_cast<UnaryExprNode*>(target)) {
+                if (un->op == "*")
+                    m_accesses.push_back({pointerBase(un->operand), true});
+            } else if (auto* member = dynamic_cast<MemberExprNode*>(target)) {
+                if (member->arrowAccess) {
+                    m_accesses.push_back({pointerBase(member->object), true});
+                } else {
+                    recordWrite(member->object);
+                }
+            } else if (auto* index = dynamic_cast<IndexExprNode*>(target)) {
+                if (!isLocalArray(index->array)) {
+                    if (auto* id = dynamic_cast<IdentifierExprNode*>(index->array);
+                        id && !m_locals.count(id->name) && m_globals.count(id->name)) {
+                        m_current->writesOtherMem = true;
+                    } else {
+                        m_accesses.push_back({pointerBase(index->array), true});
+                    }
+                }
+            }
+        }
+
+        FunctionFacts* m_current = nullptr;
+        std::unordered_set<std::string> m_globals;
+        std::unordered_set<std::string> m_locals;
+        std::unordered_set<std::string> m_arrays;
+        std::unordered_set<std::string> m_params;
+        std::unordered_set<std::string> m_reassigned;
+        std::unordered_set<const ExpressionNode*> m_directCallees;
+        std::vector<Access> m_accesses;
+    };
+
+    // Can `from` reach `to` through direct calls, or indirect calls to address-taken functions
+    bool reaches(
+        const FunctionAttrsAnalysis& analysis,
+        const std::string& from,
+        const std::string& to,
+        std::unordered_set<std::string>& visited
+    ) {
+        if (!visited.insert(from).second)
+            return false;
+        const FunctionFacts* facts = analysis.lookup(from);
+        if (!facts)
+            return false;
+
+        std::vector<std::string> next(facts->callees.begin(), facts->callees.end());
+        if (facts->hasIndirectCalls) {
+            for (const auto& [name, other] : analysis.functions) {
+                if (other.addressTaken)
+                    next.push_back(name);
+            }
+        }
+        for (const std::string& callee : next) {
+            if (callee == to || reaches(analysis, callee, to, visited))
+                return true;
+        }
+        return false;
+    }
+}  // namespace
+
+FunctionAttrsAnalysis analyzeFunctionAttrs(ProgramNode* program) {
+    FunctionFactsWalker walker;
+    walker.walk(program);
+    FunctionAttrsAnalysis analysis = std::move(walker.analysis);
+
+    // Callee effects become the caller's, unknown callees may touch anything
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [name, facts] : analysis.functions) {
+            if (!facts.isDefined)
+                continue;
+            bool reads = facts.readsOtherMem, writes = facts.writesOtherMem;
+            if (facts.hasIndirectCalls)
+                reads = writes = true;
+            for (const std::string& callee : facts.callees) {
+                const FunctionFacts* calleeFacts = analysis.lookup(callee);
+                if (!calleeFacts || !calleeFacts->isDefined) {
+                    reads = writes = true;
+                    continue;
+                }
+                reads |= calleeFacts->readsArgMem || calleeFacts->readsOtherMem;
+                writes |= calleeFacts->writesArgMem || calleeFacts->writesOtherMem;
+            }
+            if (reads != facts.readsOtherMem || writes != facts.writesOtherMem) {
+                facts.readsOtherMem = reads;
+                facts.writesOtherMem = writes;
+                changed = true;
+            }
+        }
+    }
+
+    // Unknown code can only call back into functions whose address escaped
+    for (auto& [name, facts] : analysis.functions) {
+        if (!facts.isDefined || facts.addressTaken)
+            continue;
+        std::unordered_set<std::string> visited;
+        facts.noRecurse = !reaches(analysis, name, name, visited);
+    }
+
+    // willreturn: no loops, no recursion and every callee returns as well
+    for (auto& [name, facts] : analysis.functions) {
+        facts.willReturn = facts.isDefined && facts.noRecurse && !facts.hasLoops &&
+                           !facts.hasIndirectCalls;
+    }
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [name, facts] : analysis.functions) {
+            if (!facts.willReturn)
+                continue;
+            for (const std::string& callee : facts.callees) {
+                const FunctionFacts* calleeFacts = analysis.lookup(callee);
+                if (!calleeFacts || !calleeFacts->willReturn) {
+                    facts.willReturn = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    return analysis;
+}
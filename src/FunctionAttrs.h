@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "AST/forwardDecl.h"
+
+
+// What the AST proves about a function, used by --whole-program to pick linkage, calling
+// convention and attributes. Functions without a body (runtime externs) are unknown
+struct FunctionFacts {
+    bool isDefined = false;
+    bool addressTaken = false;  // Used other than as a direct callee
+    bool hasLoops = false;
+    bool hasIndirectCalls = false;
+    std::unordered_set<std::string> callees;
+
+    // Memory visible to the caller: through pointer parameters or anything else
+    bool readsArgMem = false;
+    bool writesArgMem = false;
+    bool readsOtherMem = false;
+    bool writesOtherMem = false;
+
+    bool noRecurse = false;
+    bool willReturn = false;
+};
+
+struct FunctionAttrsAnalysis {
+    std::unordered_map<std::string, FunctionFacts> functions;
+
+    const FunctionFacts* lookup(const std::string& name) const {
+        auto it = functions.find(name);
+        return it != functions.end() ? &it->second : nullptr;
+    }
+};
+
+FunctionAttrsAnalysis analyzeFunctionAttrs(ProgramNode* program);
@@ -0,0 +1,195 @@
+#include "IRStats.h"
+
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+#include <llvm/ADT/Statistic.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <nlohmann/json.hpp>
+
+
+using namespace llvm;
+
+namespace {
+    const char* opcodeClass(const Instruction& inst) {
+        if (inst.isTerminator())
+            return "terminator";
+        if (inst.isShift() || inst.isBitwiseLogicOp())
+            return "bitwise";
+        if (inst.isBinaryOp() || inst.isUnaryOp())
+            return "arithmetic";
+        if (inst.isCast())
+            return "cast";
+        switch (inst.getOpcode()) {
+            case Instruction::Alloca:
+            case Instruction::Load:
+            case Instruction::Store:
+            case Instruction::GetElementPtr:
+            case Instruction::Fence:
+            case Instruction::AtomicCmpXchg:
+            case Instruction::AtomicRMW:
+                return "memory";
+            case Instruction::ICmp:
+            case Instruction::FCmp:
+                return "compare";
+            case Instruction::Call:
+                return "call";
+            case Instruction::PHI:
+            case Instruction::Select:
+                return "phi/select";
+            default:
+                return "other";
+        }
+    }
+
+    FunctionStats collectFunctionStats(const Function& function) {
+        FunctionStats stats;
+        stats.name = function.getName().str();
+        for (const BasicBlock& block : function) {
+            stats.blocks++;
+            for (const Instruction& inst : block) {
+                stats.instructions++;
+                stats.opcodeClasses[opcodeClass(inst)]++;
+
+                if (isa<AllocaInst>(inst)) {
+                    stats.allocas++;
+                } else if (isa<LoadInst>(inst)) {
+                    stats.loads++;
+                } else if (isa<StoreInst>(inst)) {
+                    stats.stores++;
+                } else if (isa<IntrinsicInst>(inst)) {
+                    stats.intrinsicCalls++;
+                } else if (const auto* call = dyn_cast<CallBase>(&inst)) {
+                    if (call->getCalledFunction())
+                        stats.directCalls++;
+                    else
+                        stats.indirectCalls++;
+                }
+            }
+        }
+        return stats;
+    }
+
+    std::string opcodeSummary(const FunctionStats& stats) {
+        std::string summary;
+        for (const auto& [name, count] : stats.opcodeClasses) {
+            if (!summary.empty())
+                summary += " ";
+            summary += name + "=" + std::to_string(count);
+        }
+        return summary;
+    }
+}  // namespace
+
+ModuleStats collectIRStats(
+    const Module& module,
+    const std::string& stage,
+    const std::set<std::string>* only
+) {
+    ModuleStats stats;
+    stats.stage = stage;
+    for (const Function& function : module) {
+        if (function.isDeclaration())
+            stats.declarations++;
+        else if (!only || only->count(function.getName().str()))
+            stats.functions.push_back(collectFunctionStats(function));
+    }
+    for (const GlobalVariable& global : module.globals()) {
+        if (!global.isConstant())
+            stats.variables++;
+        else if (global.getName().starts_with(".str"))
+            stats.stringConstants++;
+        else
+            stats.constantGlobals++;
+    }
+    return stats;
+}
+
+void enableLLVMStatistics() {
+    EnableStatistics(false);
+}
+
+void printIRStats(const std::vector<ModuleStats>& stats, std::ostream& out) {
+    for (const ModuleStats& module : stats) {
+        out << "IR statistics after " << module.stage << ":\n"
+            << std::left << std::setw(24) << "function" << std::right << std::setw(8) << "blocks"
+            << std::setw(8) << "insts" << std::setw(8) << "allocas" << std::setw(8) << "loads"
+            << std::setw(8) << "stores" << std::setw(8) << "direct" << std::setw(10)
+            << "indirect" << std::setw(8) << "intrin" << "  by class\n";
+
+        FunctionStats total;
+        total.name = "total";
+        for (const FunctionStats& function : module.functions) {
+            out << std::left << std::setw(24) << function.name << std::right << std::setw(8)
+                << function.blocks << std::setw(8) << function.instructions << std::setw(8)
+                << function.allocas << std::setw(8) << function.loads << std::setw(8)
+                << function.stores << std::setw(8) << function.directCalls << std::setw(10)
+                << function.indirectCalls << std::setw(8) << function.intrinsicCalls << "  "
+                << opcodeSummary(function) << "\n";
+
+            total.blocks += function.blocks;
+            total.instructions += function.instructions;
+            total.allocas += function.allocas;
+            total.loads += function.loads;
+            total.stores += function.stores;
+            total.directCalls += function.directCalls;
+            total.indirectCalls += function.indirectCalls;
+            total.intrinsicCalls += function.intrinsicCalls;
+        }
+        out << std::left << std::setw(24) << total.name << std::right << std::setw(8)
+            << total.blocks << std::setw(8) << total.instructions << std::setw(8) << total.allocas
+            << std::setw(8) << total.loads << std::setw(8) << total.stores << std::setw(8)
+            << total.directCalls << std::setw(10) << total.indirectCalls << std::setw(8)
+            << total.intrinsicCalls << "\n";
+        out << "globals: " << module.stringConstants << " strings, " << module.constantGlobals
+            << " other constants, " << module.variables << " variables; "
+            << module.declarations << " external functions\n\n";
+    }
+
+    if (!AreStatisticsEnabled())
+        return;
+    out << "LLVM statistics:\n";
+    for (const auto& [name, value] : GetStatistics())
+        out << "  " << std::left << std::setw(56) << name.str() << std::right << value << "\n";
+}
+
+void writeIRStatsJSON(const std::vector<ModuleStats>& stats, const std::string& filename) {
+    nlohmann::json stages = nlohmann::json::array();
+    for (const ModuleStats& module : stats) {
+        nlohmann::json functions = nlohmann::json::array();
+        for (const FunctionStats& function : module.functions) {
+            functions.push_back({
+                {"name", function.name},
+                {"blocks", function.blocks},
+                {"instructions", function.instructions},
+                {"opcodeClasses", function.opcodeClasses},
+                {"allocas", function.allocas},
+                {"loads", function.loads},
+                {"stores", function.stores},
+                {"directCalls", function.directCalls},
+                {"indirectCalls", function.indirectCalls},
+                {"intrinsicCalls", function.intrinsicCalls},
+            });
+        }
+        stages.push_back({
+            {"stage", module.stage},
+            {"functions", functions},
+            {"declarations", module.declarations},
+            {"stringConstants", module.stringConstants},
+            {"constantGlobals", module.constantGlobals},
+            {"variables", module.variables},
+        });
+    }
+
+    nlohmann::json llvmStatistics = nlohmann::json::object();
+    for (const auto& [name, value] : GetStatistics())
+        llvmStatistics[name.str()] = value;
+
+    std::ofstream file(filename);
+    if (!file.is_open())
+        throw std::runtime_error("Could not write IR statistics: " + filename);
+    file << nlohmann::json{{"stages", stages}, {"llvmStatistics", llvmStatistics}}.dump(2) << "\n";
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <llvm/IR/Module.h>
+
+
+// Size of the generated code for --stats, collected after generate and after optimize
+struct FunctionStats {
+    std::string name;
+    unsigned blocks = 0;
+    unsigned instructions = 0;
+    std::map<std::string, unsigned> opcodeClasses;  // "arithmetic", "memory", "call", ...
+    unsigned allocas = 0;
+    unsigned loads = 0;
+    unsigned stores = 0;
+    unsigned directCalls = 0;
+    unsigned indirectCalls = 0;
+    unsigned intrinsicCalls = 0;
+};
+
+struct ModuleStats {
+    std::string stage;
+    std::vector<FunctionStats> functions;  // Definitions only
+    unsigned declarations = 0;
+    unsigned stringConstants = 0;  // .str globals
+    unsigned constantGlobals = 0;  // Other constants, e.g. initializer images
+    unsigned variables = 0;
+};
+
+// Definitions not in only, when given, are left out, e.g. what is left of the linked runtime
+ModuleStats collectIRStats(
+    const llvm::Module& module,
+    const std::string& stage,
+    const std::set<std::string>* only = nullptr
+);
+
+// LLVM's own Statistic counters, only counted when LLVM was built with statistics enabled
+void enableLLVMStatistics();
+
+void printIRStats(const std::vector<ModuleStats>& stats, std::ostream& out);
+void writeIRStatsJSON(const std::vector<ModuleStats>& stats, const std::string& filename);
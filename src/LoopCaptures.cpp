@@ -0,0 +1,45 @@
+#include "LoopCaptures.h"
+
+#include "AST/ASTWalker.h"
+#include "AST/includeNodes.h"
+
+
+namespace {
+
+    class LoopCapturesWalker : public ASTWalker {
+      public:
+        LoopCaptures captures;
+
+        void visitExpression(ExpressionNode* node) override {
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(node)) {
+                captures.used.insert(id->name);
+            } else if (auto* bin = dynamic_cast<BinaryExprNode*>(node)) {
+                if (bin->op == "=")
+                    markWritten(bin->left);
+            } else if (auto* un = dynamic_cast<UnaryExprNode*>(node)) {
+                if (un->op == "++" || un->op == "--" || un->op == "&")
+                    markWritten(un->operand);
+            }
+        }
+
+      private:
+        // The variable holding the target, a store through a pointer leaves the pointer as is
+        void markWritten(ExpressionNode* target) {
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(target)) {
+                captures.written.insert(id->name);
+            } else if (auto* index = dynamic_cast<IndexExprNode*>(target)) {
+                if (!dynamic_cast<PointerTypeNode*>(index->array->resolvedType))
+                    markWritten(index->array);  // Array element or vector lane
+            } else if (auto* member = dynamic_cast<MemberExprNode*>(target)) {
+                if (!member->arrowAccess)
+                    markWritten(member->object);
+            }
+        }
+    };
+}  // namespace
+
+LoopCaptures analyzeLoopCaptures(StatementNode* body) {
+    LoopCapturesWalker walker;
+    walker.walk(body);
+    return std::move(walker.captures);
+}
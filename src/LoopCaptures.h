@@ -0,0 +1,22 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_set>
+
+#include "AST/forwardDecl.h"
+
+
+// Names a parallel for body uses, CodeGen::visitParallelForStatement passes the ones that are
+// locals of the enclosing function to the outlined body. Scopes are ignored like in ArrayUsage,
+// names declared in the body count too and resolve to no local or one it shadows
+struct LoopCaptures {
+    std::set<std::string> used;  // Ordered, the captures struct must not depend on hashing
+    // Assigned, ++/-- or address taken, also an element or field of it
+    std::unordered_set<std::string> written;
+
+    // Unchanged by the body, so every thread may work on its own copy
+    bool isReadOnly(const std::string& name) const { return !written.count(name); }
+};
+
+LoopCaptures analyzeLoopCaptures(StatementNode* body);
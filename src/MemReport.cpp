@@ -0,0 +1,308 @@
+#include "MemReport.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <malloc.h>
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <sys/resource.h>
+#include <mach/mach.h>
+#else
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+    std::atomic<bool> counting{false};
+    std::atomic<std::size_t> allocations{0};
+    std::atomic<std::size_t> frees{0};
+    std::atomic<std::size_t> bytesAllocated{0};
+    // Signed, memory from before counting started is subtracted when it is freed
+    std::atomic<long long> liveBytes{0};
+
+    // What the allocator really handed out, so live bytes balance on delete without a header
+    std::size_t usableSize(void* ptr, std::size_t alignment) {
+#if defined(_WIN32)
+        return alignment ? _aligned_msize(ptr, alignment, 0) : _msize(ptr);
+#elif defined(__APPLE__)
+        (void)alignment;
+        return malloc_size(ptr);
+#else
+        (void)alignment;
+        return malloc_usable_size(ptr);
+#endif
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment) {
+        if (size == 0)
+            size = 1;
+
+        void* ptr;
+        if (alignment) {
+#if defined(_WIN32)
+            ptr = _aligned_malloc(size, alignment);
+#else
+            // aligned_alloc wants a multiple of the alignment
+            ptr = aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+        } else {
+            ptr = std::malloc(size);
+        }
+
+        if (ptr && counting.load(std::memory_order_relaxed)) {
+            std::size_t bytes = usableSize(ptr, alignment);
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+            liveBytes.fetch_add(static_cast<long long>(bytes), std::memory_order_relaxed);
+        }
+        return ptr;
+    }
+
+    void deallocate(void* ptr, std::size_t alignment) {
+        if (!ptr)
+            return;
+        if (counting.load(std::memory_order_relaxed)) {
+            frees.fetch_add(1, std::memory_order_relaxed);
+            liveBytes.fetch_sub(
+                static_cast<long long>(usableSize(ptr, alignment)), std::memory_order_relaxed
+            );
+        }
+#if defined(_WIN32)
+        if (alignment) {
+            _aligned_free(ptr);
+            return;
+        }
+#else
+        (void)alignment;
+#endif
+        std::free(ptr);
+    }
+
+    void* allocateOrThrow(std::size_t size, std::size_t alignment) {
+        while (true) {
+            if (void* ptr = allocate(size, alignment))
+                return ptr;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void sampleRss(std::size_t& rss, std::size_t& peakRss) {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            rss = counters.WorkingSetSize;
+            peakRss = counters.PeakWorkingSetSize;
+        }
+#elif defined(__APPLE__)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) ==
+            KERN_SUCCESS)
+            rss = info.resident_size;
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            peakRss = usage.ru_maxrss;  // Bytes on macOS
+#else
+        std::ifstream statm("/proc/self/statm");
+        std::size_t size = 0, resident = 0;
+        if (statm >> size >> resident)
+            rss = resident * sysconf(_SC_PAGESIZE);
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            peakRss = static_cast<std::size_t>(usage.ru_maxrss) * 1024;  // KiB on Linux
+#endif
+    }
+
+    std::string formatBytes(double bytes) {
+        const char* units[] = {"B", "KiB", "MiB", "GiB"};
+        int unit = 0;
+        bool negative = bytes < 0;
+        if (negative)
+            bytes = -bytes;
+        while (bytes >= 1024 && unit < 3) {
+            bytes /= 1024;
+            unit++;
+        }
+        std::ostringstream out;
+        out << (negative ? "-" : "") << std::fixed << std::setprecision(unit ? 1 : 0) << bytes
+            << " " << units[unit];
+        return out.str();
+    }
+}  // namespace
+
+MemReport::MemReport() {
+    m_allocations = allocations;
+    m_frees = frees;
+    m_bytesAllocated = bytesAllocated;
+    m_liveBytes = liveBytes;
+    counting = true;
+}
+
+MemReport::~MemReport() {
+    counting = false;
+}
+
+void MemReport::endPhase() {
+    // Snapshot before the phase record itself allocates
+    std::size_t allocationsNow = allocations;
+    std::size_t freesNow = frees;
+    std::size_t bytesNow = bytesAllocated;
+    long long liveNow = liveBytes;
+
+    Phase phase;
+    phase.allocations = allocationsNow - m_allocations;
+    phase.frees = freesNow - m_frees;
+    phase.bytesAllocated = bytesNow - m_bytesAllocated;
+    phase.liveBytesDelta = liveNow - m_liveBytes;
+    phase.liveBytes = liveNow;
+    sampleRss(phase.rss, phase.peakRss);
+
+    bool wasCounting = counting.exchange(false);
+    phase.name = m_current;
+    m_phases.push_back(std::move(phase));
+    counting = wasCounting;
+
+    m_allocations = allocations;
+    m_frees = frees;
+    m_bytesAllocated = bytesAllocated;
+    m_liveBytes = liveBytes;
+}
+
+void MemReport::beginPhase(const std::string& name) {
+    endPhase();
+    bool wasCounting = counting.exchange(false);
+    m_current = name;
+    counting = wasCounting;
+    m_allocations = allocations;
+    m_frees = frees;
+    m_bytesAllocated = bytesAllocated;
+    m_liveBytes = liveBytes;
+}
+
+void MemReport::finish() {
+    if (m_finished)
+        return;
+    endPhase();
+    counting = false;
+    m_finished = true;
+}
+
+void MemReport::printTable(std::ostream& out) const {
+    out << "Memory report:\n"
+        << std::left << std::setw(12) << "phase" << std::right << std::setw(12) << "allocs"
+        << std::setw(12) << "frees" << std::setw(14) << "allocated" << std::setw(14)
+        << "live delta" << std::setw(14) << "live" << std::setw(14) << "rss" << std::setw(14)
+        << "peak rss" << "\n";
+    for (const Phase& phase : m_phases) {
+        out << std::left << std::setw(12) << phase.name << std::right << std::setw(12)
+            << phase.allocations << std::setw(12) << phase.frees << std::setw(14)
+            << formatBytes(phase.bytesAllocated) << std::setw(14)
+            << formatBytes(phase.liveBytesDelta) << std::setw(14) << formatBytes(phase.liveBytes)
+            << std::setw(14) << formatBytes(phase.rss) << std::setw(14)
+            << formatBytes(phase.peakRss) << "\n";
+    }
+}
+
+void MemReport::writeJSON(const std::string& filename) const {
+    nlohmann::json phases = nlohmann::json::array();
+    for (const Phase& phase : m_phases) {
+        phases.push_back({
+            {"phase", phase.name},
+            {"allocations", phase.allocations},
+            {"frees", phase.frees},
+            {"bytesAllocated", phase.bytesAllocated},
+            {"liveBytesDelta", phase.liveBytesDelta},
+            {"liveBytes", phase.liveBytes},
+            {"rss", phase.rss},
+            {"peakRss", phase.peakRss},
+        });
+    }
+
+    std::ofstream file(filename);
+    if (!file.is_open())
+        throw std::runtime_error("Could not write memory report: " + filename);
+    file << nlohmann::json{{"phases", phases}}.dump(2) << "\n";
+}
+
+// Replaceable global allocation functions, every form funnels into allocate/deallocate
+void* operator new(std::size_t size) {
+    return allocateOrThrow(size, 0);
+}
+void* operator new[](std::size_t size) {
+    return allocateOrThrow(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr, 0);
+}
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr, 0);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+    deallocate(ptr, 0);
+}
+void operator delete[](void* ptr, std::size_t) noexcept {
+    deallocate(ptr, 0);
+}
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr, 0);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr, 0);
+}
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+// Per-phase allocation accounting for --mem-report. The replaced global operator new and
+// delete count every allocation made through them (the nlohmann DOM, AST nodes, Context
+// maps, LLVM IR) while the report is enabled; plain malloc calls are not seen
+class MemReport {
+  public:
+    struct Phase {
+        std::string name;
+        std::size_t allocations = 0;
+        std::size_t frees = 0;
+        std::size_t bytesAllocated = 0;
+        long long liveBytesDelta = 0;  // Change in bytes held through operator new
+        long long liveBytes = 0;       // At the end of the phase, relative to the start
+        std::size_t rss = 0;           // Resident set size at the end of the phase
+        std::size_t peakRss = 0;
+    };
+
+    // Starts counting, everything up to the first phase is attributed to "startup"
+    MemReport();
+    ~MemReport();
+
+    // Ends the running phase and starts the next one
+    void beginPhase(const std::string& name);
+    // Ends the running phase and stops counting
+    void finish();
+
+    void printTable(std::ostream& out) const;
+    void writeJSON(const std::string& filename) const;
+
+  private:
+    std::vector<Phase> m_phases;
+    std::string m_current = "startup";
+    std::size_t m_allocations = 0;  // Counters at the start of the running phase
+    std::size_t m_frees = 0;
+    std::size_t m_bytesAllocated = 0;
+    long long m_liveBytes = 0;
+    bool m_finished = false;
+
+    void endPhase();
+};
@@ -0,0 +1,93 @@
+#include "NativeEmit.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+
+
+using namespace llvm;
+
+void emitNative(
+    Module& module, TargetMachine& targetMachine, raw_pwrite_stream& out, CodeGenFileType fileType
+) {
+    // The machine pipeline is only available through the legacy pass manager
+    legacy::PassManager passes;
+    if (targetMachine.addPassesToEmitFile(passes, out, nullptr, fileType))
+        throw std::runtime_error("The target cannot emit this file type");
+    passes.run(module);
+}
+
+void emitNativeFile(Module& module, TargetMachine& targetMachine, const std::string& filename) {
+    bool assembly = sys::path::extension(filename) == ".s";
+    std::error_code EC;
+    raw_fd_ostream file(filename, EC, assembly ? sys::fs::OF_Text : sys::fs::OF_None);
+    if (EC)
+        throw std::runtime_error("Could not open " + filename + ": " + EC.message());
+    emitNative(
+        module, targetMachine, file,
+        assembly ? CodeGenFileType::AssemblyFile : CodeGenFileType::ObjectFile
+    );
+}
+
+void benchmarkBackends(
+    const Module& module, TargetConfig config, unsigned optLevel, unsigned minFunctions,
+    std::ostream& out
+) {
+    // Synthetic input of the requested size, made of copies of the program's own functions
+    std::unique_ptr<Module> input = CloneModule(module);
+    std::vector<Function*> originals;
+    for (Function& function : *input) {
+        if (!function.isDeclaration())
+            originals.push_back(&function);
+    }
+    if (originals.empty())
+        throw std::runtime_error("--bench-codegen needs at least one function definition");
+
+    size_t functions = originals.size();
+    while (functions < minFunctions) {
+        for (Function* function : originals) {
+            ValueToValueMapTy map;
+            CloneFunction(function, map);
+        }
+        functions += originals.size();
+    }
+    size_t instructions = 0;
+    for (Function& function : *input)
+        instructions += function.getInstructionCount();
+    out << "codegen: " << functions << " functions, " << instructions << " instructions, -O"
+        << optLevel << "\n";
+
+    double baseline = 0;
+    for (CodeGenBackend backend :
+         {CodeGenBackend::Default, CodeGenBackend::Fast, CodeGenBackend::GlobalISel}) {
+        config.backend = backend;
+        std::unique_ptr<TargetMachine> targetMachine = createTargetMachine(config, optLevel);
+
+        // Emission changes the module, every run starts from a fresh copy
+        double best = 0;
+        size_t objectSize = 0;
+        for (int run = 0; run < 3; run++) {
+            std::unique_ptr<Module> copy = CloneModule(*input);
+            SmallVector<char, 0> object;
+            raw_svector_ostream stream(object);
+            auto start = std::chrono::steady_clock::now();
+            emitNative(*copy, *targetMachine, stream, CodeGenFileType::ObjectFile);
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            if (run == 0 || seconds.count() < best)
+                best = seconds.count();
+            objectSize = object.size();
+        }
+        if (backend == CodeGenBackend::Default)
+            baseline = best;
+        out << "  " << backendName(backend) << ": " << best * 1000 << " ms, "
+            << static_cast<uint64_t>(functions / best) << " functions/s, " << objectSize / 1024
+            << " KiB, speedup " << baseline / best << "x\n";
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "Target.h"
+
+
+// Runs the machine pipeline of targetMachine over module, which must use its DataLayout
+void emitNative(
+    llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_pwrite_stream& out,
+    llvm::CodeGenFileType fileType
+);
+// Assembly for a .s file, object code otherwise
+void emitNativeFile(
+    llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& filename
+);
+
+// Compiles copies of the functions in module, at least minFunctions of them, to object code
+// with every backend and reports functions per second against the Default backend
+void benchmarkBackends(
+    const llvm::Module& module, TargetConfig config, unsigned optLevel, unsigned minFunctions,
+    std::ostream& out
+);
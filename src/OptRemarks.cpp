@@ -0,0 +1,155 @@
+#include "OptRemarks.h"
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/LLVMRemarkStreamer.h>
+#include <llvm/Remarks/RemarkStreamer.h>
+#include <llvm/Support/Regex.h>
+
+
+using namespace llvm;
+
+namespace {
+
+    // Receives every remark after the remark streamer wrote it to the file
+    class RemarkCollector : public DiagnosticHandler {
+      public:
+        RemarkCollector(std::vector<OptRemarks::Remark>& remarks, const std::string& filter)
+            : m_remarks(remarks) {
+            if (!filter.empty())
+                m_filter = std::make_unique<Regex>(filter);
+        }
+
+        bool isAnalysisRemarkEnabled(StringRef passName) const override {
+            return matches(passName);
+        }
+        bool isMissedOptRemarkEnabled(StringRef passName) const override {
+            return matches(passName);
+        }
+        bool isPassedOptRemarkEnabled(StringRef passName) const override {
+            return matches(passName);
+        }
+        bool isAnyRemarkEnabled() const override { return true; }
+
+        bool handleDiagnostics(const DiagnosticInfo& DI) override {
+            auto* remark = dyn_cast<DiagnosticInfoOptimizationBase>(&DI);
+            if (!remark)
+                return false;  // Not a remark, let LLVM print warnings and errors as usual
+            if (!matches(remark->getPassName()))
+                return true;
+
+            OptRemarks::Remark entry;
+            if (remark->isPassed()) {
+                entry.kind = OptRemarks::Remark::Passed;
+            } else if (remark->isMissed()) {
+                entry.kind = OptRemarks::Remark::Missed;
+            } else {
+                entry.kind = OptRemarks::Remark::Analysis;
+            }
+            entry.function = remark->getFunction().getName().str();
+            entry.pass = remark->getPassName().str();
+            entry.message = remark->getMsg();
+            if (remark->isLocationAvailable()) {
+                entry.line = remark->getLocation().getLine();
+                entry.column = remark->getLocation().getColumn();
+            }
+            m_remarks.push_back(std::move(entry));
+            return true;
+        }
+
+      private:
+        bool matches(StringRef passName) const { return !m_filter || m_filter->match(passName); }
+
+        std::vector<OptRemarks::Remark>& m_remarks;
+        std::unique_ptr<Regex> m_filter;
+    };
+
+    const char* kindName(OptRemarks::Remark::Kind kind) {
+        switch (kind) {
+            case OptRemarks::Remark::Passed: return "passed";
+            case OptRemarks::Remark::Missed: return "missed";
+            case OptRemarks::Remark::Analysis: return "analysis";
+        }
+        return "";
+    }
+}  // namespace
+
+OptRemarks::OptRemarks(LLVMContext& context, const std::string& filename, const std::string& filter)
+    : m_context(context) {
+    if (!filter.empty()) {
+        std::string regexError;
+        if (!Regex(filter).isValid(regexError)) {
+            throw std::runtime_error("Invalid --remarks-filter: " + regexError);
+        }
+    }
+
+    // No file means the remarks are only collected for the summary
+    if (!filename.empty()) {
+        StringRef format = StringRef(filename).ends_with(".bitstream") ? "bitstream" : "yaml";
+        Expected<std::unique_ptr<ToolOutputFile>> file =
+            setupLLVMOptimizationRemarks(context, filename, filter, format, false);
+        if (Error error = file.takeError()) {
+            throw std::runtime_error("Could not open remarks file: " + toString(std::move(error)));
+        }
+        m_file = std::move(*file);
+    }
+
+    context.setDiagnosticHandler(std::make_unique<RemarkCollector>(m_remarks, filter));
+}
+
+OptRemarks::~OptRemarks() {
+    // The collector points into this object and the streamer writes into m_file
+    m_context.setDiagnosticHandler(std::make_unique<DiagnosticHandler>());
+    m_context.setLLVMRemarkStreamer(nullptr);
+    m_context.setMainRemarkStreamer(nullptr);
+}
+
+void OptRemarks::finish() {
+    if (m_file) {
+        m_file->os().flush();
+        m_file->keep();
+    }
+}
+
+void OptRemarks::printSummary(std::ostream& out) const {
+    // Group per function, duplicates come from the same remark being emitted for several passes
+    std::map<std::string, std::vector<const Remark*>> byFunction;
+    std::set<std::tuple<std::string, unsigned, unsigned, std::string, std::string>> seen;
+    for (const Remark& remark : m_remarks) {
+        if (!seen.insert({remark.function, remark.line, remark.column, remark.pass, remark.message})
+                 .second) {
+            continue;
+        }
+        byFunction[remark.function].push_back(&remark);
+    }
+
+    out << "\n=== Optimization remarks ===\n";
+    if (byFunction.empty()) {
+        out << "(none)\n";
+    }
+    for (const auto& [function, remarks] : byFunction) {
+        unsigned counts[3] = {0, 0, 0};
+        for (const Remark* remark : remarks) {
+            counts[remark->kind]++;
+        }
+        out << function << ": " << counts[Remark::Passed] << " passed, "
+            << counts[Remark::Missed] << " missed, " << counts[Remark::Analysis] << " analysis\n";
+
+        for (const Remark* remark : remarks) {
+            out << "  ";
+            if (remark->line) {
+                out << remark->line << ":" << remark->column;
+            } else {
+                out << "?:?";
+            }
+            out << " " << kindName(remark->kind) << " " << remark->pass << ": " << remark->message
+                << "\n";
+        }
+    }
+    out << "\n";
+}
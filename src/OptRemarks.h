@@ -0,0 +1,43 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/ToolOutputFile.h>
+
+
+// Collects LLVM optimization remarks (passed, missed, analysis) emitted while optimizing a module.
+// Every remark is streamed to a YAML or bitstream file and a copy is kept for a per-function summary
+class OptRemarks {
+  public:
+    struct Remark {
+        enum Kind {
+            Passed,
+            Missed,
+            Analysis
+        };
+
+        Kind kind;
+        std::string function;
+        std::string pass;
+        std::string message;
+        unsigned line = 0;
+        unsigned column = 0;
+    };
+
+    // filter is a regex on pass names, empty keeps all remarks.
+    // The format is bitstream for *.bitstream files and YAML otherwise
+    OptRemarks(llvm::LLVMContext& context, const std::string& filename, const std::string& filter);
+    ~OptRemarks();
+
+    void finish();  // Flush and keep the remarks file
+    void printSummary(std::ostream& out) const;
+
+  private:
+    llvm::LLVMContext& m_context;
+    std::unique_ptr<llvm::ToolOutputFile> m_file;
+    std::vector<Remark> m_remarks;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+// Runs body(worker, i) for i in [0, count) on up to jobs threads, items are handed out one
+// at a time so uneven items still balance. worker is in [0, workers) and stable per thread.
+// The first exception thrown by body is rethrown once all threads are done
+template <typename Body>
+void parallelFor(std::size_t count, unsigned jobs, Body body) {
+    unsigned workers = static_cast<unsigned>(std::min<std::size_t>(std::max(jobs, 1u), count));
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+
+    auto worker = [&](unsigned id) {
+        for (std::size_t i = next++; i < count && !failed; i = next++) {
+            try {
+                body(id, i);
+            } catch (...) {
+                if (!failed.exchange(true))
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned id = 1; id < workers; id++)
+        threads.emplace_back(worker, id);
+    worker(0);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
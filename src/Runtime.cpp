@@ -0,0 +1,33 @@
+#include "Runtime.h"
+
+#include <cstddef>
+#include <stdexcept>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/Error.h>
+
+
+using namespace llvm;
+
+// Generated by cmake/EmbedFile.cmake
+extern const unsigned char runtime_bitcode[];
+extern const size_t runtime_bitcode_size;
+
+MemoryBufferRef runtimeBitcode() {
+    return MemoryBufferRef(
+        StringRef(reinterpret_cast<const char*>(runtime_bitcode), runtime_bitcode_size),
+        "runtime.bc"
+    );
+}
+
+void linkRuntime(Module& module) {
+    Expected<std::unique_ptr<Module>> runtime =
+        parseBitcodeFile(runtimeBitcode(), module.getContext());
+    if (!runtime)
+        throw std::runtime_error("Invalid runtime bitcode: " + toString(runtime.takeError()));
+
+    // Only what the program calls (and what that depends on) is pulled in
+    if (Linker::linkModules(module, std::move(*runtime), Linker::Flags::LinkOnlyNeeded))
+        throw std::runtime_error("Could not link the runtime into " + module.getName().str());
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBufferRef.h>
+
+
+// test/runtime.c as ThinLTO bitcode, embedded at build time
+llvm::MemoryBufferRef runtimeBitcode();
+
+// Links the runtime functions the module uses into it, so they can be inlined
+void linkRuntime(llvm::Module& module);
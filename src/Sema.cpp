@@ -0,0 +1,787 @@
+#include "Sema.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AST/includeNodes.h"
+#include "Builtins.h"
+
+
+namespace {
+
+    struct Symbol {
+        TypeNode* type = nullptr;             // Declared type, ArrayTypeNode for arrays
+        FunctionDeclNode* function = nullptr;  // Set for function names, type is null then
+        DeclarationNode* variable = nullptr;   // Variable or parameter otherwise
+    };
+
+    class TypeChecker {
+      public:
+        explicit TypeChecker(ProgramNode* program) : m_program(program) {}
+
+        void run() {
+            m_program->arenas.push_back(std::make_unique<ASTArena>());
+            ASTArena::Scope arenaScope(*m_program->arenas.back());
+            m_int = new PrimitiveTypeNode(PrimitiveTypeNode::Int);
+            m_double = new PrimitiveTypeNode(PrimitiveTypeNode::Double);
+            m_char = new PrimitiveTypeNode(PrimitiveTypeNode::Char);
+            m_string = new PointerTypeNode(m_char);
+
+            // Functions and types may be used before the declaration that defines them
+            m_scopes.emplace_back();
+            for (auto* declaration : m_program->declarations) {
+                if (auto* func = dynamic_cast<FunctionDeclNode*>(declaration)) {
+                    m_scopes.back()[func->identifier] = {nullptr, func};
+                } else {
+                    declareType(declaration);
+                }
+            }
+            for (auto* declaration : m_program->declarations) {
+                checkDeclaration(declaration);
+            }
+        }
+
+      private:
+        [[noreturn]] void error(const SourceLocation& location, const std::string& message) {
+            if (!location.isValid())
+                throw std::runtime_error(message);
+            throw std::runtime_error(
+                std::to_string(location.line) + ":" + std::to_string(location.column) + ": " +
+                message
+            );
+        }
+
+        void declareType(DeclarationNode* node) {
+            if (auto* structDecl = dynamic_cast<StructDeclNode*>(node)) {
+                if (!structDecl->fields.empty())
+                    m_structs[structDecl->identifier] = structDecl;
+            } else if (auto* funcPtr = dynamic_cast<FunctionPtrDeclNode*>(node)) {
+                m_functionPtrs[funcPtr->identifier] = funcPtr;
+            }
+        }
+
+        const Symbol* lookup(const std::string& name) const {
+            for (auto scope = m_scopes.rbegin(); scope != m_scopes.rend(); ++scope) {
+                auto it = scope->find(name);
+                if (it != scope->end())
+                    return &it->second;
+            }
+            return nullptr;
+        }
+
+        StructDeclNode* structOf(TypeNode* type) const {
+            auto* named = dynamic_cast<NamedTypeNode*>(type);
+            if (!named)
+                return nullptr;
+            auto it = m_structs.find(named->identifier);
+            return it != m_structs.end() ? it->second : nullptr;
+        }
+
+        FunctionPtrDeclNode* functionPtrOf(TypeNode* type) const {
+            auto* named = dynamic_cast<NamedTypeNode*>(type);
+            if (!named)
+                return nullptr;
+            auto it = m_functionPtrs.find(named->identifier);
+            return it != m_functionPtrs.end() ? it->second : nullptr;
+        }
+
+        static bool isPrimitive(TypeNode* type, PrimitiveTypeNode::Kind kind) {
+            auto* prim = dynamic_cast<PrimitiveTypeNode*>(type);
+            return prim && prim->kind == kind;
+        }
+
+        static bool isPointer(TypeNode* type) { return dynamic_cast<PointerTypeNode*>(type); }
+
+        static PrimitiveTypeNode* vectorOf(TypeNode* type) {
+            auto* prim = dynamic_cast<PrimitiveTypeNode*>(type);
+            return prim && prim->isVector() ? prim : nullptr;
+        }
+
+        PrimitiveTypeNode* primitive(PrimitiveTypeNode::Kind kind) {
+            switch (kind) {
+                case PrimitiveTypeNode::Int: return m_int;
+                case PrimitiveTypeNode::Double: return m_double;
+                case PrimitiveTypeNode::Char: return m_char;
+                default: return new PrimitiveTypeNode(kind);
+            }
+        }
+
+        // Vectors only take a vector of the same type or a scalar, which fills every lane
+        void checkAssignable(const SourceLocation& location, TypeNode* target, TypeNode* value) {
+            PrimitiveTypeNode* targetVector = vectorOf(target);
+            PrimitiveTypeNode* valueVector = vectorOf(value);
+            if (valueVector && (!targetVector || targetVector->kind != valueVector->kind)) {
+                error(
+                    location, std::string("Cannot convert ") +
+                                  PrimitiveTypeNode::kindName(valueVector->kind) + " to " +
+                                  (targetVector ? PrimitiveTypeNode::kindName(targetVector->kind)
+                                                : "a scalar")
+                );
+            }
+        }
+
+        TypeNode* variableType(VariableDeclNode* node) {
+            if (!node->arraySize)
+                return node->type;
+            auto* size = dynamic_cast<IntegerLiteralNode*>(node->arraySize);
+            if (!size || size->value <= 0)
+                error(node->location, "Array size must be a positive integer: " + node->identifier);
+            size->resolvedType = m_int;
+            return new ArrayTypeNode(node->type, static_cast<uint64_t>(size->value));
+        }
+
+        // ==== Declarations ====
+
+        void checkDeclaration(DeclarationNode* node) {
+            if (auto* var = dynamic_cast<VariableDeclNode*>(node)) {
+                TypeNode* type = variableType(var);
+                if (var->initializer)
+                    checkInitializer(var->initializer, type);
+                m_scopes.back()[var->identifier] = {type, nullptr, var};
+            } else if (auto* func = dynamic_cast<FunctionDeclNode*>(node)) {
+                if (m_scopes.size() > 1)
+                    m_scopes.back()[func->identifier] = {nullptr, func};
+                if (!func->body)
+                    return;
+                m_scopes.emplace_back();
+                for (auto* param : func->parameters) {
+                    m_scopes.back()[param->identifier] = {param->type, nullptr, param};
+                }
+                m_function = func;
+                checkStatement(func->body);
+                m_function = nullptr;
+                m_scopes.pop_back();
+            } else if (m_scopes.size() > 1) {
+                declareType(node);
+            }
+        }
+
+        // A list takes its type from the variable it initializes, down to nested lists
+        void checkInitializer(ExpressionNode* init, TypeNode* type) {
+            auto* list = dynamic_cast<InitializerListExprNode*>(init);
+            if (!list) {
+                checkAssignable(init->location, type, checkExpression(init));
+                return;
+            }
+            list->resolvedType = type;
+
+            if (auto* array = dynamic_cast<ArrayTypeNode*>(type)) {
+                if (list->elements.size() > array->size)
+                    error(list->location, "Too many elements in array initializer");
+                for (auto* element : list->elements) {
+                    checkInitializer(element, array->elementType);
+                }
+            } else if (PrimitiveTypeNode* vector = vectorOf(type)) {
+                if (list->elements.size() > vector->lanes())
+                    error(list->location, "Too many elements in vector initializer");
+                for (auto* element : list->elements) {
+                    checkInitializer(element, primitive(vector->elementKind()));
+                }
+            } else if (StructDeclNode* structDecl = structOf(type)) {
+                if (list->elements.size() > structDecl->fields.size())
+                    error(list->location, "Too many elements in struct initializer");
+                for (size_t i = 0; i < list->elements.size(); i++) {
+                    checkInitializer(list->elements[i], structDecl->fields[i]->type);
+                }
+            } else {
+                error(list->location, "Initializer list for a scalar");
+            }
+        }
+
+        // ==== Statements ====
+
+        void checkStatement(StatementNode* node) {
+            if (!node)
+                return;
+
+            if (auto* block = dynamic_cast<BlockStatementNode*>(node)) {
+                m_scopes.emplace_back();
+                for (auto* stmt : block->body) {
+                    checkStatement(stmt);
+                }
+                m_scopes.pop_back();
+            } else if (auto* exprStmt = dynamic_cast<ExpressionStatementNode*>(node)) {
+                if (std::holds_alternative<ExpressionNode*>(exprStmt->expression))
+                    checkExpression(std::get<ExpressionNode*>(exprStmt->expression));
+                else
+                    checkDeclaration(std::get<DeclarationNode*>(exprStmt->expression));
+            } else if (auto* ifStmt = dynamic_cast<IfStatementNode*>(node)) {
+                checkCondition(ifStmt->condition);
+                checkStatement(ifStmt->thenBody);
+                checkStatement(ifStmt->elseBody);
+            } else if (auto* whileStmt = dynamic_cast<WhileStatementNode*>(node)) {
+                checkCondition(whileStmt->condition);
+                m_loopDepth++;
+                checkStatement(whileStmt->loopBody);
+                m_loopDepth--;
+            } else if (auto* doWhile = dynamic_cast<DoWhileStatementNode*>(node)) {
+                m_loopDepth++;
+                checkStatement(doWhile->loopBody);
+                m_loopDepth--;
+                checkCondition(doWhile->condition);
+            } else if (auto* forStmt = dynamic_cast<ForStatementNode*>(node)) {
+                m_scopes.emplace_back();
+                if (std::holds_alternative<ExpressionNode*>(forStmt->init))
+                    checkExpression(std::get<ExpressionNode*>(forStmt->init));
+                else
+                    checkDeclaration(std::get<DeclarationNode*>(forStmt->init));
+                checkCondition(forStmt->condition);
+                checkExpression(forStmt->update);
+                auto* parallel = dynamic_cast<ParallelForStatementNode*>(forStmt);
+                if (parallel)
+                    checkParallelFor(parallel);
+                m_loopDepth++;
+                checkStatement(forStmt->body);
+                m_loopDepth--;
+                if (parallel)
+                    m_parallelLoops.pop_back();
+                m_scopes.pop_back();
+            } else if (auto* retStmt = dynamic_cast<ReturnStatementNode*>(node)) {
+                if (!m_parallelLoops.empty())
+                    error(retStmt->location, "return inside a parallel for");
+                TypeNode* type = checkExpression(retStmt->returnValue);
+                bool isVoid = isPrimitive(m_function->returnType, PrimitiveTypeNode::Void);
+                if (retStmt->returnValue && isVoid)
+                    error(
+                        retStmt->location, "Void function returns a value: " + m_function->identifier
+                    );
+                if (retStmt->returnValue)
+                    checkAssignable(retStmt->location, m_function->returnType, type);
+            } else if (auto* switchStmt = dynamic_cast<SwitchStatementNode*>(node)) {
+                TypeNode* type = checkExpression(switchStmt->condition);
+                if (!isPrimitive(type, PrimitiveTypeNode::Int) &&
+                    !isPrimitive(type, PrimitiveTypeNode::Char))
+                    error(switchStmt->location, "Switch condition must be an integer");
+                std::unordered_set<int> values;
+                bool hasDefault = false;
+                m_switchDepth++;
+                for (auto* caseStmt : switchStmt->cases) {
+                    if (caseStmt->isDefault()) {
+                        if (hasDefault)
+                            error(caseStmt->location, "Duplicate default in switch");
+                        hasDefault = true;
+                    } else {
+                        checkExpression(caseStmt->value);
+                        if (!values.insert(caseStmt->value->value).second)
+                            error(caseStmt->location, "Duplicate case value");
+                    }
+                    checkStatement(caseStmt->body);
+                }
+                m_switchDepth--;
+            } else if (dynamic_cast<BreakStatementNode*>(node)) {
+                if (m_loopDepth == 0 && m_switchDepth == 0)
+                    error(node->location, "break outside of a loop or switch");
+                const ParallelLoop* parallel =
+                    m_parallelLoops.empty() ? nullptr : &m_parallelLoops.back();
+                if (parallel && parallel->loopDepth == m_loopDepth &&
+                    parallel->switchDepth == m_switchDepth) {
+                    error(node->location, "break out of a parallel for");
+                }
+            } else if (dynamic_cast<ContinueStatementNode*>(node)) {
+                if (m_loopDepth == 0)
+                    error(node->location, "continue outside of a loop");
+            }
+        }
+
+        // for (int i = begin; i < end; i++) or i <= end, with i++, ++i or i = i + 1
+        void checkParallelFor(ParallelForStatementNode* loop) {
+            VariableDeclNode* counter = nullptr;
+            if (std::holds_alternative<DeclarationNode*>(loop->init))
+                counter = dynamic_cast<VariableDeclNode*>(std::get<DeclarationNode*>(loop->init));
+            auto isCounter = [&](ExpressionNode* expr) {
+                auto* id = dynamic_cast<IdentifierExprNode*>(expr);
+                return id && id->declaration == counter;
+            };
+            auto isOne = [](ExpressionNode* expr) {
+                auto* literal = dynamic_cast<IntegerLiteralNode*>(expr);
+                return literal && literal->value == 1;
+            };
+
+            bool canonical = counter && !counter->arraySize && counter->initializer &&
+                             isPrimitive(counter->type, PrimitiveTypeNode::Int);
+            auto* condition = dynamic_cast<BinaryExprNode*>(loop->condition);
+            canonical = canonical && condition && (condition->op == "<" || condition->op == "<=") &&
+                        isCounter(condition->left) && !vectorOf(condition->right->resolvedType) &&
+                        !isPrimitive(condition->right->resolvedType, PrimitiveTypeNode::Double) &&
+                        !isPointer(condition->right->resolvedType);
+            if (auto* increment = dynamic_cast<UnaryExprNode*>(loop->update)) {
+                canonical = canonical && increment->op == "++" && isCounter(increment->operand);
+            } else if (auto* assignment = dynamic_cast<BinaryExprNode*>(loop->update)) {
+                auto* sum = dynamic_cast<BinaryExprNode*>(assignment->right);
+                canonical = canonical && assignment->op == "=" && isCounter(assignment->left) &&
+                            sum && sum->op == "+" &&
+                            ((isCounter(sum->left) && isOne(sum->right)) ||
+                             (isOne(sum->left) && isCounter(sum->right)));
+            } else {
+                canonical = false;
+            }
+            if (!canonical) {
+                error(
+                    loop->location,
+                    "Parallel for must have the form for (int i = begin; i < end; i++)"
+                );
+            }
+            if (loop->chunk < 0)
+                error(loop->location, "Parallel for chunk must not be negative");
+
+            // The body is checked one loop deeper
+            m_parallelLoops.push_back({counter, m_loopDepth + 1, m_switchDepth});
+        }
+
+        void checkNotParallelCounter(ExpressionNode* target) {
+            auto* id = dynamic_cast<IdentifierExprNode*>(target);
+            for (const ParallelLoop& loop : m_parallelLoops) {
+                if (id && id->declaration == loop.counter)
+                    error(target->location, "Parallel for variable is assigned: " + id->name);
+            }
+        }
+
+        // The const variable holding target, through element and member chains like a[i].f. Null
+        // when a write goes through a pointer or reaches no const variable
+        static VariableDeclNode* constRoot(ExpressionNode* target) {
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(target)) {
+                auto* variable = dynamic_cast<VariableDeclNode*>(id->declaration);
+                return variable && variable->isConst ? variable : nullptr;
+            }
+            if (auto* index = dynamic_cast<IndexExprNode*>(target)) {
+                if (dynamic_cast<PointerTypeNode*>(index->array->resolvedType))
+                    return nullptr;
+                return constRoot(index->array);
+            }
+            if (auto* member = dynamic_cast<MemberExprNode*>(target))
+                return member->arrowAccess ? nullptr : constRoot(member->object);
+            return nullptr;
+        }
+
+        void checkNotConst(const SourceLocation& location, ExpressionNode* target) {
+            if (VariableDeclNode* variable = constRoot(target))
+                error(location, "Cannot assign to const variable: " + variable->identifier);
+        }
+
+        // ==== Expressions ====
+
+        void checkCondition(ExpressionNode* condition) {
+            if (vectorOf(checkExpression(condition)))
+                error(condition->location, "Vector used as a condition");
+        }
+
+        TypeNode* checkExpression(ExpressionNode* node) {
+            if (!node)
+                return nullptr;
+            node->resolvedType = resolve(node);
+            return node->resolvedType;
+        }
+
+        // %, ~ and the bitwise operators have no floating point version
+        void requireInteger(const SourceLocation& location, const std::string& op, TypeNode* type) {
+            auto* prim = dynamic_cast<PrimitiveTypeNode*>(type);
+            if (prim && prim->elementKind() == PrimitiveTypeNode::Double)
+                error(location, "Operator " + op + " needs integer operands");
+        }
+
+        static bool isIntegerOnly(const std::string& op) {
+            return op == "%" || op == "&" || op == "|" || op == "^" || op == "<<" || op == ">>";
+        }
+
+        // Element-wise, a scalar operand is converted to the element type and fills every lane.
+        // Comparisons give an int vector with all bits set in the lanes where they hold
+        TypeNode* vectorBinaryType(BinaryExprNode* binary, TypeNode* left, TypeNode* right) {
+            PrimitiveTypeNode* vector = vectorOf(left) ? vectorOf(left) : vectorOf(right);
+            TypeNode* other = vector == left ? right : left;
+            auto* otherPrim = dynamic_cast<PrimitiveTypeNode*>(other);
+            if (!otherPrim || otherPrim->kind == PrimitiveTypeNode::Void ||
+                (otherPrim->isVector() && otherPrim->kind != vector->kind)) {
+                error(binary->location, "Invalid operands to vector " + binary->op);
+            }
+
+            const std::string& op = binary->op;
+            if (op == "&&" || op == "||")
+                error(binary->location, "Operator " + op + " needs scalar operands");
+            if (op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=") {
+                auto mask = PrimitiveTypeNode::vectorKind(PrimitiveTypeNode::Int, vector->lanes());
+                return primitive(mask);
+            }
+            if (isIntegerOnly(op))
+                requireInteger(binary->location, op, vector);
+            return vector;
+        }
+
+        // Result of arithmetic on a and b: double wins, char is promoted to int
+        TypeNode* arithmeticType(TypeNode* a, TypeNode* b) {
+            if (vectorOf(a))
+                return a;
+            bool isDouble =
+                isPrimitive(a, PrimitiveTypeNode::Double) || isPrimitive(b, PrimitiveTypeNode::Double);
+            return isDouble ? m_double : m_int;
+        }
+
+        TypeNode* resolve(ExpressionNode* node) {
+            if (dynamic_cast<IntegerLiteralNode*>(node))
+                return m_int;
+            if (dynamic_cast<DoubleLiteralNode*>(node))
+                return m_double;
+            if (dynamic_cast<CharacterLiteralNode*>(node))
+                return m_char;
+            if (dynamic_cast<StringLiteralNode*>(node))
+                return m_string;
+
+            if (auto* id = dynamic_cast<IdentifierExprNode*>(node)) {
+                const Symbol* symbol = lookup(id->name);
+                if (!symbol)
+                    error(id->location, "Unknown variable name: " + id->name);
+                id->isLValue = !symbol->function;
+                id->declaration = symbol->function
+                                      ? static_cast<DeclarationNode*>(symbol->function)
+                                      : symbol->variable;
+                return symbol->type;
+            }
+
+            if (auto* member = dynamic_cast<MemberExprNode*>(node)) {
+                TypeNode* objectType = checkExpression(member->object);
+                if (member->arrowAccess) {
+                    auto* ptr = dynamic_cast<PointerTypeNode*>(objectType);
+                    if (!ptr)
+                        error(member->location, "-> on a non-pointer, member " + member->member);
+                    objectType = ptr->baseType;
+                }
+                StructDeclNode* structDecl = structOf(objectType);
+                if (!structDecl)
+                    error(member->location, "Member access on a non-struct: " + member->member);
+
+                for (unsigned i = 0; i < structDecl->fields.size(); i++) {
+                    if (structDecl->fields[i]->identifier == member->member) {
+                        member->structDecl = structDecl;
+                        member->fieldIndex = i;
+                        member->isLValue = member->arrowAccess || member->object->isLValue;
+                        return structDecl->fields[i]->type;
+                    }
+                }
+                error(
+                    member->location,
+                    "No member " + member->member + " in struct " + structDecl->identifier
+                );
+            }
+
+            if (auto* index = dynamic_cast<IndexExprNode*>(node)) {
+                TypeNode* arrayType = checkExpression(index->array);
+                checkExpression(index->index);
+                if (PrimitiveTypeNode* vector = vectorOf(arrayType)) {
+                    index->isLValue = index->array->isLValue;
+                    return primitive(vector->elementKind());
+                }
+                index->isLValue = true;
+                if (auto* array = dynamic_cast<ArrayTypeNode*>(arrayType))
+                    return array->elementType;
+                if (auto* ptr = dynamic_cast<PointerTypeNode*>(arrayType))
+                    return ptr->baseType;
+                error(index->location, "Subscript of a value that is not an array or pointer");
+            }
+
+            if (auto* unary = dynamic_cast<UnaryExprNode*>(node)) {
+                TypeNode* operandType = checkExpression(unary->operand);
+                if (unary->op == "++" || unary->op == "--") {
+                    if (!unary->operand->isLValue)
+                        error(unary->location, "Operand of " + unary->op + " is not assignable");
+                    checkNotConst(unary->location, unary->operand);
+                    checkNotParallelCounter(unary->operand);
+                    return operandType;
+                }
+                if (unary->op == "&") {
+                    if (!unary->operand->isLValue)
+                        error(unary->location, "Cannot take the address of an rvalue");
+                    // Pointers carry no const, a write through this one would go unnoticed
+                    if (VariableDeclNode* variable = constRoot(unary->operand)) {
+                        error(
+                            unary->location,
+                            "Cannot take the address of const variable: " + variable->identifier
+                        );
+                    }
+                    return new PointerTypeNode(operandType);
+                }
+                if (unary->op == "*") {
+                    auto* ptr = dynamic_cast<PointerTypeNode*>(operandType);
+                    if (!ptr)
+                        error(unary->location, "Indirection requires a pointer operand");
+                    unary->isLValue = true;
+                    return ptr->baseType;
+                }
+                if (unary->op == "!") {
+                    if (vectorOf(operandType))
+                        error(unary->location, "Operator ! needs a scalar operand");
+                    return m_int;
+                }
+                if (unary->op == "~")
+                    requireInteger(unary->location, unary->op, operandType);
+                return arithmeticType(operandType, operandType);
+            }
+
+            if (auto* binary = dynamic_cast<BinaryExprNode*>(node)) {
+                TypeNode* left = checkExpression(binary->left);
+                TypeNode* right = checkExpression(binary->right);
+                const std::string& op = binary->op;
+                if (op == "=") {
+                    if (!binary->left->isLValue)
+                        error(binary->location, "Expression is not assignable");
+                    checkNotConst(binary->location, binary->left);
+                    checkNotParallelCounter(binary->left);
+                    checkAssignable(binary->location, left, right);
+                    return left;
+                }
+                if (vectorOf(left) || vectorOf(right))
+                    return vectorBinaryType(binary, left, right);
+                if (op == "&&" || op == "||" || op == "<" || op == ">" || op == "<=" ||
+                    op == ">=" || op == "==" || op == "!=") {
+                    return m_int;
+                }
+                if (op == "+" || op == "-") {
+                    if (isPointer(left) && isPointer(right))
+                        return m_int;
+                    if (isPointer(left))
+                        return left;
+                    if (isPointer(right))
+                        return right;
+                }
+                if (isIntegerOnly(op)) {
+                    requireInteger(binary->location, op, left);
+                    requireInteger(binary->location, op, right);
+                }
+                return arithmeticType(left, right);
+            }
+
+            if (auto* call = dynamic_cast<CallExprNode*>(node)) {
+                for (auto* arg : call->arguments) {
+                    checkExpression(arg);
+                }
+                const Symbol* symbol = lookup(call->callee->name);
+                if (!symbol) {
+                    if (const Builtin* builtin = lookupBuiltin(call->callee->name))
+                        return checkBuiltinCall(call, builtin);
+                    error(call->location, "Call to undeclared function: " + call->callee->name);
+                }
+                checkExpression(call->callee);
+
+                auto parameterCount = [&](size_t expected) {
+                    if (call->arguments.size() != expected)
+                        error(call->location, "Wrong number of arguments to " + call->callee->name);
+                };
+                if (symbol->function) {
+                    parameterCount(symbol->function->parameters.size());
+                    for (size_t i = 0; i < call->arguments.size(); i++) {
+                        checkAssignable(
+                            call->arguments[i]->location, symbol->function->parameters[i]->type,
+                            call->arguments[i]->resolvedType
+                        );
+                    }
+                    return symbol->function->returnType;
+                }
+                if (FunctionPtrDeclNode* funcPtr = functionPtrOf(symbol->type)) {
+                    parameterCount(funcPtr->parameters.size());
+                    return funcPtr->returnType;
+                }
+                error(call->location, "Called object is not a function: " + call->callee->name);
+            }
+
+            if (auto* cast = dynamic_cast<CastExprNode*>(node)) {
+                checkExpression(cast->operand);
+                return cast->type;
+            }
+
+            if (auto* comma = dynamic_cast<CommaExprNode*>(node)) {
+                TypeNode* last = nullptr;
+                for (auto* expr : comma->expressions) {
+                    last = checkExpression(expr);
+                }
+                return last;
+            }
+
+            if (dynamic_cast<InitializerListExprNode*>(node))
+                error(node->location, "Initializer list is only allowed in a variable declaration");
+
+            error(node->location, "Unknown expression");
+        }
+
+        // Arguments were checked already, see Builtins.h for what each builtin takes
+        TypeNode* checkBuiltinCall(CallExprNode* call, const Builtin* builtin) {
+            call->builtin = builtin;
+            const std::string& name = call->callee->name;
+            const auto& arguments = call->arguments;
+            auto argumentCount = [&](size_t expected) {
+                if (arguments.size() != expected)
+                    error(call->location, "Wrong number of arguments to " + name);
+            };
+            auto numberArgument = [&](ExpressionNode* argument) {
+                auto* prim = dynamic_cast<PrimitiveTypeNode*>(argument->resolvedType);
+                if (!prim || prim->kind == PrimitiveTypeNode::Void)
+                    error(argument->location, name + " needs a number argument");
+                return prim;
+            };
+            auto vectorArgument = [&](size_t i) {
+                PrimitiveTypeNode* vector = vectorOf(arguments[i]->resolvedType);
+                if (!vector)
+                    error(arguments[i]->location, name + " needs a vector argument");
+                return vector;
+            };
+
+            switch (builtin->kind) {
+                case BuiltinKind::ShuffleVector: {
+                    if (arguments.size() < 3)
+                        error(call->location, "Wrong number of arguments to " + name);
+                    PrimitiveTypeNode* vector = vectorArgument(0);
+                    if (vectorArgument(1)->kind != vector->kind)
+                        error(call->location, "Shuffled vectors must have the same type");
+                    for (size_t i = 2; i < arguments.size(); i++) {
+                        auto* lane = dynamic_cast<IntegerLiteralNode*>(arguments[i]);
+                        bool inRange = lane && lane->value >= 0 &&
+                                       unsigned(lane->value) < 2 * vector->lanes();
+                        if (!inRange)
+                            error(arguments[i]->location, "Shuffle lane must be a constant lane");
+                    }
+                    unsigned lanes = arguments.size() - 2;
+                    auto kind = PrimitiveTypeNode::vectorKind(vector->elementKind(), lanes);
+                    if (kind == PrimitiveTypeNode::Void)
+                        error(call->location, "No vector type with that many lanes");
+                    return primitive(kind);
+                }
+                case BuiltinKind::ReduceAnd:
+                case BuiltinKind::ReduceOr:
+                case BuiltinKind::ReduceXor:
+                    argumentCount(1);
+                    requireInteger(call->location, name, vectorArgument(0));
+                    return primitive(vectorArgument(0)->elementKind());
+                case BuiltinKind::ReduceAdd:
+                case BuiltinKind::ReduceMul:
+                case BuiltinKind::ReduceMin:
+                case BuiltinKind::ReduceMax:
+                    argumentCount(1);
+                    return primitive(vectorArgument(0)->elementKind());
+                case BuiltinKind::VectorLoad:
+                case BuiltinKind::VectorStore: {
+                    bool isLoad = builtin->kind == BuiltinKind::VectorLoad;
+                    argumentCount(isLoad ? 1 : 2);
+                    PrimitiveTypeNode* vector =
+                        primitive(PrimitiveTypeNode::kindFromString(builtin->vectorType));
+                    // Arrays decay to a pointer to their first element
+                    TypeNode* pointee = nullptr;
+                    if (auto* ptr = dynamic_cast<PointerTypeNode*>(arguments[0]->resolvedType))
+                        pointee = ptr->baseType;
+                    if (auto* array = dynamic_cast<ArrayTypeNode*>(arguments[0]->resolvedType))
+                        pointee = array->elementType;
+                    if (!isPrimitive(pointee, vector->elementKind())) {
+                        error(
+                            arguments[0]->location,
+                            name + " needs a pointer to " +
+                                PrimitiveTypeNode::kindName(vector->elementKind())
+                        );
+                    }
+                    if (isLoad)
+                        return vector;
+                    checkAssignable(arguments[1]->location, vector, arguments[1]->resolvedType);
+                    return primitive(PrimitiveTypeNode::Void);
+                }
+                case BuiltinKind::Sqrt:
+                case BuiltinKind::Fabs:
+                case BuiltinKind::Floor:
+                case BuiltinKind::Ceil:
+                case BuiltinKind::Trunc:
+                case BuiltinKind::Round:
+                case BuiltinKind::Fmin:
+                case BuiltinKind::Fmax:
+                case BuiltinKind::Fma: {
+                    bool isBinary =
+                        builtin->kind == BuiltinKind::Fmin || builtin->kind == BuiltinKind::Fmax;
+                    argumentCount(builtin->kind == BuiltinKind::Fma ? 3 : isBinary ? 2 : 1);
+                    // Scalars are converted to double, or fill every lane of a vector operand
+                    TypeNode* type = m_double;
+                    for (auto* argument : arguments) {
+                        PrimitiveTypeNode* prim = numberArgument(argument);
+                        if (prim->isVector())
+                            type = prim;
+                    }
+                    PrimitiveTypeNode* vector = vectorOf(type);
+                    if (vector && vector->elementKind() != PrimitiveTypeNode::Double)
+                        error(call->location, name + " needs double operands");
+                    for (auto* argument : arguments) {
+                        checkAssignable(argument->location, type, argument->resolvedType);
+                    }
+                    return type;
+                }
+                case BuiltinKind::Popcount:
+                case BuiltinKind::Clz:
+                case BuiltinKind::Ctz: {
+                    argumentCount(1);
+                    PrimitiveTypeNode* prim = numberArgument(arguments[0]);
+                    requireInteger(call->location, name, prim);
+                    return prim->isVector() ? prim : m_int;
+                }
+                case BuiltinKind::Prefetch: {
+                    if (arguments.empty() || arguments.size() > 3)
+                        error(call->location, "Wrong number of arguments to " + name);
+                    if (!isPointer(arguments[0]->resolvedType) &&
+                        !dynamic_cast<ArrayTypeNode*>(arguments[0]->resolvedType)) {
+                        error(arguments[0]->location, name + " needs a pointer argument");
+                    }
+                    // Read or write, then temporal locality from none to keep in all levels
+                    const int limits[] = {1, 3};
+                    for (size_t i = 1; i < arguments.size(); i++) {
+                        auto* literal = dynamic_cast<IntegerLiteralNode*>(arguments[i]);
+                        if (!literal || literal->value < 0 || literal->value > limits[i - 1]) {
+                            error(
+                                arguments[i]->location,
+                                name + " argument must be a constant from 0 to " +
+                                    std::to_string(limits[i - 1])
+                            );
+                        }
+                    }
+                    return primitive(PrimitiveTypeNode::Void);
+                }
+                case BuiltinKind::Expect: {
+                    argumentCount(2);
+                    for (auto* argument : arguments) {
+                        PrimitiveTypeNode* prim = numberArgument(argument);
+                        if (prim->isVector())
+                            error(argument->location, name + " needs scalar operands");
+                        requireInteger(argument->location, name, prim);
+                    }
+                    auto* negated = dynamic_cast<UnaryExprNode*>(arguments[1]);
+                    ExpressionNode* expected =
+                        negated && negated->op == "-" ? negated->operand : arguments[1];
+                    if (!dynamic_cast<IntegerLiteralNode*>(expected) &&
+                        !dynamic_cast<CharacterLiteralNode*>(expected)) {
+                        error(arguments[1]->location, "Expected value must be a constant");
+                    }
+                    return m_int;
+                }
+            }
+            error(call->location, "Unknown builtin: " + name);
+        }
+
+        ProgramNode* m_program;
+        std::vector<std::unordered_map<std::string, Symbol>> m_scopes;
+        std::unordered_map<std::string, StructDeclNode*> m_structs;
+        std::unordered_map<std::string, FunctionPtrDeclNode*> m_functionPtrs;
+        FunctionDeclNode* m_function = nullptr;  // Whose body is being checked
+        int m_loopDepth = 0;
+        int m_switchDepth = 0;
+
+        // Enclosing parallel for loops, innermost last. A break at their depths leaves the loop
+        struct ParallelLoop {
+            VariableDeclNode* counter;
+            int loopDepth;
+            int switchDepth;
+        };
+        std::vector<ParallelLoop> m_parallelLoops;
+
+        PrimitiveTypeNode* m_int = nullptr;
+        PrimitiveTypeNode* m_double = nullptr;
+        PrimitiveTypeNode* m_char = nullptr;
+        PointerTypeNode* m_string = nullptr;
+    };
+}  // namespace
+
+void analyzeSemantics(ProgramNode* program) {
+    TypeChecker(program).run();
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "AST/forwardDecl.h"
+
+
+// Type checks the program and annotates it for CodeGen: every expression gets its type and
+// whether it is an lvalue, every member access the struct definition and field it refers to.
+// Throws std::runtime_error on the first error. Types the AST has no node for (arrays,
+// pointers from &, the builtin types of literals) are allocated in a new arena of program
+void analyzeSemantics(ProgramNode* program);
@@ -0,0 +1,112 @@
+#include "StructLayout.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "AST/ASTWalker.h"
+#include "AST/includeNodes.h"
+
+
+namespace {
+
+    class StructUsageWalker : public ASTWalker {
+      public:
+        StructUsage usage;
+
+        void visitDeclaration(DeclarationNode* node) override {
+            if (auto* varDecl = dynamic_cast<VariableDeclNode*>(node)) {
+                if (auto* named = dynamic_cast<NamedTypeNode*>(varDecl->type)) {
+                    // Globals get no cold storage, CodeGen only allocates it for locals
+                    if (varDecl->initializer || !m_inFunction)
+                        usage.unsplittable.insert(named->identifier);
+                }
+            } else if (auto* param = dynamic_cast<ParameterDeclNode*>(node)) {
+                markNamed(param->type);
+            } else if (auto* funcDecl = dynamic_cast<FunctionDeclNode*>(node)) {
+                markNamed(funcDecl->returnType);
+                if (funcDecl->body)
+                    m_inFunction = true;
+            } else if (auto* structDecl = dynamic_cast<StructDeclNode*>(node)) {
+                for (auto* field : structDecl->fields) {
+                    markNamed(field->type);
+                }
+            }
+        }
+
+        void leaveFunction(FunctionDeclNode* node) override { m_inFunction = false; }
+
+        void visitType(TypeNode* node) override {
+            if (auto* ptr = dynamic_cast<PointerTypeNode*>(node)) {
+                markNamed(ptr->baseType);
+            }
+        }
+
+        void visitExpression(ExpressionNode* node) override {
+            if (auto* member = dynamic_cast<MemberExprNode*>(node)) {
+                usage.memberUses[member->member]++;
+            } else if (auto* bin = dynamic_cast<BinaryExprNode*>(node)) {
+                // Both sides have the type of the left one
+                if (bin->op == "=")
+                    markCopied(bin->left);
+            } else if (auto* call = dynamic_cast<CallExprNode*>(node)) {
+                for (auto* arg : call->arguments) {
+                    markCopied(arg);
+                }
+            }
+        }
+
+      private:
+        void markNamed(TypeNode* type) {
+            if (auto* named = dynamic_cast<NamedTypeNode*>(type))
+                usage.unsplittable.insert(named->identifier);
+        }
+
+        // A struct used as a whole value is copied, whether it is a variable, an element like
+        // arr[i] or a member, an array of them decays to a pointer. Types were resolved by
+        // analyzeSemantics
+        void markCopied(ExpressionNode* expr) {
+            TypeNode* type = expr->resolvedType;
+            if (auto* array = dynamic_cast<ArrayTypeNode*>(type))
+                type = array->elementType;
+            markNamed(type);
+        }
+
+        bool m_inFunction = false;
+    };
+}  // namespace
+
+uint64_t StructUsage::fieldHeat(const std::string& structName, const std::string& field) const {
+    auto structIt = profile.find(structName);
+    if (structIt != profile.end()) {
+        auto fieldIt = structIt->second.find(field);
+        return fieldIt != structIt->second.end() ? fieldIt->second : 0;
+    }
+    auto it = memberUses.find(field);
+    return it != memberUses.end() ? it->second : 0;
+}
+
+StructUsage analyzeStructUsage(ProgramNode* program) {
+    StructUsageWalker walker;
+    walker.walk(program);
+    return std::move(walker.usage);
+}
+
+void loadStructProfile(StructUsage& usage, const std::string& profileFile) {
+    std::ifstream R(profileFile);
+    if (!R.is_open()) {
+        throw std::runtime_error("Struct profile could not be opened: " + profileFile);
+    }
+
+    try {
+        nlohmann::json data = nlohmann::json::parse(R);
+        for (const auto& [structName, fields] : data.items()) {
+            for (const auto& [field, count] : fields.items()) {
+                usage.profile[structName][field] = count.get<uint64_t>();
+            }
+        }
+    } catch (nlohmann::json::exception& e) {
+        throw std::runtime_error("Invalid struct profile: " + std::string(e.what()));
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "AST/forwardDecl.h"
+
+
+// Field order used by CodeGen::visitStructDefinition
+enum class StructLayoutMode {
+    Declared,  // Declaration order, matches C
+    Compact,   // Sorted by alignment to minimize padding
+    HotCold    // Compact, rarely accessed fields moved to a separate <name>.cold struct
+};
+
+// How often struct fields are accessed and which structs must stay in one piece
+struct StructUsage {
+    // Static MemberExprNode counts by member name, object types are not known before CodeGen
+    std::unordered_map<std::string, uint64_t> memberUses;
+    // Profile counts, struct -> field -> accesses, preferred over the static counts when present
+    std::unordered_map<std::string, std::unordered_map<std::string, uint64_t>> profile;
+    // Structs used through pointers, as parameters, return values, fields or whole-struct copies.
+    // Their cold part could not be allocated or would be shared between copies
+    std::unordered_set<std::string> unsplittable;
+
+    uint64_t fieldHeat(const std::string& structName, const std::string& field) const;
+    bool canSplit(const std::string& structName) const { return !unsplittable.count(structName); }
+};
+
+StructUsage analyzeStructUsage(ProgramNode* program);
+
+// Profile is a JSON object {"Struct": {"field": count, ...}, ...}
+void loadStructProfile(StructUsage& usage, const std::string& profileFile);
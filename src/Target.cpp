@@ -0,0 +1,123 @@
+#include "Target.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+#include <llvm/TargetParser/Triple.h>
+
+
+using namespace llvm;
+
+TargetConfig resolveTargetConfig(
+    const std::string& march, const std::string& mcpu, const std::string& mattr
+) {
+    TargetConfig config;
+    // -mcpu wins over -march, both name a CPU on x86
+    std::string cpu = !mcpu.empty() ? mcpu : march;
+
+    SubtargetFeatures features;
+    if (cpu == "native") {
+        config.cpu = sys::getHostCPUName().str();
+        // The CPU name alone misses features the OS or BIOS disabled, e.g. AVX-512
+        for (const auto& feature : sys::getHostCPUFeatures())
+            features.AddFeature(feature.getKey(), feature.getValue());
+    } else if (!cpu.empty()) {
+        config.cpu = cpu;
+    }
+
+    // -mattr comes last so it can turn off what native enabled
+    if (!mattr.empty()) {
+        SmallVector<StringRef, 8> attributes;
+        StringRef(mattr).split(attributes, ',', -1, false);
+        for (StringRef attribute : attributes) {
+            if (attribute[0] != '+' && attribute[0] != '-') {
+                throw std::runtime_error(
+                    "-mattr feature must start with + or -: " + attribute.str()
+                );
+            }
+            features.AddFeature(attribute);
+        }
+    }
+    config.features = features.getString();
+    return config;
+}
+
+void initializeNativeTarget() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        InitializeNativeTarget();
+        InitializeNativeTargetAsmPrinter();
+        InitializeNativeTargetAsmParser();
+    });
+}
+
+CodeGenOptLevel toCodeGenOptLevel(unsigned optLevel) {
+    switch (optLevel) {
+        case 0: return CodeGenOptLevel::None;
+        case 1: return CodeGenOptLevel::Less;
+        case 2: return CodeGenOptLevel::Default;
+        default: return CodeGenOptLevel::Aggressive;
+    }
+}
+
+CodeGenBackend resolveBackend(CodeGenBackend backend, unsigned optLevel) {
+    if (backend != CodeGenBackend::Auto)
+        return backend;
+    return optLevel == 0 ? CodeGenBackend::Fast : CodeGenBackend::Default;
+}
+
+const char* backendName(CodeGenBackend backend) {
+    switch (backend) {
+        case CodeGenBackend::Auto: return "auto";
+        case CodeGenBackend::Fast: return "fast";
+        case CodeGenBackend::GlobalISel: return "globalisel";
+        case CodeGenBackend::Default: return "default";
+    }
+    return "unknown";
+}
+
+CodeGenOptLevel backendOptLevel(CodeGenBackend backend, unsigned optLevel) {
+    switch (resolveBackend(backend, optLevel)) {
+        // CodeGenOptLevel::None is what picks the fast register allocator and drops the
+        // machine level optimizations, FastISel is only used at None
+        case CodeGenBackend::Fast:
+        case CodeGenBackend::GlobalISel: return CodeGenOptLevel::None;
+        // At None the selector would be FastISel again
+        default: return toCodeGenOptLevel(std::max(optLevel, 1u));
+    }
+}
+
+void setBackendOptions(TargetOptions& options, CodeGenBackend backend) {
+    options.EnableFastISel = backend == CodeGenBackend::Fast;
+    options.EnableGlobalISel = backend == CodeGenBackend::GlobalISel;
+    // Fall back to SelectionDAG per function instead of aborting, without a warning for each
+    options.GlobalISelAbort = GlobalISelAbortMode::Disable;
+}
+
+std::unique_ptr<TargetMachine> createTargetMachine(const TargetConfig& config, unsigned optLevel) {
+    initializeNativeTarget();
+
+    Triple triple(sys::getDefaultTargetTriple());
+    std::string error;
+    const Target* target = TargetRegistry::lookupTarget(triple, error);
+    if (!target) {
+        throw std::runtime_error("Unsupported target " + triple.str() + ": " + error);
+    }
+
+    CodeGenBackend backend = resolveBackend(config.backend, optLevel);
+    TargetOptions options;
+    setBackendOptions(options, backend);
+    std::unique_ptr<TargetMachine> targetMachine(target->createTargetMachine(
+        triple, config.cpu, config.features, options, Reloc::PIC_, std::nullopt,
+        backendOptLevel(backend, optLevel)
+    ));
+    if (!targetMachine)
+        throw std::runtime_error("Could not create a target machine for " + config.cpu);
+    return targetMachine;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <llvm/Target/TargetMachine.h>
+
+
+// Instruction selector and machine pass pipeline for native code
+enum class CodeGenBackend {
+    Auto,        // Fast at -O0, Default otherwise
+    Fast,        // FastISel, fast register allocator and the minimal -O0 machine passes
+    GlobalISel,  // Same with GlobalISel, functions it cannot select go through SelectionDAG
+    Default      // SelectionDAG and the regular pipeline, at least -O1 codegen
+};
+
+// CPU and feature string the backend and the function attributes use
+struct TargetConfig {
+    std::string cpu = "generic";
+    std::string features;  // "+avx2,-avx512f"
+    CodeGenBackend backend = CodeGenBackend::Auto;
+};
+
+// -march/-mcpu take a CPU name or "native", -mattr a comma separated feature list that is
+// applied on top of the CPU (and the host features for native)
+TargetConfig resolveTargetConfig(
+    const std::string& march, const std::string& mcpu, const std::string& mattr
+);
+
+// Registers the native target, safe to call more than once
+void initializeNativeTarget();
+
+// TargetMachine for the host triple
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(
+    const TargetConfig& config, unsigned optLevel
+);
+
+llvm::CodeGenOptLevel toCodeGenOptLevel(unsigned optLevel);
+
+// Auto resolved for optLevel, never returns Auto
+CodeGenBackend resolveBackend(CodeGenBackend backend, unsigned optLevel);
+const char* backendName(CodeGenBackend backend);
+// Codegen level and selector options of backend, the IR pipeline keeps using optLevel
+llvm::CodeGenOptLevel backendOptLevel(CodeGenBackend backend, unsigned optLevel);
+void setBackendOptions(llvm::TargetOptions& options, CodeGenBackend backend);
@@ -0,0 +1,188 @@
+#include "ThinLTO.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "AST/ProgramNode.h"
+#include "AST/fromJSON.h"
+#include "CodeGen.h"
+#include "Parallel.h"
+#include "Runtime.h"
+#include "Sema.h"
+#include "Target.h"
+
+
+using namespace llvm;
+
+namespace {
+    struct ModuleBitcode {
+        std::string identifier;
+        SmallVector<char, 0> bitcode;
+        std::string error;  // Set when the module failed to compile
+    };
+
+    void compileModule(
+        const std::string& astFile, const ThinLTOOptions& options, ModuleBitcode& result
+    ) {
+        result.identifier = astFile;
+        try {
+            ProgramNode* program = fromJSON(loadASTFromFile(astFile, options.jsonParser));
+            analyzeSemantics(program);
+
+            std::unique_ptr<TargetMachine> targetMachine =
+                createTargetMachine(options.target, options.optLevel);
+            CodeGen codeGen(astFile, targetMachine.get());
+            codeGen.getModule()->setSourceFileName(astFile);
+            codeGen.setMultiModule();
+            codeGen.setFastMath(options.fastMath);
+            codeGen.generate(program);
+            codeGen.verify();
+
+            raw_svector_ostream out(result.bitcode);
+            codeGen.emitThinLTOBitcode(options.optLevel, out);
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+    }
+
+    void check(Error error, const std::string& what) {
+        if (error)
+            throw std::runtime_error(what + ": " + toString(std::move(error)));
+    }
+}  // namespace
+
+std::vector<std::string> buildThinLTO(
+    const std::vector<std::string>& astFiles, const ThinLTOOptions& options
+) {
+    initializeNativeTarget();
+    unsigned jobs = options.jobs;
+    if (!jobs)
+        jobs = llvm::hardware_concurrency().compute_thread_count();
+
+    // Per-module compile, every module owns its LLVMContext so they run independently
+    std::vector<ModuleBitcode> modules(astFiles.size());
+    parallelFor(astFiles.size(), jobs, [&](unsigned, size_t i) {
+        compileModule(astFiles[i], options, modules[i]);
+    });
+
+    for (size_t i = 0; i < modules.size(); i++) {
+        if (!modules[i].error.empty())
+            throw std::runtime_error(modules[i].identifier + ": " + modules[i].error);
+
+        // Keep the summarized bitcode around for an external thin link (e.g. lld)
+        std::error_code EC;
+        raw_fd_ostream file(options.outputPrefix + "." + std::to_string(i) + ".bc", EC);
+        if (EC)
+            throw std::runtime_error("Could not write bitcode: " + EC.message());
+        file.write(modules[i].bitcode.data(), modules[i].bitcode.size());
+    }
+
+    // Thin link: combine the summaries, decide imports and internalization, then run
+    // the backends for all modules in parallel
+    lto::Config config;
+    config.CPU = options.target.cpu;
+    if (!options.target.features.empty()) {
+        SmallVector<StringRef, 32> features;
+        StringRef(options.target.features).split(features, ',');
+        for (StringRef feature : features)
+            config.MAttrs.push_back(feature.str());
+    }
+    config.RelocModel = Reloc::PIC_;
+    config.OptLevel = options.optLevel;
+    CodeGenBackend backend = resolveBackend(options.target.backend, options.optLevel);
+    config.CGOptLevel = backendOptLevel(backend, options.optLevel);
+    setBackendOptions(config.Options, backend);
+
+    lto::LTO lto(
+        std::move(config),
+        lto::createInProcessThinBackend(llvm::heavyweight_hardware_concurrency(jobs))
+    );
+
+    // The runtime takes part as one more module so its functions can be imported
+    std::vector<MemoryBufferRef> buffers;
+    for (ModuleBitcode& module : modules) {
+        buffers.emplace_back(
+            StringRef(module.bitcode.data(), module.bitcode.size()), module.identifier
+        );
+    }
+    if (options.linkRuntime)
+        buffers.push_back(runtimeBitcode());
+
+    // Every input is read before any is added, the prevailing definitions depend on all of them
+    std::vector<std::unique_ptr<lto::InputFile>> inputs;
+    for (MemoryBufferRef buffer : buffers) {
+        Expected<std::unique_ptr<lto::InputFile>> input = lto::InputFile::create(buffer);
+        check(input.takeError(), buffer.getBufferIdentifier().str());
+        inputs.push_back(std::move(*input));
+    }
+
+    // Input that holds the definition of each symbol the link keeps. A weak (linkonce) one gives
+    // way to a strong one or to the first weak one, two strong ones are a program error
+    struct Definition {
+        size_t input;
+        bool weak;
+    };
+    StringMap<Definition> prevailing;
+    std::string duplicates;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (const lto::InputFile::Symbol& symbol : inputs[i]->symbols()) {
+            if (symbol.isUndefined())
+                continue;
+            auto [it, inserted] =
+                prevailing.try_emplace(symbol.getName(), Definition{i, symbol.isWeak()});
+            if (inserted || symbol.isWeak())
+                continue;
+            if (it->second.weak) {
+                it->second = Definition{i, false};
+            } else {
+                duplicates += "Duplicate definition of " + symbol.getName().str() + " in " +
+                              buffers[it->second.input].getBufferIdentifier().str() + " and " +
+                              buffers[i].getBufferIdentifier().str() + "\n";
+            }
+        }
+    }
+    if (!duplicates.empty()) {
+        duplicates.pop_back();
+        throw std::runtime_error(duplicates);
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        // Only main and what stays undefined (libc) are seen by the native link
+        std::vector<lto::SymbolResolution> resolutions;
+        for (const lto::InputFile::Symbol& symbol : inputs[i]->symbols()) {
+            lto::SymbolResolution resolution;
+            resolution.Prevailing =
+                !symbol.isUndefined() && prevailing.lookup(symbol.getName()).input == i;
+            resolution.FinalDefinitionInLinkageUnit = !symbol.isUndefined();
+            resolution.VisibleToRegularObj = symbol.isUndefined() || symbol.getName() == "main";
+            resolutions.push_back(resolution);
+        }
+        check(lto.add(std::move(inputs[i]), resolutions), buffers[i].getBufferIdentifier().str());
+    }
+
+    std::vector<std::string> objects(lto.getMaxTasks());
+    auto addStream = [&](unsigned task,
+                         const Twine&) -> Expected<std::unique_ptr<CachedFileStream>> {
+        objects[task] = options.outputPrefix + "." + std::to_string(task) + ".o";
+        std::error_code EC;
+        auto stream = std::make_unique<raw_fd_ostream>(objects[task], EC, sys::fs::OF_None);
+        if (EC)
+            return errorCodeToError(EC);
+        return std::make_unique<CachedFileStream>(std::move(stream), objects[task]);
+    };
+    check(lto.run(addStream), "ThinLTO");
+
+    // Tasks without output (e.g. the empty regular LTO partition) leave no file
+    objects.erase(std::remove(objects.begin(), objects.end(), ""), objects.end());
+    return objects;
+}
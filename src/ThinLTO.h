@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <llvm/IR/FMF.h>
+
+#include "AST/fromJSON.h"
+#include "Target.h"
+
+
+struct ThinLTOOptions {
+    unsigned optLevel = 0;
+    unsigned jobs = 0;         // 0 uses every hardware thread
+    bool linkRuntime = true;
+    TargetConfig target;
+    JSONParser jsonParser = JSONParser::Simd;
+    llvm::FastMathFlags fastMath;
+    std::string outputPrefix;  // <prefix>.<n>.bc per module, <prefix>.<n>.o per backend task
+};
+
+// Compiles every AST file as its own module in parallel, then runs the thin link and the
+// backends in-process. Returns the paths of the object files, in task order. A symbol defined
+// in two inputs (the runtime included) throws, naming both
+std::vector<std::string> buildThinLTO(
+    const std::vector<std::string>& astFiles, const ThinLTOOptions& options
+);
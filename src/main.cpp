@@ -1,32 +1,380 @@
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "AST/ProgramNode.h"
 #include "AST/fromJSON.h"
+#include "CallTargets.h"
+#include "FunctionAttrs.h"
+#include "IRStats.h"
+#include "MemReport.h"
+#include "NativeEmit.h"
+#include "OptRemarks.h"
+#include "Runtime.h"
+#include "Sema.h"
+#include "StructLayout.h"
+#include "Target.h"
+#include "ThinLTO.h"
 
 
 // using json = nlohmann::json;
 
+namespace {
+    struct Options {
+        std::vector<std::string> positional;
+        unsigned optLevel = 0;
+        bool debugInfo = false;
+        bool remarks = false;
+        std::string remarksFile;
+        std::string remarksFilter;
+        StructLayoutMode structLayout = StructLayoutMode::Declared;
+        std::string structProfile;
+        bool wholeProgram = false;
+        bool tailRecursionLoops = false;
+        std::string callProfile;
+        FastMathFlags fastMath;  // None by default, strict IEEE semantics
+        std::string thinLTOPrefix;  // Set by --thinlto, every positional is then an AST input
+        unsigned jobs = 0;
+        bool linkRuntime = true;
+        JSONParser jsonParser = JSONParser::Simd;
+        bool benchJSON = false;
+        bool benchAST = false;
+        bool memReport = false;
+        std::string memReportFile;  // JSON copy of the report
+        bool stats = false;
+        std::string statsFile;
+        unsigned astThreads = 1;
+        std::string march;
+        std::string mcpu;
+        std::string mattr;
+        CodeGenBackend backend = CodeGenBackend::Auto;
+        bool benchCodegen = false;
+        unsigned benchFunctions = 10000;  // Size of the synthetic --bench-codegen input
+    };
+
+    bool startsWith(const std::string& arg, const std::string& prefix) {
+        return arg.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    bool endsWith(const std::string& arg, const std::string& suffix) {
+        return arg.size() >= suffix.size() &&
+               arg.compare(arg.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // The unsigned number after prefix in arg, anything else is a usage error
+    unsigned parseCount(const std::string& arg, const std::string& prefix) {
+        const char* begin = arg.data() + prefix.size();
+        const char* end = arg.data() + arg.size();
+        unsigned count = 0;
+        auto [last, error] = std::from_chars(begin, end, count);
+        if (error != std::errc() || last != end || begin == end) {
+            std::cout << "Invalid number in option: " << arg << "\n";
+            exit(1);
+        }
+        return count;
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.size() == 3 && startsWith(arg, "-O") && arg[2] >= '0' && arg[2] <= '3') {
+                options.optLevel = arg[2] - '0';
+            } else if (arg == "--whole-program") {
+                options.wholeProgram = true;
+            } else if (arg == "--tail-recursion-loops") {
+                options.tailRecursionLoops = true;
+            } else if (arg == "-ffast-math") {
+                options.fastMath.setFast();
+            } else if (arg == "-fno-fast-math") {
+                options.fastMath = FastMathFlags();
+            } else if (arg == "-fassociative-math") {
+                options.fastMath.setAllowReassoc();
+            } else if (arg == "-freciprocal-math") {
+                options.fastMath.setAllowReciprocal();
+            } else if (arg == "-ffinite-math-only") {
+                options.fastMath.setNoNaNs();
+                options.fastMath.setNoInfs();
+            } else if (arg == "-fno-signed-zeros") {
+                options.fastMath.setNoSignedZeros();
+            } else if (arg == "-ffp-contract=fast" || arg == "-ffp-contract=off") {
+                options.fastMath.setAllowContract(arg == "-ffp-contract=fast");
+            } else if (startsWith(arg, "--thinlto=")) {
+                options.thinLTOPrefix = arg.substr(std::string("--thinlto=").size());
+            } else if (startsWith(arg, "-j") && arg.size() > 2) {
+                options.jobs = parseCount(arg, "-j");
+            } else if (startsWith(arg, "-march=")) {
+                options.march = arg.substr(std::string("-march=").size());
+            } else if (startsWith(arg, "-mcpu=")) {
+                options.mcpu = arg.substr(std::string("-mcpu=").size());
+            } else if (startsWith(arg, "-mattr=")) {
+                options.mattr = arg.substr(std::string("-mattr=").size());
+            } else if (arg == "--json-parser=simd") {
+                options.jsonParser = JSONParser::Simd;
+            } else if (arg == "--json-parser=nlohmann") {
+                options.jsonParser = JSONParser::Nlohmann;
+            } else if (arg == "--bench-json") {
+                options.benchJSON = true;
+            } else if (arg == "--mem-report") {
+                options.memReport = true;
+            } else if (startsWith(arg, "--mem-report=")) {
+                options.memReport = true;
+                options.memReportFile = arg.substr(std::string("--mem-report=").size());
+            } else if (arg == "--stats") {
+                options.stats = true;
+            } else if (startsWith(arg, "--stats=")) {
+                options.stats = true;
+                options.statsFile = arg.substr(std::string("--stats=").size());
+            } else if (startsWith(arg, "--backend=")) {
+                std::string backend = arg.substr(std::string("--backend=").size());
+                if (backend == "auto") {
+                    options.backend = CodeGenBackend::Auto;
+                } else if (backend == "fast") {
+                    options.backend = CodeGenBackend::Fast;
+                } else if (backend == "globalisel") {
+                    options.backend = CodeGenBackend::GlobalISel;
+                } else if (backend == "default") {
+                    options.backend = CodeGenBackend::Default;
+                } else {
+                    std::cout << "Unknown backend: " << backend << "\n";
+                    exit(1);
+                }
+            } else if (arg == "--bench-codegen") {
+                options.benchCodegen = true;
+            } else if (startsWith(arg, "--bench-codegen=")) {
+                options.benchCodegen = true;
+                options.benchFunctions = parseCount(arg, "--bench-codegen=");
+            } else if (arg == "--bench-ast") {
+                options.benchAST = true;
+            } else if (startsWith(arg, "--ast-threads=")) {
+                options.astThreads = parseCount(arg, "--ast-threads=");
+                if (options.astThreads == 0)
+                    options.astThreads = std::max(1u, std::thread::hardware_concurrency());
+            } else if (arg == "--no-runtime") {
+                options.linkRuntime = false;
+            } else if (arg == "-g") {
+                options.debugInfo = true;
+            } else if (startsWith(arg, "--remarks=")) {
+                options.remarks = true;
+                options.remarksFile = arg.substr(std::string("--remarks=").size());
+            } else if (startsWith(arg, "--remarks-filter=")) {
+                options.remarks = true;
+                options.remarksFilter = arg.substr(std::string("--remarks-filter=").size());
+            } else if (startsWith(arg, "--struct-layout=")) {
+                std::string mode = arg.substr(std::string("--struct-layout=").size());
+                if (mode == "declared") {
+                    options.structLayout = StructLayoutMode::Declared;
+                } else if (mode == "compact") {
+                    options.structLayout = StructLayoutMode::Compact;
+                } else if (mode == "hotcold") {
+                    options.structLayout = StructLayoutMode::HotCold;
+                } else {
+                    std::cout << "Unknown struct layout: " << mode << "\n";
+                    exit(1);
+                }
+            } else if (startsWith(arg, "--struct-profile=")) {
+                options.structLayout = StructLayoutMode::HotCold;
+                options.structProfile = arg.substr(std::string("--struct-profile=").size());
+            } else if (startsWith(arg, "--call-profile=")) {
+                options.callProfile = arg.substr(std::string("--call-profile=").size());
+            } else if (startsWith(arg, "-") && arg.size() > 1) {
+                std::cout << "Unknown option: " << arg << "\n";
+                exit(1);
+            } else {
+                options.positional.push_back(arg);
+            }
+        }
+        return options;
+    }
+}  // namespace
+
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cout << "1# json ast path #2 output path [#3] print AST\n";
+    Options options = parseOptions(argc, argv);
+    if (options.benchJSON || options.benchAST) {
+        unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (const std::string& file : options.positional) {
+            if (options.benchJSON)
+                benchmarkJSONParsers(file, std::cout);
+            if (options.benchAST)
+                benchmarkASTConstruction(file, maxThreads, std::cout);
+        }
+        return 0;
+    }
+    TargetConfig target = resolveTargetConfig(options.march, options.mcpu, options.mattr);
+    target.backend = options.backend;
+    if (!options.thinLTOPrefix.empty() && !options.positional.empty()) {
+        if (options.wholeProgram) {
+            // The thin link does the internalization across modules itself
+            std::cout << "--whole-program needs a single module, drop it with --thinlto\n";
+            exit(1);
+        }
+        ThinLTOOptions thinLTO;
+        thinLTO.optLevel = options.optLevel;
+        thinLTO.jobs = options.jobs;
+        thinLTO.linkRuntime = options.linkRuntime;
+        thinLTO.target = target;
+        thinLTO.jsonParser = options.jsonParser;
+        thinLTO.fastMath = options.fastMath;
+        thinLTO.outputPrefix = options.thinLTOPrefix;
+        std::vector<std::string> objects;
+        try {
+            objects = buildThinLTO(options.positional, thinLTO);
+        } catch (const std::runtime_error& e) {
+            // Errors in the program, e.g. a function defined in two modules
+            std::cout << e.what() << "\n";
+            exit(1);
+        }
+        for (const std::string& object : objects)
+            std::cout << object << "\n";
+        return 0;
+    }
+    if (options.positional.size() < (options.benchCodegen ? 1 : 2)) {
+        std::cout << "1# json ast path #2 output path (.o/.obj object, .s assembly, else IR)"
+                  << " [#3] print AST\n"
+                  << "options:\n"
+                  << "  -O0..-O3                  optimization level (default -O0)\n"
+                  << "  -g                        emit line tables from the AST locations\n"
+                  << "  --remarks=<file>          write optimization remarks (.yaml or .bitstream)\n"
+                  << "  --remarks-filter=<regex>  only keep remarks from matching passes\n"
+                  << "  --struct-layout=<mode>    declared (default), compact or hotcold\n"
+                  << "  --struct-profile=<file>   field access counts for hotcold\n"
+                  << "  --whole-program           internal linkage, fastcc/tailcc and inferred\n"
+                  << "                            attributes\n"
+                  << "  --tail-recursion-loops    turn self-recursive tail calls into loops at -O0 too\n"
+                  << "  -ffast-math               all of the following FP flags\n"
+                  << "  -fassociative-math        reassociate FP ops, e.g. to vectorize reductions\n"
+                  << "  -ffp-contract=fast|off    fuse a * b + c into fma where the target has it\n"
+                  << "  -ffinite-math-only        assume no NaN or infinity\n"
+                  << "  -fno-signed-zeros         ignore the sign of zero\n"
+                  << "  -freciprocal-math         x / y may become x * (1 / y)\n"
+                  << "  --call-profile=<file>     calls per function pointer target, hot targets are\n"
+                  << "                            called directly behind a compare\n"
+                  << "  --thinlto=<prefix>        compile every json ast as its own module, thin link\n"
+                  << "                            and write <prefix>.<n>.bc and <prefix>.<n>.o\n"
+                  << "  -j<n>                     threads for --thinlto (default: all cores)\n"
+                  << "  --no-runtime              leave print_* etc. to be linked natively\n"
+                  << "  -march=<cpu>|native       target CPU, native also uses the host features\n"
+                  << "  -mcpu=<cpu>|native        same as -march, takes precedence\n"
+                  << "  -mattr=<+f,-f,...>        enable or disable target features\n"
+                  << "  --backend=<backend>       auto (fast at -O0, else default), fast (FastISel,\n"
+                  << "                            fast regalloc), globalisel or default (SelectionDAG)\n"
+                  << "  --bench-codegen[=<n>]     time native codegen of n (10000) functions per backend\n"
+                  << "  --json-parser=<parser>    simd (default) or nlohmann\n"
+                  << "  --bench-json              compare both json parsers on every input\n"
+                  << "  --ast-threads=<n>         build top-level declarations in parallel (0: all cores)\n"
+                  << "  --bench-ast               time AST construction with 1, 2, 4, ... threads\n"
+                  << "  --mem-report[=<file>]     allocations and rss per phase, optionally as json\n"
+                  << "  --stats[=<file>]          per-function IR statistics, optionally as json\n";
         exit(1);
     }
-    std::string filePath = argv[1];
-    nlohmann::json ast = loadASTFromFile(filePath);
-    ProgramNode* program = fromJSON(ast);
-    if (argc == 3)
+    std::unique_ptr<MemReport> memReport;
+    if (options.memReport)
+        memReport = std::make_unique<MemReport>();
+    auto beginPhase = [&](const char* name) {
+        if (memReport)
+            memReport->beginPhase(name);
+    };
+
+    std::string filePath = options.positional[0];
+    beginPhase("load");
+    nlohmann::json ast = loadASTFromFile(filePath, options.jsonParser);
+    beginPhase("fromJSON");
+    ProgramNode* program = fromJSON(ast, options.astThreads);
+    if (options.positional.size() == 2)
         printAST(program);
+    beginPhase("sema");
+    analyzeSemantics(program);
 
-    CodeGen codeGen("MyProgram");
+    // Sizes and alignments must match the runtime the module is linked with
+    beginPhase("codegen");
+    std::unique_ptr<TargetMachine> targetMachine = createTargetMachine(target, options.optLevel);
+    CodeGen codeGen("MyProgram", targetMachine.get());
+    if (options.structLayout == StructLayoutMode::HotCold) {
+        StructUsage usage = analyzeStructUsage(program);
+        if (!options.structProfile.empty())
+            loadStructProfile(usage, options.structProfile);
+        codeGen.setStructLayout(options.structLayout, std::move(usage));
+    } else {
+        codeGen.setStructLayout(options.structLayout);
+    }
+    if (options.wholeProgram)
+        codeGen.setWholeProgram(analyzeFunctionAttrs(program));
+    if (options.tailRecursionLoops)
+        codeGen.setTailRecursionLoops();
+    codeGen.setFastMath(options.fastMath);
+    if (options.optLevel > 0 || !options.callProfile.empty()) {
+        CallTargets callTargets = analyzeCallTargets(program);
+        if (!options.callProfile.empty())
+            loadCallProfile(callTargets, options.callProfile);
+        codeGen.setCallTargets(std::move(callTargets));
+    }
+    // Remarks are only useful when they can point back to a source line
+    if (options.debugInfo || options.remarks)
+        codeGen.enableDebugInfo(filePath);
     codeGen.generate(program);
-    codeGen.printToFile(argv[2]);
 
-    //   InitializeAllTargets();
-    //   InitializeAllTargetMCs();
-    //   InitializeAllAsmPrinters();
-    //   InitializeAllAsmParsers();
+    // Before the runtime is linked, only the program's own functions count
+    std::vector<ModuleStats> stats;
+    std::set<std::string> programFunctions;
+    if (options.stats) {
+        stats.push_back(collectIRStats(*codeGen.getModule(), "generate"));
+        for (const llvm::Function& function : *codeGen.getModule()) {
+            if (!function.isDeclaration())
+                programFunctions.insert(function.getName().str());
+        }
+        enableLLVMStatistics();
+    }
+    if (options.linkRuntime)
+        linkRuntime(*codeGen.getModule());
+    beginPhase("verify");
+    codeGen.verify();
+
+    std::unique_ptr<OptRemarks> remarks;
+    if (options.remarks) {
+        remarks = std::make_unique<OptRemarks>(
+            *codeGen.getContext(), options.remarksFile, options.remarksFilter
+        );
+    }
+    beginPhase("optimize");
+    codeGen.optimize(options.optLevel);
+    if (remarks) {
+        remarks->finish();
+        remarks->printSummary(std::cout);
+    }
+    if (options.stats) {
+        if (options.optLevel > 0)
+            stats.push_back(collectIRStats(*codeGen.getModule(), "optimize", &programFunctions));
+        printIRStats(stats, std::cout);
+        if (!options.statsFile.empty())
+            writeIRStatsJSON(stats, options.statsFile);
+    }
+
+    if (options.benchCodegen) {
+        benchmarkBackends(
+            *codeGen.getModule(), target, options.optLevel, options.benchFunctions, std::cout
+        );
+        return 0;
+    }
+
+    beginPhase("emit");
+    const std::string& outputPath = options.positional[1];
+    if (endsWith(outputPath, ".o") || endsWith(outputPath, ".obj") || endsWith(outputPath, ".s"))
+        emitNativeFile(*codeGen.getModule(), *targetMachine, outputPath);
+    else
+        codeGen.printToFile(outputPath);
+
+    if (memReport) {
+        memReport->finish();
+        memReport->printTable(std::cout);
+        if (!options.memReportFile.empty())
+            memReport->writeJSON(options.memReportFile);
+    }
 
     std::cout << "Compiler initialized!" << std::endl;
     return 0;
-}
\ No newline at end of file
+}
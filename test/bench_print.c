@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include <time.h>
+
+// Prints 10M integers through print_int, link against runtime.c or runtime_printf.c
+// and redirect stdout to compare the two. The time goes to stderr
+
+void print_int(int x);
+
+#define COUNT 10000000
+
+int main(void) {
+    clock_t start = clock();
+    for (int i = 0; i < COUNT; i++)
+        print_int(i - COUNT / 2);
+    fflush(stdout);
+
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    fprintf(stderr, "%d print_int calls: %.3f s\n", COUNT, seconds);
+    return 0;
+}
@@ -0,0 +1,916 @@
+# Targeted checks of what individual compiler features do, next to the perf suite which only
+# compares checksums and times. Every check is a small program built with the AST builders of
+# ../perf/make_kernels.py and expects some of:
+#   ir       patterns the emitted LLVM IR must contain, or functions given the IR text that
+#            return an error message or None
+#   not_ir   patterns the IR must not contain
+#   output   what the program prints when compiled to an object file, linked and run
+#   error    text of the error the compiler must fail with
+# A check may also give a call or struct profile, passed to the compiler with --call-profile
+# and --struct-profile. {base} in a flag is the path of the check's files without extension.
+# usage: python run_checks.py <my_compiler> [--cc clang] [--checks switch_default_order,...]
+#            [--work-dir checks_work]
+# Exits with 1 if any check fails.
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, "..", "perf"))
+
+from make_kernels import (  # noqa: E402
+    ARENA_ALLOC,
+    DOUBLE,
+    DOUBLE4,
+    INT,
+    POOL_ALLOC,
+    POOL_FREE,
+    PRINT_INT,
+    VOID,
+    add,
+    addr,
+    and_,
+    assign,
+    binary,
+    block,
+    brk,
+    call,
+    cont,
+    count,
+    decl,
+    div,
+    dot,
+    eq,
+    extern,
+    function,
+    function_ptr,
+    if_,
+    inc,
+    index,
+    init_list,
+    mod,
+    mul,
+    named,
+    ne,
+    parallel,
+    prim,
+    ptr,
+    ret,
+    stmt,
+    struct,
+    sub,
+    switch,
+    unary,
+    var,
+)
+from run_perf import EXE_SUFFIX, LIBS  # noqa: E402
+
+
+def check(
+    program,
+    flags=(),
+    ir=(),
+    not_ir=(),
+    output=None,
+    error=None,
+    env=None,
+    profile=None,
+    struct_profile=None,
+):
+    return {
+        "program": program,
+        "flags": list(flags),
+        "profile": profile,
+        "struct_profile": struct_profile,
+        "ir": list(ir),
+        "not_ir": list(not_ir),
+        "output": output,
+        "error": error,
+        "env": env or {},
+    }
+
+
+def const(declaration):
+    # decl() or var() marked const
+    target = declaration.get("expression", declaration)
+    target["const"] = True
+    return declaration
+
+
+def main_printing(*statements):
+    # int main() { statements; return 0; } with print_int declared
+    return [PRINT_INT, function("main", INT, [], *statements, ret(0))]
+
+
+def functions_of(ir):
+    # name -> lines of each definition in the IR text
+    functions = {}
+    current = None
+    for line in ir.splitlines():
+        match = re.match(r"define .*@([\w.$]+)\(", line)
+        if match:
+            current = functions.setdefault(match.group(1), [])
+        elif line.startswith("}"):
+            current = None
+        elif current is not None:
+            current.append(line)
+    return functions
+
+
+def allocas_in_entry(ir):
+    for name, lines in functions_of(ir).items():
+        labels = 0
+        for line in lines:
+            if re.match(r"^[\w.$-]+:", line):
+                labels += 1
+            elif " alloca " in line and labels > 1:
+                return "alloca outside the entry block of " + name
+    return None
+
+
+# ==== Checks ====
+
+
+def switch_default_order():
+    # default in the middle: case 1 falls through into default, default into case 2
+    cases = [
+        (1, [stmt(assign("r", add(mul("r", 10), 1)))]),
+        (None, [stmt(assign("r", add(mul("r", 10), 9)))]),
+        (2, [stmt(assign("r", add(mul("r", 10), 2))), brk()]),
+        (3, [stmt(assign("r", 3))]),
+    ]
+    return check(
+        [
+            PRINT_INT,
+            function(
+                "classify",
+                INT,
+                [("x", INT)],
+                decl("r", INT, 0),
+                switch("x", cases),
+                ret("r"),
+            ),
+            function(
+                "main",
+                INT,
+                [],
+                *[stmt(call("print_int", call("classify", x))) for x in (1, 2, 3, 4)],
+                ret(0),
+            ),
+        ],
+        output="192\n2\n3\n92\n",
+    )
+
+
+def break_continue():
+    # continue inside a switch continues the loop around it, break in a case leaves the switch
+    return check(
+        main_printing(
+            decl("sum", INT, 0),
+            count(
+                "i",
+                0,
+                10,
+                if_(eq("i", 7), block(brk())),
+                switch("i", [(3, [cont()]), (5, [stmt(assign("sum", add("sum", 100))), brk()])]),
+                stmt(assign("sum", add("sum", "i"))),
+            ),
+            stmt(call("print_int", "sum")),
+        ),
+        output="118\n",
+    )
+
+
+def locals_in_entry_block():
+    # A declaration inside a loop must not grow the stack on every iteration
+    return check(
+        main_printing(
+            decl("sum", INT, 0),
+            count(
+                "i",
+                0,
+                10,
+                decl("twice", INT, mul("i", 2)),
+                stmt(assign("sum", add("sum", "twice"))),
+            ),
+            stmt(call("print_int", "sum")),
+        ),
+        flags=["--no-runtime"],
+        ir=[allocas_in_entry],
+    )
+
+
+def break_outside_loop():
+    return check(main_printing(brk()), error="break outside of a loop or switch")
+
+
+def continue_in_switch():
+    # A switch is no loop to continue
+    return check(main_printing(switch(1, [(1, [cont()])])), error="continue outside of a loop")
+
+
+def duplicate_case():
+    return check(
+        main_printing(switch(1, [(1, [brk()]), (1, [brk()])])), error="Duplicate case value"
+    )
+
+
+def duplicate_default():
+    return check(
+        main_printing(switch(1, [(None, [brk()]), (2, [brk()]), (None, [brk()])])),
+        error="Duplicate default in switch",
+    )
+
+
+def function_pointer_values():
+    # Function names used as values, as in the fnptr_dispatch kernel
+    op = named("Op")
+    return check(
+        [
+            PRINT_INT,
+            function_ptr("Op", INT, INT, INT),
+            function("op_add", INT, [("a", INT), ("b", INT)], ret(add("a", "b"))),
+            function("op_sub", INT, [("a", INT), ("b", INT)], ret(sub("a", "b"))),
+            function("apply", INT, [("f", op), ("a", INT), ("b", INT)], ret(call("f", "a", "b"))),
+            function(
+                "main",
+                INT,
+                [],
+                decl("f", op, "op_add"),
+                stmt(call("print_int", call("apply", "f", 7, 2))),
+                stmt(assign("f", "op_sub")),
+                stmt(call("print_int", call("apply", "f", 7, 2))),
+                ret(0),
+            ),
+        ],
+        output="9\n5\n",
+    )
+
+
+def struct_array_member_write():
+    # Written through a member of an element, the table must stay a local copy and not rodata
+    return check(
+        [
+            PRINT_INT,
+            struct("Pair", ("a", INT), ("b", INT)),
+            function(
+                "main",
+                INT,
+                [],
+                decl("pairs", named("Pair"), init_list((1, 2), (3, 4)), size=2),
+                stmt(assign(dot(index("pairs", 1), "b"), 9)),
+                stmt(call("print_int", dot(index("pairs", 1), "b"))),
+                stmt(call("print_int", dot(index("pairs", 0), "a"))),
+                ret(0),
+            ),
+        ],
+        output="9\n1\n",
+    )
+
+
+def split_struct_element_copy():
+    # note would be cold, but recs[1] = recs[0] copies the hot part with its pointer to the cold
+    # one. Rec must stay whole or both elements share one note
+    def rec(i, field):
+        return dot(index("recs", i), field)
+
+    return check(
+        [
+            PRINT_INT,
+            struct("Rec", ("key", INT), ("note", INT)),
+            function(
+                "main",
+                INT,
+                [],
+                decl("recs", named("Rec"), size=2),
+                stmt(assign(rec(0, "key"), 1)),
+                stmt(assign(rec(0, "note"), 10)),
+                stmt(assign(rec(1, "key"), 2)),
+                stmt(assign(rec(1, "note"), 20)),
+                stmt(assign(index("recs", 1), index("recs", 0))),
+                stmt(assign(rec(1, "note"), 30)),
+                stmt(call("print_int", rec(0, "note"))),
+                stmt(call("print_int", rec(1, "note"))),
+                stmt(call("print_int", rec(1, "key"))),
+                ret(0),
+            ),
+        ],
+        struct_profile={"Rec": {"key": 100, "note": 1}},
+        not_ir=[r"%Rec\.cold"],
+        output="10\n30\n1\n",
+    )
+
+
+def const_assign():
+    return check(
+        main_printing(const(decl("x", INT, 1)), stmt(assign("x", 2))),
+        error="Cannot assign to const variable: x",
+    )
+
+
+def const_increment():
+    return check(
+        main_printing(const(decl("x", INT, 1)), stmt(inc("x"))),
+        error="Cannot assign to const variable: x",
+    )
+
+
+def const_element_write():
+    # Through an element and a member of a const local
+    return check(
+        [
+            PRINT_INT,
+            struct("Pair", ("a", INT), ("b", INT)),
+            function(
+                "main",
+                INT,
+                [],
+                const(decl("pairs", named("Pair"), init_list((1, 2), (3, 4)), size=2)),
+                stmt(assign(dot(index("pairs", 1), "b"), 9)),
+                ret(0),
+            ),
+        ],
+        error="Cannot assign to const variable: pairs",
+    )
+
+
+def const_global_write():
+    return check(
+        [
+            PRINT_INT,
+            const(var("table", INT, init_list(1, 2, 3), size=3)),
+            function("main", INT, [], stmt(assign(index("table", 0), 5)), ret(0)),
+        ],
+        error="Cannot assign to const variable: table",
+    )
+
+
+def const_address():
+    # Pointers have no const, so the address of a const would allow writes
+    return check(
+        main_printing(const(decl("x", INT, 1)), decl("p", ptr(INT), addr("x"))),
+        error="Cannot take the address of const variable: x",
+    )
+
+
+def const_reads():
+    return check(
+        [
+            PRINT_INT,
+            const(var("scale", INT, 3)),
+            function(
+                "main",
+                INT,
+                [],
+                const(decl("table", INT, init_list(5, 6, 7), size=3)),
+                const(decl("offset", INT, 4)),
+                stmt(call("print_int", add(mul(index("table", 2), "scale"), "offset"))),
+                ret(0),
+            ),
+        ],
+        output="25\n",
+    )
+
+
+def nan_conditions():
+    # NaN is non-zero, so true as a condition, and unequal to everything including itself
+    def print_if(condition):
+        return if_(condition, block(stmt(call("print_int", 1))), block(stmt(call("print_int", 0))))
+
+    return check(
+        main_printing(
+            decl("zero", DOUBLE, 0.0),
+            decl("nan", DOUBLE, div("zero", "zero")),
+            print_if("nan"),
+            print_if(ne("nan", "nan")),
+            print_if(eq("nan", "nan")),
+            print_if(unary("!", "nan")),
+        ),
+        output="1\n1\n0\n0\n",
+    )
+
+
+def nan_condition_ir():
+    return check(
+        main_printing(
+            decl("x", DOUBLE, 0.5),
+            if_("x", block(stmt(call("print_int", 1)))),
+        ),
+        flags=["--no-runtime"],
+        ir=[r"fcmp une double %[\w.]+, 0\.000000e\+00"],
+        not_ir=[r"fcmp one "],
+    )
+
+
+def allocation_sizes_ir():
+    # Constant sizes go to the runtime entries taking a rounded size or a size class, anything
+    # else keeps the plain call
+    return check(
+        [
+            ARENA_ALLOC,
+            POOL_ALLOC,
+            POOL_FREE,
+            function(
+                "sizes",
+                VOID,
+                [("n", INT)],
+                decl("a", ptr(VOID), call("arena_alloc", "n")),
+                decl("b", ptr(VOID), call("arena_alloc", 20)),
+                decl("c", ptr(VOID), call("pool_alloc", "n")),
+                decl("d", ptr(VOID), call("pool_alloc", 24)),
+                decl("e", ptr(VOID), call("pool_alloc", 300)),
+                stmt(call("pool_free", "c", "n")),
+                stmt(call("pool_free", "d", 24)),
+                stmt(call("pool_free", "e", 300)),
+            ),
+        ],
+        flags=["--no-runtime"],
+        ir=[
+            r"call ptr @arena_alloc\(i32 %",
+            r"call ptr @__arena_alloc_rounded\(i64 32\)",
+            r"call ptr @pool_alloc\(i32 %",
+            r"call ptr @__pool_alloc_class\(i32 1\)",
+            r"call ptr @pool_alloc\(i32 300\)",
+            r"call void @pool_free\(ptr %[\w.]+, i32 %",
+            r"call void @__pool_free_class\(ptr %[\w.]+, i32 1\)",
+            r"call void @pool_free\(ptr %[\w.]+, i32 300\)",
+        ],
+    )
+
+
+def pool_sizes():
+    # Every size through the plain entries, the pool and malloc ones, and freeing NULL with a
+    # constant size that goes straight to the size class
+    return check(
+        [
+            PRINT_INT,
+            POOL_ALLOC,
+            POOL_FREE,
+            var("none", ptr(VOID)),
+            function(
+                "main",
+                INT,
+                [],
+                decl("sum", INT, 0),
+                count(
+                    "n",
+                    1,
+                    300,
+                    decl("p", ptr(INT), call("pool_alloc", mul("n", 4))),
+                    stmt(assign(index("p", sub("n", 1)), "n")),
+                    stmt(assign("sum", add("sum", index("p", sub("n", 1))))),
+                    stmt(call("pool_free", "p", mul("n", 4))),
+                ),
+                stmt(call("pool_free", "none", 32)),
+                stmt(call("pool_free", "none", 1000)),
+                decl("a", ptr(VOID), call("pool_alloc", 32)),
+                stmt(call("pool_free", "a", 32)),
+                if_(eq(call("pool_alloc", 32), "a"), block(stmt(call("print_int", "sum")))),
+                ret(0),
+            ),
+        ],
+        output="44850\n",
+    )
+
+
+def parallel_for_body():
+    # break inside a switch or an inner loop stays in the body, on several threads
+    n = 1000
+    return check(
+        [
+            PRINT_INT,
+            var("values", INT, size=n),
+            function(
+                "main",
+                INT,
+                [],
+                parallel(
+                    count(
+                        "i",
+                        0,
+                        n,
+                        decl("v", INT, 0),
+                        switch(
+                            mod("i", 2),
+                            [
+                                (0, [stmt(assign("v", "i")), brk()]),
+                                (None, [stmt(assign("v", mul("i", 2))), brk()]),
+                            ],
+                        ),
+                        count("k", 0, 10, if_(eq("k", 1), block(brk()))),
+                        stmt(assign(index("values", "i"), "v")),
+                    ),
+                    "dynamic",
+                    7,
+                ),
+                decl("sum", INT, 0),
+                count("i", 0, n, stmt(assign("sum", add("sum", index("values", "i"))))),
+                stmt(call("print_int", "sum")),
+                ret(0),
+            ),
+        ],
+        output="749500\n",
+        env={"PARALLEL_THREADS": "4"},
+    )
+
+
+def parallel_for_output_order():
+    # Each thread prints into its own buffer, output from the body lands between what main
+    # printed before and after the loop
+    return check(
+        main_printing(
+            stmt(call("print_int", 1)),
+            parallel(count("i", 0, 64, stmt(call("print_int", 7))), "dynamic", 1),
+            stmt(call("print_int", 2)),
+        ),
+        output="1\n" + "7\n" * 64 + "2\n",
+        env={"PARALLEL_THREADS": "4"},
+    )
+
+
+def parallel_for_break():
+    return check(
+        main_printing(parallel(count("i", 0, 10, if_(eq("i", 5), block(brk()))))),
+        error="break out of a parallel for",
+    )
+
+
+def parallel_for_return():
+    return check(
+        main_printing(parallel(count("i", 0, 10, if_(eq("i", 5), block(ret(1)))))),
+        error="return inside a parallel for",
+    )
+
+
+def parallel_for_counter_assigned():
+    return check(
+        main_printing(parallel(count("i", 0, 10, stmt(assign("i", add("i", 1)))))),
+        error="Parallel for variable is assigned: i",
+    )
+
+
+def tail_call_ir():
+    # Under --whole-program recursive functions never used as values are tailcc, return f(x)
+    # to the same signature is a musttail call even at -O0
+    n = [("n", INT)]
+    return check(
+        [
+            extern("is_odd", INT, *n),
+            function(
+                "is_even",
+                INT,
+                n,
+                if_(eq("n", 0), block(ret(1))),
+                ret(call("is_odd", sub("n", 1))),
+            ),
+            function(
+                "is_odd",
+                INT,
+                n,
+                if_(eq("n", 0), block(ret(0))),
+                ret(call("is_even", sub("n", 1))),
+            ),
+            function("main", INT, [], ret(call("is_even", 7))),
+        ],
+        flags=["--no-runtime", "--whole-program"],
+        ir=[
+            r"define internal tailcc i32 @is_even\(",
+            r"musttail call tailcc i32 @is_odd\(",
+            r"musttail call tailcc i32 @is_even\(",
+        ],
+    )
+
+
+def tail_call_escaping_local():
+    # The callee may be handed the address of a local, so the frame has to stay
+    return check(
+        [
+            function("peek", INT, [("p", ptr(INT))], ret(unary("*", "p"))),
+            function(
+                "walk",
+                INT,
+                [("n", INT)],
+                decl("x", INT, "n"),
+                if_(eq("n", 0), block(ret(call("peek", addr("x"))))),
+                ret(call("walk", sub("n", 1))),
+            ),
+            function("main", INT, [], ret(call("walk", 3))),
+        ],
+        flags=["--no-runtime", "--whole-program"],
+        not_ir=[r"musttail", r"tail call"],
+    )
+
+
+def promoted_call():
+    # apply's f can only be op_add or op_sub, op_add is the hot one and its branch gets the
+    # profile weights. op_mul is profiled but never reaches f, so it isn't guarded. Anything
+    # else still takes the indirect call
+    op = named("Op")
+    return check(
+        [
+            PRINT_INT,
+            function_ptr("Op", INT, INT, INT),
+            function("op_add", INT, [("a", INT), ("b", INT)], ret(add("a", "b"))),
+            function("op_sub", INT, [("a", INT), ("b", INT)], ret(sub("a", "b"))),
+            function("op_mul", INT, [("a", INT), ("b", INT)], ret(mul("a", "b"))),
+            function("apply", INT, [("f", op), ("a", INT), ("b", INT)], ret(call("f", "a", "b"))),
+            function(
+                "main",
+                INT,
+                [],
+                stmt(call("print_int", call("apply", "op_add", 7, 2))),
+                stmt(call("print_int", call("apply", "op_sub", 7, 2))),
+                ret(0),
+            ),
+        ],
+        profile={"apply:f": {"op_add": 90, "op_sub": 10, "op_mul": 30}},
+        ir=[
+            r"%icp\.is\.op_add = icmp eq ptr %[\w.]+, @op_add",
+            r"br i1 %icp\.is\.op_add, label %[\w.]+, label %[\w.]+, !prof",
+            r"%icp\.is\.op_sub = icmp eq ptr %[\w.]+, @op_sub",
+            r"%icp\.call[\w.]* = call i32 @op_add\(",
+            r"%indirect_call[\w.]* = call i32 %",
+            r"%icp\.result = phi i32 ",
+        ],
+        not_ir=[r"icp\.is\.op_mul"],
+        output="9\n5\n",
+    )
+
+
+def int4_lanes():
+    # Scalars fill every lane, comparisons give all bits set in the lanes where they hold
+    int4 = prim("int4")
+    return check(
+        main_printing(
+            decl("v", int4, init_list(1, 2, 3, 4)),
+            decl("w", int4, add(mul("v", 2), 1)),
+            decl("mask", int4, binary(">", "w", 5)),
+            stmt(call("print_int", call("__builtin_reduce_add", "w"))),
+            stmt(call("print_int", call("__builtin_reduce_add", "mask"))),
+            stmt(call("print_int", index("w", 2))),
+            stmt(assign(index("w", 0), 100)),
+            stmt(call("print_int", index("w", 0))),
+        ),
+        ir=[
+            r"mul <4 x i32> %[\w.]+, (splat \(i32 2\)|<i32 2, i32 2, i32 2, i32 2>)",
+            r"icmp sgt <4 x i32>",
+            r"call i32 @llvm\.vector\.reduce\.add\.v4i32\(",
+        ],
+        output="24\n-2\n7\n100\n",
+    )
+
+
+def vector_to_scalar():
+    return check(
+        main_printing(decl("v", DOUBLE4, 1.0), decl("x", DOUBLE, "v")),
+        error="Cannot convert double4 to a scalar",
+    )
+
+
+def vector_condition():
+    return check(
+        main_printing(decl("v", DOUBLE4, 1.0), if_("v", block(stmt(call("print_int", 1))))),
+        error="Vector used as a condition",
+    )
+
+
+def mixed_vectors():
+    return check(
+        main_printing(
+            decl("a", DOUBLE4, 1.0), decl("b", prim("int4"), 1), stmt(assign("a", add("a", "b")))
+        ),
+        error="Invalid operands to vector +",
+    )
+
+
+def vector_logical_and():
+    return check(
+        main_printing(decl("a", prim("int4"), 1), decl("b", prim("int4"), 2), stmt(and_("a", "b"))),
+        error="Operator && needs scalar operands",
+    )
+
+
+def struct_copy_ir():
+    # Initializing from and assigning a struct in memory are one memcpy each, no load of the
+    # whole struct
+    triple = named("Triple")
+    return check(
+        [
+            PRINT_INT,
+            struct("Triple", ("a", INT), ("b", INT), ("c", INT)),
+            function(
+                "main",
+                INT,
+                [],
+                decl("p", triple, init_list(1, 2, 3)),
+                decl("q", triple, "p"),
+                stmt(assign(dot("q", "b"), 5)),
+                decl("r", triple, init_list(0, 0, 0)),
+                stmt(assign("r", "q")),
+                stmt(call("print_int", add(add(dot("r", "a"), dot("r", "b")), dot("r", "c")))),
+                stmt(call("print_int", dot("p", "b"))),
+                ret(0),
+            ),
+        ],
+        ir=[
+            r"call void @llvm\.memcpy\.p0\.p0\.i64\(ptr align 4 %[\w.]+, ptr align 4 %[\w.]+, i64 12,"
+        ],
+        not_ir=[r"= load %[\w.]*Triple, "],
+        output="9\n2\n",
+    )
+
+
+def bit_builtins_ir():
+    return check(
+        main_printing(
+            decl("x", INT, 40),
+            stmt(call("print_int", call("__builtin_popcount", "x"))),
+            stmt(call("print_int", call("__builtin_clz", "x"))),
+            stmt(call("print_int", call("__builtin_ctz", "x"))),
+            if_(call("__builtin_expect", eq("x", 40), 1), block(stmt(call("print_int", 1)))),
+        ),
+        ir=[
+            r"call i32 @llvm\.ctpop\.i32\(",
+            r"call i32 @llvm\.ctlz\.i32\(",
+            r"call i32 @llvm\.cttz\.i32\(",
+        ],
+        output="2\n26\n3\n1\n",
+    )
+
+
+def calls_have_locations(ir):
+    # Inlinable calls in a function with a DISubprogram need a !dbg, or the module is invalid
+    name = None
+    for line in ir.splitlines():
+        match = re.match(r"define .*@([\w.$]+)\(.*!dbg ", line)
+        if match:
+            name = match.group(1)
+        elif line.startswith("}"):
+            name = None
+        elif name and re.search(r"\bcall ", line) and "!dbg " not in line:
+            return "call without a location in " + name + ": " + line.strip()
+    return None
+
+
+def debug_info_without_locations():
+    # The builders give no source locations, under -g every node falls back to the line of
+    # its function. --remarks keeps the optimization record around the inliner
+    return check(
+        [
+            PRINT_INT,
+            function("twice", INT, [("n", INT)], ret(mul("n", 2))),
+            function(
+                "main",
+                INT,
+                [],
+                decl("sum", INT, 0),
+                count("i", 0, 4, stmt(assign("sum", add("sum", call("twice", "i"))))),
+                stmt(call("print_int", "sum")),
+                ret(0),
+            ),
+        ],
+        flags=["-g", "-O2", "--remarks={base}_remarks.yaml"],
+        ir=[r"!DISubprogram\(name: \"main\"", calls_have_locations],
+        output="12\n",
+    )
+
+
+CHECKS = {
+    "switch_default_order": switch_default_order,
+    "break_continue": break_continue,
+    "locals_in_entry_block": locals_in_entry_block,
+    "break_outside_loop": break_outside_loop,
+    "continue_in_switch": continue_in_switch,
+    "duplicate_case": duplicate_case,
+    "duplicate_default": duplicate_default,
+    "function_pointer_values": function_pointer_values,
+    "struct_array_member_write": struct_array_member_write,
+    "split_struct_element_copy": split_struct_element_copy,
+    "const_assign": const_assign,
+    "const_increment": const_increment,
+    "const_element_write": const_element_write,
+    "const_global_write": const_global_write,
+    "const_address": const_address,
+    "const_reads": const_reads,
+    "nan_conditions": nan_conditions,
+    "nan_condition_ir": nan_condition_ir,
+    "allocation_sizes_ir": allocation_sizes_ir,
+    "pool_sizes": pool_sizes,
+    "parallel_for_body": parallel_for_body,
+    "parallel_for_output_order": parallel_for_output_order,
+    "parallel_for_break": parallel_for_break,
+    "parallel_for_return": parallel_for_return,
+    "parallel_for_counter_assigned": parallel_for_counter_assigned,
+    "tail_call_ir": tail_call_ir,
+    "tail_call_escaping_local": tail_call_escaping_local,
+    "promoted_call": promoted_call,
+    "int4_lanes": int4_lanes,
+    "vector_to_scalar": vector_to_scalar,
+    "vector_condition": vector_condition,
+    "mixed_vectors": mixed_vectors,
+    "vector_logical_and": vector_logical_and,
+    "struct_copy_ir": struct_copy_ir,
+    "bit_builtins_ir": bit_builtins_ir,
+    "debug_info_without_locations": debug_info_without_locations,
+}
+
+
+# ==== Runner ====
+
+
+def parse_args():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("compiler", help="path to my_compiler")
+    parser.add_argument("--cc", default=os.environ.get("CC") or shutil.which("clang") or "cc")
+    parser.add_argument("--checks", default="", help="comma separated, all when empty")
+    parser.add_argument("--work-dir", default="checks_work")
+    return parser.parse_args()
+
+
+def run(command, env=None):
+    # my_compiler prints the whole AST, only shown when a check fails
+    result = subprocess.run(
+        command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, env=env
+    )
+    return result.returncode, result.stdout
+
+
+def run_check(args, name, spec):
+    base = os.path.join(args.work_dir, name)
+    json_file = base + ".json"
+    with open(json_file, "w") as out:
+        json.dump({"nodeType": "Program", "declarations": spec["program"]}, out, indent=2)
+    compile_command = [args.compiler, json_file]
+    for key, flag in (("profile", "--call-profile="), ("struct_profile", "--struct-profile=")):
+        if spec[key] is not None:
+            with open(base + "_" + key + ".json", "w") as out:
+                json.dump(spec[key], out)
+            compile_command.append(flag + base + "_" + key + ".json")
+    flags = [flag.replace("{base}", base) for flag in spec["flags"]]
+
+    if spec["error"] is not None:
+        code, log = run(compile_command + [base + ".ll"] + flags)
+        if code == 0:
+            return "compiled, expected the error: " + spec["error"]
+        if spec["error"] not in log:
+            return "failed without the error %r:\n%s" % (spec["error"], log[-2000:])
+        return None
+
+    if spec["ir"] or spec["not_ir"]:
+        code, log = run(compile_command + [base + ".ll"] + flags)
+        if code != 0:
+            return "compiling failed:\n" + log[-2000:]
+        with open(base + ".ll") as f:
+            ir = f.read()
+        for expected in spec["ir"]:
+            if callable(expected):
+                problem = expected(ir)
+                if problem:
+                    return problem
+            elif not re.search(expected, ir, re.MULTILINE):
+                return "IR does not match %r, see %s.ll" % (expected, base)
+        for unexpected in spec["not_ir"]:
+            if re.search(unexpected, ir, re.MULTILINE):
+                return "IR matches %r, see %s.ll" % (unexpected, base)
+
+    if spec["output"] is not None:
+        code, log = run(compile_command + [base + ".o"] + flags)
+        if code != 0:
+            return "compiling failed:\n" + log[-2000:]
+        exe = base + EXE_SUFFIX
+        code, log = run([args.cc, base + ".o", "-o", exe] + LIBS)
+        if code != 0:
+            return "linking failed:\n" + log[-2000:]
+        code, output = run([exe], dict(os.environ, **spec["env"]))
+        if code != 0:
+            return "exited with %d:\n%s" % (code, output[-2000:])
+        if output != spec["output"]:
+            return "printed %r, expected %r" % (output, spec["output"])
+    return None
+
+
+def main():
+    args = parse_args()
+    names = [k for k in args.checks.split(",") if k] or list(CHECKS)
+    for name in names:
+        if name not in CHECKS:
+            print("Unknown check: " + name)
+            return 1
+    os.makedirs(args.work_dir, exist_ok=True)
+
+    failures = 0
+    for name in names:
+        problem = run_check(args, name, CHECKS[name]())
+        print("%-32s %s" % (name, "ok" if problem is None else "FAIL " + problem))
+        failures += problem is not None
+    print("%d of %d checks failed" % (failures, len(names)) if failures else "all checks passed")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
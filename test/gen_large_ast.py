@@ -0,0 +1,39 @@
+# Writes an AST json of roughly the requested size for my_compiler --bench-json by
+# repeating the declarations of an existing AST with renamed identifiers.
+# usage: python gen_large_ast.py <source.json> <size MB> <output.json>
+
+import json
+import sys
+
+
+def rename(node, suffix):
+    if isinstance(node, dict):
+        return {
+            key: value + suffix if key == "identifier" else rename(value, suffix)
+            for key, value in node.items()
+        }
+    if isinstance(node, list):
+        return [rename(item, suffix) for item in node]
+    return node
+
+
+def main():
+    source, size_mb, output = sys.argv[1], float(sys.argv[2]), sys.argv[3]
+    with open(source) as f:
+        declarations = json.load(f)["declarations"]
+
+    one_copy = len(json.dumps({"declarations": declarations}, indent=2))
+    copies = max(1, int(size_mb * 1e6 / one_copy))
+
+    with open(output, "w") as out:
+        out.write('{\n  "nodeType": "Program",\n  "declarations": [\n')
+        for i in range(copies):
+            # The first copy keeps its names, so there is exactly one main
+            copy = rename(declarations, "_" + str(i)) if i > 0 else declarations
+            text = json.dumps(copy, indent=2)
+            out.write(text[1:-1].rstrip() + (",\n" if i + 1 < copies else "\n"))
+        out.write("  ]\n}\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,36 @@
+void print_int(int x);
+void arena_create(int capacity);
+void* arena_alloc(int size);
+void arena_reset();
+
+struct Node {
+    int value;
+    struct Node* next;
+};
+
+int main() {
+    int n = 100000;
+    int checksum = 0;
+    arena_create(1048576);
+    for (int rep = 0; rep < 1000; rep++) {
+        struct Node* head = arena_alloc(16);
+        head->value = rep;
+        head->next = head;
+        struct Node* tail = head;
+        for (int i = 1; i < n; i++) {
+            struct Node* node = arena_alloc(16);
+            node->value = i * 7 + rep;
+            node->next = head;
+            tail->next = node;
+            tail = node;
+        }
+        struct Node* p = head;
+        for (int i = 0; i < n; i++) {
+            checksum = checksum * 31 + p->value;
+            p = p->next;
+        }
+        arena_reset();
+    }
+    print_int(checksum);
+    return 0;
+}
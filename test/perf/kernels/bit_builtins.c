@@ -0,0 +1,10 @@
+void print_int(int x);
+
+int main() {
+    int checksum = 0;
+    for (int i = 1; i < 100000000; i++) {
+        checksum = checksum + (__builtin_popcount(i) * 3 + __builtin_clz(i) - __builtin_ctz(i));
+    }
+    print_int(checksum);
+    return 0;
+}
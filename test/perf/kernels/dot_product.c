@@ -0,0 +1,22 @@
+void print_double(double x);
+
+double a[4096];
+double b[4096];
+
+int main() {
+    int n = 4096;
+    for (int i = 0; i < n; i++) {
+        a[i] = i - i / 7 * 7;
+        b[i] = 0.5 * (i - i / 5 * 5);
+    }
+    double total = 0.0;
+    for (int rep = 0; rep < 50000; rep++) {
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) {
+            sum = sum + a[i] * b[i];
+        }
+        total = total + sum;
+    }
+    print_double(total);
+    return 0;
+}
@@ -0,0 +1,43 @@
+void print_int(int x);
+
+typedef int (*Op)(int a, int b);
+
+int op_add(int a, int b) {
+    return a + b;
+}
+
+int op_sub(int a, int b) {
+    return a - b;
+}
+
+int op_mul(int a, int b) {
+    return a * b + 1;
+}
+
+int op_div(int a, int b) {
+    return a / 2 + b;
+}
+
+int apply(Op f, int a, int b) {
+    return f(a, b);
+}
+
+int main() {
+    int acc = 1;
+    for (int i = 1; i < 50000000; i++) {
+        Op f = op_add;
+        int k = i - i / 4 * 4;
+        if (k == 1) {
+            f = op_sub;
+        }
+        if (k == 2) {
+            f = op_mul;
+        }
+        if (k == 3) {
+            f = op_div;
+        }
+        acc = apply(f, acc, i);
+    }
+    print_int(acc);
+    return 0;
+}
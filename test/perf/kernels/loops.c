@@ -0,0 +1,24 @@
+void print_int(int x);
+
+int data[100000];
+
+int main() {
+    int n = 100000;
+    for (int i = 0; i < n; i++) {
+        data[i] = i * 7 + 3 - i / 3;
+    }
+    int checksum = 0;
+    for (int rep = 0; rep < 1000; rep++) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum = sum + data[i] * 3 - data[i] / 5;
+        }
+        for (int i = 1; i < n; i++) {
+            data[i] = data[i] + data[i - 1] / 7 - rep;
+        }
+        checksum = checksum * 31 + sum;
+    }
+    print_int(checksum);
+    print_int(data[n - 1]);
+    return 0;
+}
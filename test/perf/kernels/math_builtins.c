@@ -0,0 +1,22 @@
+void print_double(double x);
+
+double squares[4096];
+
+int main() {
+    int n = 4096;
+    for (int i = 0; i < n; i++) {
+        squares[i] = (i - i / 64 * 64) * (i - i / 64 * 64);
+    }
+    double total = 0.0;
+    for (int rep = 0; rep < 20000; rep++) {
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) {
+            double root = __builtin_sqrt(squares[i]);
+            sum = sum + __builtin_floor(root * 0.25 + 0.5);
+            sum = sum + __builtin_fmax(__builtin_fabs(root - 31.5), __builtin_fmin(root, 8.0));
+        }
+        total = total + sum;
+    }
+    print_double(total);
+    return 0;
+}
@@ -0,0 +1,26 @@
+void print_int(int x);
+
+int order[2097168];
+int values[2097152];
+
+int main() {
+    int n = 2097152;
+    for (int i = 0; i < n; i++) {
+        order[i] = i * 40503 & n - 1;
+        values[i] = i - i / 10 * 10;
+    }
+    int checksum = 0;
+    for (int rep = 0; rep < 20; rep++) {
+        for (int k = 0; k < n; k++) {
+            __builtin_prefetch(&values[order[k + 16]]);
+            int v = values[order[k]];
+            if (__builtin_expect(v == 7, 0)) {
+                checksum = checksum * 3 + k;
+            } else {
+                checksum = checksum + v;
+            }
+        }
+    }
+    print_int(checksum);
+    return 0;
+}
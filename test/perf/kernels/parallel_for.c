@@ -0,0 +1,23 @@
+void print_int(int x);
+
+int values[65536];
+
+int main() {
+    int n = 65536;
+    for (int rep = 0; rep < 10; rep++) {
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < n; i++) {
+            int x = i + rep;
+            for (int r = 0; r < i % 512 + 256; r++) {
+                x = x * 1103515245 + 12345;
+            }
+            values[i] = x;
+        }
+    }
+    int checksum = 0;
+    for (int i = 0; i < n; i++) {
+        checksum = checksum * 31 + values[i];
+    }
+    print_int(checksum);
+    return 0;
+}
@@ -0,0 +1,46 @@
+void print_int(int x);
+void* pool_alloc(int size);
+void pool_free(void* p, int size);
+
+struct Tree {
+    struct Tree* left;
+    struct Tree* right;
+    int value;
+};
+
+struct Tree* build(int depth, int value) {
+    struct Tree* t = pool_alloc(24);
+    t->value = value;
+    if (depth > 0) {
+        t->left = build(depth - 1, value * 2);
+        t->right = build(depth - 1, value * 2 + 1);
+    }
+    return t;
+}
+
+int check(struct Tree* t, int depth) {
+    int sum = t->value;
+    if (depth > 0) {
+        sum = sum + check(t->left, depth - 1) - check(t->right, depth - 1);
+    }
+    return sum;
+}
+
+void release(struct Tree* t, int depth) {
+    if (depth > 0) {
+        release(t->left, depth - 1);
+        release(t->right, depth - 1);
+    }
+    pool_free(t, 24);
+}
+
+int main() {
+    int checksum = 0;
+    for (int rep = 0; rep < 100; rep++) {
+        struct Tree* t = build(16, rep);
+        checksum = checksum * 31 + check(t, 16);
+        release(t, 16);
+    }
+    print_int(checksum);
+    return 0;
+}
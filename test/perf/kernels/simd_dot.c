@@ -0,0 +1,25 @@
+void print_double(double x);
+
+double a[4096];
+double b[4096];
+
+int main() {
+    int n = 4096;
+    for (int i = 0; i < n; i++) {
+        a[i] = i - i / 7 * 7;
+        b[i] = 0.5 * (i - i / 5 * 5);
+    }
+    double total = 0.0;
+    for (int rep = 0; rep < 50000; rep++) {
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        for (int i = 0; i < n; i = i + 4) {
+            s0 = s0 + a[i] * b[i];
+            s1 = s1 + a[i + 1] * b[i + 1];
+            s2 = s2 + a[i + 2] * b[i + 2];
+            s3 = s3 + a[i + 3] * b[i + 3];
+        }
+        total = total + (s0 + s1 + s2 + s3);
+    }
+    print_double(total);
+    return 0;
+}
@@ -0,0 +1,85 @@
+void print_int(int x);
+
+char text[4096];
+char buffer[4096];
+
+int length(char* s) {
+    int n = 0;
+    while (s[n] != '\0') {
+        n++;
+    }
+    return n;
+}
+
+int hash(char* s) {
+    int h = 0;
+    int i = 0;
+    while (s[i] != '\0') {
+        int c = s[i];
+        h = h * 31 + c;
+        i++;
+    }
+    return h;
+}
+
+int words(char* s) {
+    int count = 0;
+    int inWord = 0;
+    int i = 0;
+    while (s[i] != '\0') {
+        if (s[i] == ' ') {
+            inWord = 0;
+        } else {
+            if (inWord == 0) {
+                count++;
+                inWord = 1;
+            }
+        }
+        i++;
+    }
+    return count;
+}
+
+void copy(char* dst, char* src) {
+    int i = 0;
+    while (src[i] != '\0') {
+        dst[i] = src[i];
+        i++;
+    }
+    dst[i] = '\0';
+}
+
+int compare(char* a, char* b) {
+    int i = 0;
+    while (a[i] != '\0' && a[i] == b[i]) {
+        i++;
+    }
+    int x = a[i];
+    int y = b[i];
+    return x - y;
+}
+
+int main() {
+    int n = 4095;
+    for (int i = 0; i < n; i++) {
+        int k = i * 7 - i * 7 / 26 * 26;
+        if (k < 5) {
+            text[i] = ' ';
+        } else {
+            text[i] = 97 + k;
+        }
+    }
+    text[n] = '\0';
+    int checksum = 0;
+    for (int rep = 0; rep < 20000; rep++) {
+        copy(&buffer[0], &text[0]);
+        buffer[rep * 13 - rep * 13 / n * n] = 'z';
+        int total = length(&buffer[0]);
+        total = total + hash(&buffer[0]);
+        total = total + words(&buffer[0]);
+        total = total + compare(&text[0], &buffer[0]);
+        checksum = checksum * 17 + total;
+    }
+    print_int(checksum);
+    return 0;
+}
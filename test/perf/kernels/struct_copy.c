@@ -0,0 +1,40 @@
+void print_int(int x);
+
+struct Particle {
+    double x;
+    double y;
+    double z;
+    double vx;
+    double vy;
+    double vz;
+    int id;
+    int flags;
+};
+
+struct Particle particles[256];
+
+int main() {
+    int n = 256;
+    for (int i = 0; i < n; i++) {
+        particles[i].x = i;
+        particles[i].vz = i * 0.5;
+        particles[i].id = i;
+        particles[i].flags = i - i / 3 * 3;
+    }
+    for (int rep = 0; rep < 200000; rep++) {
+        for (int i = 0; i < n - 1; i++) {
+            struct Particle tmp = particles[i];
+            particles[i] = particles[i + 1];
+            particles[i + 1] = tmp;
+        }
+    }
+    int checksum = 0;
+    for (int i = 0; i < n; i++) {
+        struct Particle p = particles[i];
+        int x = p.x;
+        int twice_vz = p.vz * 2;
+        checksum = checksum * 31 + p.id * (p.flags + 1) + (x + twice_vz);
+    }
+    print_int(checksum);
+    return 0;
+}
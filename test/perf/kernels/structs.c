@@ -0,0 +1,33 @@
+void print_int(int x);
+
+struct Node {
+    int value;
+    int weight;
+    struct Node* next;
+};
+
+struct Node nodes[50000];
+
+int score(struct Node* node) {
+    return node->value * 3 - node->weight;
+}
+
+int main() {
+    int n = 50000;
+    for (int i = 0; i < n; i++) {
+        nodes[i].value = i;
+        nodes[i].weight = i / 3 + 1;
+        nodes[i].next = &nodes[i + 1];
+    }
+    nodes[n - 1].next = &nodes[0];
+    int checksum = 0;
+    struct Node* p = &nodes[0];
+    for (int step = 0; step < 50000000; step++) {
+        checksum = checksum + p->value * p->weight;
+        checksum = checksum - score(p);
+        p->weight = p->weight + 1;
+        p = p->next;
+    }
+    print_int(checksum);
+    return 0;
+}
@@ -0,0 +1,38 @@
+void print_int(int x);
+
+int code[64];
+
+int main() {
+    for (int i = 0; i < 64; i++) {
+        code[i] = (i * 5 + 3) - (i * 5 + 3) / 6 * 6;
+    }
+    int acc = 0;
+    int x = 1;
+    for (int rep = 0; rep < 2000000; rep++) {
+        for (int pc = 0; pc < 64; pc++) {
+            switch (code[pc]) {
+                case 0:
+                    acc = acc + x;
+                    break;
+                case 1:
+                    acc = acc - 3;
+                    break;
+                case 2:
+                    x = x + 1;
+                    break;
+                case 3:
+                    acc = acc * 3;
+                    break;
+                case 4:
+                    acc = acc / 2;
+                    break;
+                default:
+                    x = x - acc / 1000;
+                    break;
+            }
+        }
+    }
+    print_int(acc);
+    print_int(x);
+    return 0;
+}
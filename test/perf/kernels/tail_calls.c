@@ -0,0 +1,38 @@
+void print_int(int x);
+
+// The loops the tail calls in tail_calls.json should become. gcc keeps the recursive calls at
+// -O0 and would overflow the stack at this depth, so the C version is written iteratively
+
+int sum_to(int n, int acc) {
+    while (n != 0) {
+        acc = acc + n * 3;
+        n = n - 1;
+    }
+    return acc;
+}
+
+// is_even and is_odd calling each other
+int is_even(int n, int acc) {
+    while (1) {
+        if (n == 0) {
+            return acc;
+        }
+        n = n - 1;
+        acc = acc + 1;
+        if (n == 0) {
+            return acc - 1;
+        }
+        n = n - 1;
+        acc = acc * 3 + 2;
+    }
+}
+
+int main() {
+    int checksum = 0;
+    for (int rep = 0; rep < 10; rep++) {
+        checksum = checksum + sum_to(10000000 + rep, rep);
+        checksum = checksum * 7 + is_even(10000000 + rep, checksum);
+    }
+    print_int(checksum);
+    return 0;
+}
@@ -0,0 +1,1190 @@
+# Writes the AST json of every benchmark kernel into kernels/, next to the C version each one
+# is compared against. The json is what the frontend would produce for the C file, keep the
+# two in sync when changing a kernel.
+# usage: python make_kernels.py
+
+import json
+import os
+
+# ==== AST builders ====
+# Python ints and floats are literals and strings are identifiers wherever an expression is expected
+
+
+def expr(value):
+    if isinstance(value, int):
+        return {"nodeType": "Literal", "kind": "integer", "value": value}
+    if isinstance(value, float):
+        return {"nodeType": "Literal", "kind": "double", "value": value}
+    if isinstance(value, str):
+        return {"nodeType": "Identifier", "identifier": value}
+    return value
+
+
+def prim(kind):
+    return {"nodeType": "PrimitiveType", "kind": kind}
+
+
+def named(name):
+    return {"nodeType": "NamedType", "identifier": name}
+
+
+def ptr(base):
+    return {"nodeType": "PointerType", "baseType": base}
+
+
+INT = prim("int")
+CHAR = prim("char")
+DOUBLE = prim("double")
+DOUBLE4 = prim("double4")
+VOID = prim("void")
+
+
+def char(c):
+    return {"nodeType": "Literal", "kind": "char", "value": c}
+
+
+def binary(op, left, right):
+    return {
+        "nodeType": "BinaryExpression",
+        "operator": op,
+        "left": expr(left),
+        "right": expr(right),
+    }
+
+
+def add(a, b):
+    return binary("+", a, b)
+
+
+def sub(a, b):
+    return binary("-", a, b)
+
+
+def mul(a, b):
+    return binary("*", a, b)
+
+
+def div(a, b):
+    return binary("/", a, b)
+
+
+def mod(a, b):
+    # There is no % operator, a - a / b * b is folded back into srem at -O1 and above
+    return sub(a, mul(div(a, b), b))
+
+
+def lt(a, b):
+    return binary("<", a, b)
+
+
+def eq(a, b):
+    return binary("==", a, b)
+
+
+def ne(a, b):
+    return binary("!=", a, b)
+
+
+def and_(a, b):
+    return binary("&&", a, b)
+
+
+def bit_and(a, b):
+    return binary("&", a, b)
+
+
+def assign(left, right):
+    return binary("=", left, right)
+
+
+def unary(op, operand, prefix=True):
+    return {
+        "nodeType": "UnaryExpression",
+        "operator": op,
+        "operand": expr(operand),
+        "prefix": prefix,
+    }
+
+
+def inc(name):
+    return unary("++", name, prefix=False)
+
+
+def addr(operand):
+    return unary("&", operand)
+
+
+def call(name, *args):
+    return {
+        "nodeType": "CallExpression",
+        "callee": expr(name),
+        "arguments": [expr(a) for a in args],
+    }
+
+
+def index(array, i):
+    return {"nodeType": "IndexExpression", "array": expr(array), "index": expr(i)}
+
+
+def dot(obj, member):
+    return {"nodeType": "MemberExpression", "kind": "dot", "object": expr(obj), "member": member}
+
+
+def arrow(obj, member):
+    return {"nodeType": "MemberExpression", "kind": "arrow", "object": expr(obj), "member": member}
+
+
+def var(name, type, init=None, size=None):
+    node = {"nodeType": "VariableDeclaration", "identifier": name, "type": type}
+    if init is not None:
+        node["initializer"] = expr(init)
+    if size is not None:
+        node["arraySize"] = expr(size)
+    return node
+
+
+def init_list(*elements):
+    # Tuples are nested lists
+    return {"nodeType": "InitializerList", "elements": [init(e) for e in elements]}
+
+
+def init(value):
+    return init_list(*value) if isinstance(value, tuple) else expr(value)
+
+
+def stmt(expression):
+    return {"nodeType": "ExpressionStatement", "expression": expression}
+
+
+def decl(name, type, init=None, size=None):
+    return stmt(var(name, type, init, size))
+
+
+def block(*statements):
+    return {"nodeType": "BlockStatement", "statements": list(statements)}
+
+
+def if_(condition, then, otherwise=None):
+    node = {"nodeType": "IfStatement", "condition": expr(condition), "thenBranch": then}
+    if otherwise is not None:
+        node["elseBranch"] = otherwise
+    return node
+
+
+def while_(condition, *body):
+    return {"nodeType": "WhileStatement", "condition": expr(condition), "loopBody": block(*body)}
+
+
+def for_(init, condition, update, *body):
+    return {
+        "nodeType": "ForStatement",
+        "initialization": init,
+        "condition": expr(condition),
+        "update": update,
+        "body": block(*body),
+    }
+
+
+def parallel(loop, schedule="static", chunk=0):
+    # #pragma omp parallel for schedule(schedule, chunk) on a for loop
+    loop.update({"parallel": True, "schedule": schedule, "chunk": chunk})
+    return loop
+
+
+def count(name, start, end, *body):
+    # for (int name = start; name < end; name++)
+    return for_(var(name, INT, start), lt(name, end), inc(name), *body)
+
+
+def switch(condition, cases, default=None):
+    # cases are (value, statements), a value of None is the default case in that position
+    node_cases = []
+    for v, body in cases:
+        if v is None:
+            node_cases.append({"isDefault": True, "body": body})
+        else:
+            node_cases.append({"isDefault": False, "value": v, "body": body})
+    if default is not None:
+        node_cases.append({"isDefault": True, "body": default})
+    return {"nodeType": "SwitchStatement", "expression": expr(condition), "cases": node_cases}
+
+
+def brk():
+    return {"nodeType": "BreakStatement"}
+
+
+def cont():
+    return {"nodeType": "ContinueStatement"}
+
+
+def ret(value=None):
+    node = {"nodeType": "ReturnStatement"}
+    if value is not None:
+        node["expression"] = expr(value)
+    return node
+
+
+def params(*pairs):
+    return [{"nodeType": "Parameter", "identifier": n, "type": t} for n, t in pairs]
+
+
+def function(name, return_type, parameters, *body):
+    return {
+        "nodeType": "FunctionDefinition",
+        "identifier": name,
+        "returnType": return_type,
+        "parameters": params(*parameters),
+        "body": block(*body),
+    }
+
+
+def extern(name, return_type, *parameters):
+    return {
+        "nodeType": "FunctionDeclaration",
+        "identifier": name,
+        "returnType": return_type,
+        "parameters": params(*parameters),
+    }
+
+
+def struct(name, *fields):
+    return {
+        "nodeType": "StructDefinition",
+        "identifier": name,
+        "fields": [var(n, t) for n, t in fields],
+    }
+
+
+def function_ptr(name, return_type, *parameter_types):
+    # The frontend only keeps the parameter types of a function pointer typedef
+    return {
+        "nodeType": "FunctionPointerDeclaration",
+        "identifier": name,
+        "returnType": return_type,
+        "parameterTypes": list(parameter_types),
+    }
+
+
+PRINT_INT = extern("print_int", VOID, ("x", INT))
+PRINT_DOUBLE = extern("print_double", VOID, ("x", DOUBLE))
+
+
+# ==== Kernels ====
+
+
+def loops():
+    n = 100000
+    return [
+        PRINT_INT,
+        var("data", INT, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i", 0, "n", stmt(assign(index("data", "i"), sub(add(mul("i", 7), 3), div("i", 3))))
+            ),
+            decl("checksum", INT, 0),
+            count(
+                "rep",
+                0,
+                1000,
+                decl("sum", INT, 0),
+                count(
+                    "i",
+                    0,
+                    "n",
+                    stmt(
+                        assign(
+                            "sum",
+                            sub(add("sum", mul(index("data", "i"), 3)), div(index("data", "i"), 5)),
+                        )
+                    ),
+                ),
+                count(
+                    "i",
+                    1,
+                    "n",
+                    stmt(
+                        assign(
+                            index("data", "i"),
+                            sub(add(index("data", "i"), div(index("data", sub("i", 1)), 7)), "rep"),
+                        )
+                    ),
+                ),
+                stmt(assign("checksum", add(mul("checksum", 31), "sum"))),
+            ),
+            stmt(call("print_int", "checksum")),
+            stmt(call("print_int", index("data", sub("n", 1)))),
+            ret(0),
+        ),
+    ]
+
+
+def structs():
+    n = 50000
+    node_ptr = ptr(named("Node"))
+    return [
+        PRINT_INT,
+        struct("Node", ("value", INT), ("weight", INT), ("next", node_ptr)),
+        var("nodes", named("Node"), size=n),
+        function(
+            "score",
+            INT,
+            [("node", node_ptr)],
+            ret(sub(mul(arrow("node", "value"), 3), arrow("node", "weight"))),
+        ),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i",
+                0,
+                "n",
+                stmt(assign(dot(index("nodes", "i"), "value"), "i")),
+                stmt(assign(dot(index("nodes", "i"), "weight"), add(div("i", 3), 1))),
+                stmt(assign(dot(index("nodes", "i"), "next"), addr(index("nodes", add("i", 1))))),
+            ),
+            stmt(assign(dot(index("nodes", sub("n", 1)), "next"), addr(index("nodes", 0)))),
+            decl("checksum", INT, 0),
+            decl("p", node_ptr, addr(index("nodes", 0))),
+            count(
+                "step",
+                0,
+                50000000,
+                stmt(
+                    assign(
+                        "checksum", add("checksum", mul(arrow("p", "value"), arrow("p", "weight")))
+                    )
+                ),
+                stmt(assign("checksum", sub("checksum", call("score", "p")))),
+                stmt(assign(arrow("p", "weight"), add(arrow("p", "weight"), 1))),
+                stmt(assign("p", arrow("p", "next"))),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def fnptr_dispatch():
+    a_b = [("a", INT), ("b", INT)]
+    return [
+        PRINT_INT,
+        function_ptr("Op", INT, INT, INT),
+        function("op_add", INT, a_b, ret(add("a", "b"))),
+        function("op_sub", INT, a_b, ret(sub("a", "b"))),
+        function("op_mul", INT, a_b, ret(add(mul("a", "b"), 1))),
+        function("op_div", INT, a_b, ret(add(div("a", 2), "b"))),
+        function(
+            "apply", INT, [("f", named("Op")), ("a", INT), ("b", INT)], ret(call("f", "a", "b"))
+        ),
+        function(
+            "main",
+            INT,
+            [],
+            decl("acc", INT, 1),
+            count(
+                "i",
+                1,
+                50000000,
+                decl("f", named("Op"), "op_add"),
+                decl("k", INT, mod("i", 4)),
+                if_(eq("k", 1), block(stmt(assign("f", "op_sub")))),
+                if_(eq("k", 2), block(stmt(assign("f", "op_mul")))),
+                if_(eq("k", 3), block(stmt(assign("f", "op_div")))),
+                stmt(assign("acc", call("apply", "f", "acc", "i"))),
+            ),
+            stmt(call("print_int", "acc")),
+            ret(0),
+        ),
+    ]
+
+
+def switch_dispatch():
+    return [
+        PRINT_INT,
+        var("code", INT, size=64),
+        function(
+            "main",
+            INT,
+            [],
+            count("i", 0, 64, stmt(assign(index("code", "i"), mod(add(mul("i", 5), 3), 6)))),
+            decl("acc", INT, 0),
+            decl("x", INT, 1),
+            count(
+                "rep",
+                0,
+                2000000,
+                count(
+                    "pc",
+                    0,
+                    64,
+                    switch(
+                        index("code", "pc"),
+                        [
+                            (0, [stmt(assign("acc", add("acc", "x"))), brk()]),
+                            (1, [stmt(assign("acc", sub("acc", 3))), brk()]),
+                            (2, [stmt(assign("x", add("x", 1))), brk()]),
+                            (3, [stmt(assign("acc", mul("acc", 3))), brk()]),
+                            (4, [stmt(assign("acc", div("acc", 2))), brk()]),
+                        ],
+                        [stmt(assign("x", sub("x", div("acc", 1000)))), brk()],
+                    ),
+                ),
+            ),
+            stmt(call("print_int", "acc")),
+            stmt(call("print_int", "x")),
+            ret(0),
+        ),
+    ]
+
+
+def strings():
+    size = 4096
+    s = ("s", ptr(CHAR))
+    return [
+        PRINT_INT,
+        var("text", CHAR, size=size),
+        var("buffer", CHAR, size=size),
+        function(
+            "length",
+            INT,
+            [s],
+            decl("n", INT, 0),
+            while_(ne(index("s", "n"), char("")), stmt(inc("n"))),
+            ret("n"),
+        ),
+        function(
+            "hash",
+            INT,
+            [s],
+            decl("h", INT, 0),
+            decl("i", INT, 0),
+            while_(
+                ne(index("s", "i"), char("")),
+                decl("c", INT, index("s", "i")),
+                stmt(assign("h", add(mul("h", 31), "c"))),
+                stmt(inc("i")),
+            ),
+            ret("h"),
+        ),
+        function(
+            "words",
+            INT,
+            [s],
+            decl("count", INT, 0),
+            decl("inWord", INT, 0),
+            decl("i", INT, 0),
+            while_(
+                ne(index("s", "i"), char("")),
+                if_(
+                    eq(index("s", "i"), char(" ")),
+                    block(stmt(assign("inWord", 0))),
+                    block(
+                        if_(eq("inWord", 0), block(stmt(inc("count")), stmt(assign("inWord", 1))))
+                    ),
+                ),
+                stmt(inc("i")),
+            ),
+            ret("count"),
+        ),
+        function(
+            "copy",
+            VOID,
+            [("dst", ptr(CHAR)), ("src", ptr(CHAR))],
+            decl("i", INT, 0),
+            while_(
+                ne(index("src", "i"), char("")),
+                stmt(assign(index("dst", "i"), index("src", "i"))),
+                stmt(inc("i")),
+            ),
+            stmt(assign(index("dst", "i"), char(""))),
+        ),
+        function(
+            "compare",
+            INT,
+            [("a", ptr(CHAR)), ("b", ptr(CHAR))],
+            decl("i", INT, 0),
+            while_(
+                and_(ne(index("a", "i"), char("")), eq(index("a", "i"), index("b", "i"))),
+                stmt(inc("i")),
+            ),
+            decl("x", INT, index("a", "i")),
+            decl("y", INT, index("b", "i")),
+            ret(sub("x", "y")),
+        ),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, size - 1),
+            count(
+                "i",
+                0,
+                "n",
+                decl("k", INT, mod(mul("i", 7), 26)),
+                if_(
+                    lt("k", 5),
+                    block(stmt(assign(index("text", "i"), char(" ")))),
+                    block(stmt(assign(index("text", "i"), add(97, "k")))),
+                ),
+            ),
+            stmt(assign(index("text", "n"), char(""))),
+            decl("checksum", INT, 0),
+            count(
+                "rep",
+                0,
+                20000,
+                stmt(call("copy", addr(index("buffer", 0)), addr(index("text", 0)))),
+                stmt(assign(index("buffer", mod(mul("rep", 13), "n")), char("z"))),
+                decl("total", INT, call("length", addr(index("buffer", 0)))),
+                stmt(assign("total", add("total", call("hash", addr(index("buffer", 0)))))),
+                stmt(assign("total", add("total", call("words", addr(index("buffer", 0)))))),
+                stmt(
+                    assign(
+                        "total",
+                        add(
+                            "total",
+                            call("compare", addr(index("text", 0)), addr(index("buffer", 0))),
+                        ),
+                    )
+                ),
+                stmt(assign("checksum", add(mul("checksum", 17), "total"))),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def dot_product():
+    # Built with -ffast-math, see run_perf.py. Products are multiples of 0.5 and every partial sum
+    # is exact, so a reassociated or vectorized sum prints the same as the C version
+    n = 4096
+    return [
+        PRINT_DOUBLE,
+        var("a", DOUBLE, size=n),
+        var("b", DOUBLE, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i",
+                0,
+                "n",
+                stmt(assign(index("a", "i"), mod("i", 7))),
+                stmt(assign(index("b", "i"), mul(0.5, mod("i", 5)))),
+            ),
+            decl("total", DOUBLE, 0.0),
+            count(
+                "rep",
+                0,
+                50000,
+                decl("sum", DOUBLE, 0.0),
+                count(
+                    "i",
+                    0,
+                    "n",
+                    stmt(assign("sum", add("sum", mul(index("a", "i"), index("b", "i"))))),
+                ),
+                stmt(assign("total", add("total", "sum"))),
+            ),
+            stmt(call("print_double", "total")),
+            ret(0),
+        ),
+    ]
+
+
+def simd_dot():
+    # dot_product with explicit double4 lanes and no fast-math, the C version keeps one
+    # accumulator per lane
+    n = 4096
+    return [
+        PRINT_DOUBLE,
+        var("a", DOUBLE, size=n),
+        var("b", DOUBLE, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i",
+                0,
+                "n",
+                stmt(assign(index("a", "i"), mod("i", 7))),
+                stmt(assign(index("b", "i"), mul(0.5, mod("i", 5)))),
+            ),
+            decl("total", DOUBLE, 0.0),
+            count(
+                "rep",
+                0,
+                50000,
+                decl("sum", DOUBLE4, 0.0),
+                for_(
+                    var("i", INT, 0),
+                    lt("i", "n"),
+                    assign("i", add("i", 4)),
+                    stmt(
+                        assign(
+                            "sum",
+                            add(
+                                "sum",
+                                mul(
+                                    call("double4_load", addr(index("a", "i"))),
+                                    call("double4_load", addr(index("b", "i"))),
+                                ),
+                            ),
+                        )
+                    ),
+                ),
+                stmt(assign("total", add("total", call("__builtin_reduce_add", "sum")))),
+            ),
+            stmt(call("print_double", "total")),
+            ret(0),
+        ),
+    ]
+
+
+def math_builtins():
+    # Roots of perfect squares and halves, every value and partial sum is exact
+    n = 4096
+    return [
+        PRINT_DOUBLE,
+        var("squares", DOUBLE, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i", 0, "n", stmt(assign(index("squares", "i"), mul(mod("i", 64), mod("i", 64))))
+            ),
+            decl("total", DOUBLE, 0.0),
+            count(
+                "rep",
+                0,
+                20000,
+                decl("sum", DOUBLE, 0.0),
+                count(
+                    "i",
+                    0,
+                    "n",
+                    decl("root", DOUBLE, call("__builtin_sqrt", index("squares", "i"))),
+                    stmt(
+                        assign(
+                            "sum",
+                            add("sum", call("__builtin_floor", add(mul("root", 0.25), 0.5))),
+                        )
+                    ),
+                    stmt(
+                        assign(
+                            "sum",
+                            add(
+                                "sum",
+                                call(
+                                    "__builtin_fmax",
+                                    call("__builtin_fabs", sub("root", 31.5)),
+                                    call("__builtin_fmin", "root", 8.0),
+                                ),
+                            ),
+                        )
+                    ),
+                ),
+                stmt(assign("total", add("total", "sum"))),
+            ),
+            stmt(call("print_double", "total")),
+            ret(0),
+        ),
+    ]
+
+
+def bit_builtins():
+    # Starts at 1, the leading and trailing zero count of 0 is undefined
+    return [
+        PRINT_INT,
+        function(
+            "main",
+            INT,
+            [],
+            decl("checksum", INT, 0),
+            count(
+                "i",
+                1,
+                100000000,
+                stmt(
+                    assign(
+                        "checksum",
+                        add(
+                            "checksum",
+                            sub(
+                                add(
+                                    mul(call("__builtin_popcount", "i"), 3),
+                                    call("__builtin_clz", "i"),
+                                ),
+                                call("__builtin_ctz", "i"),
+                            ),
+                        ),
+                    )
+                ),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def memory_hints():
+    # Gathers through a scrambled index array larger than the caches, prefetching the element
+    # needed 16 iterations later. order has 16 zeros at the end for the last prefetches
+    n = 1 << 21
+    lookahead = 16
+    return [
+        PRINT_INT,
+        var("order", INT, size=n + lookahead),
+        var("values", INT, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i",
+                0,
+                "n",
+                stmt(assign(index("order", "i"), bit_and(mul("i", 40503), sub("n", 1)))),
+                stmt(assign(index("values", "i"), mod("i", 10))),
+            ),
+            decl("checksum", INT, 0),
+            count(
+                "rep",
+                0,
+                20,
+                count(
+                    "k",
+                    0,
+                    "n",
+                    stmt(
+                        call(
+                            "__builtin_prefetch",
+                            addr(index("values", index("order", add("k", lookahead)))),
+                        )
+                    ),
+                    decl("v", INT, index("values", index("order", "k"))),
+                    if_(
+                        call("__builtin_expect", eq("v", 7), 0),
+                        block(stmt(assign("checksum", add(mul("checksum", 3), "k")))),
+                        block(stmt(assign("checksum", add("checksum", "v")))),
+                    ),
+                ),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def struct_copy():
+    # Rotates an array of structs by one element per rep with whole-struct copies, which are
+    # llvm.memcpy calls
+    n = 256
+    particle = named("Particle")
+    return [
+        PRINT_INT,
+        struct(
+            "Particle",
+            ("x", DOUBLE),
+            ("y", DOUBLE),
+            ("z", DOUBLE),
+            ("vx", DOUBLE),
+            ("vy", DOUBLE),
+            ("vz", DOUBLE),
+            ("id", INT),
+            ("flags", INT),
+        ),
+        var("particles", particle, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "i",
+                0,
+                "n",
+                stmt(assign(dot(index("particles", "i"), "x"), "i")),
+                stmt(assign(dot(index("particles", "i"), "vz"), mul("i", 0.5))),
+                stmt(assign(dot(index("particles", "i"), "id"), "i")),
+                stmt(assign(dot(index("particles", "i"), "flags"), mod("i", 3))),
+            ),
+            count(
+                "rep",
+                0,
+                200000,
+                count(
+                    "i",
+                    0,
+                    sub("n", 1),
+                    decl("tmp", particle, index("particles", "i")),
+                    stmt(assign(index("particles", "i"), index("particles", add("i", 1)))),
+                    stmt(assign(index("particles", add("i", 1)), "tmp")),
+                ),
+            ),
+            decl("checksum", INT, 0),
+            count(
+                "i",
+                0,
+                "n",
+                decl("p", particle, index("particles", "i")),
+                decl("x", INT, dot("p", "x")),
+                decl("twice_vz", INT, mul(dot("p", "vz"), 2)),
+                stmt(
+                    assign(
+                        "checksum",
+                        add(
+                            add(
+                                mul("checksum", 31), mul(dot("p", "id"), add(dot("p", "flags"), 1))
+                            ),
+                            add("x", "twice_vz"),
+                        ),
+                    )
+                ),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def parallel_for():
+    # Iterations of very different cost, balanced by the dynamic schedule. The C version
+    # ignores the pragma and runs serially, so the ratio is the speedup of the thread pool
+    n = 1 << 16
+    return [
+        PRINT_INT,
+        var("values", INT, size=n),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            count(
+                "rep",
+                0,
+                10,
+                parallel(
+                    count(
+                        "i",
+                        0,
+                        "n",
+                        decl("x", INT, add("i", "rep")),
+                        count(
+                            "r",
+                            0,
+                            add(mod("i", 512), 256),
+                            stmt(assign("x", add(mul("x", 1103515245), 12345))),
+                        ),
+                        stmt(assign(index("values", "i"), "x")),
+                    ),
+                    "dynamic",
+                ),
+            ),
+            decl("checksum", INT, 0),
+            count(
+                "i",
+                0,
+                "n",
+                stmt(assign("checksum", add(mul("checksum", 31), index("values", "i")))),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+ARENA_CREATE = extern("arena_create", VOID, ("capacity", INT))
+ARENA_ALLOC = extern("arena_alloc", ptr(VOID), ("size", INT))
+ARENA_RESET = extern("arena_reset", VOID)
+POOL_ALLOC = extern("pool_alloc", ptr(VOID), ("size", INT))
+POOL_FREE = extern("pool_free", VOID, ("p", ptr(VOID)), ("size", INT))
+
+
+def arena_list():
+    # Builds a circular list from the arena and walks it once per rep, then frees it all at
+    # once. 16 is the size of Node, the language has no sizeof
+    n = 100000
+    node_ptr = ptr(named("Node"))
+    return [
+        PRINT_INT,
+        ARENA_CREATE,
+        ARENA_ALLOC,
+        ARENA_RESET,
+        struct("Node", ("value", INT), ("next", node_ptr)),
+        function(
+            "main",
+            INT,
+            [],
+            decl("n", INT, n),
+            decl("checksum", INT, 0),
+            stmt(call("arena_create", 1 << 20)),
+            count(
+                "rep",
+                0,
+                1000,
+                decl("head", node_ptr, call("arena_alloc", 16)),
+                stmt(assign(arrow("head", "value"), "rep")),
+                stmt(assign(arrow("head", "next"), "head")),
+                decl("tail", node_ptr, "head"),
+                count(
+                    "i",
+                    1,
+                    "n",
+                    decl("node", node_ptr, call("arena_alloc", 16)),
+                    stmt(assign(arrow("node", "value"), add(mul("i", 7), "rep"))),
+                    stmt(assign(arrow("node", "next"), "head")),
+                    stmt(assign(arrow("tail", "next"), "node")),
+                    stmt(assign("tail", "node")),
+                ),
+                decl("p", node_ptr, "head"),
+                count(
+                    "i",
+                    0,
+                    "n",
+                    stmt(assign("checksum", add(mul("checksum", 31), arrow("p", "value")))),
+                    stmt(assign("p", arrow("p", "next"))),
+                ),
+                stmt(call("arena_reset")),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def pool_trees():
+    # Complete binary trees built from and returned to the pool, so after the first rep every
+    # node comes off a free list. 24 is the size of Tree
+    depth = 16
+    tree_ptr = ptr(named("Tree"))
+    has_children = binary(">", "depth", 0)
+    below = sub("depth", 1)
+    return [
+        PRINT_INT,
+        POOL_ALLOC,
+        POOL_FREE,
+        struct("Tree", ("left", tree_ptr), ("right", tree_ptr), ("value", INT)),
+        function(
+            "build",
+            tree_ptr,
+            [("depth", INT), ("value", INT)],
+            decl("t", tree_ptr, call("pool_alloc", 24)),
+            stmt(assign(arrow("t", "value"), "value")),
+            if_(
+                has_children,
+                block(
+                    stmt(assign(arrow("t", "left"), call("build", below, mul("value", 2)))),
+                    stmt(
+                        assign(arrow("t", "right"), call("build", below, add(mul("value", 2), 1)))
+                    ),
+                ),
+            ),
+            ret("t"),
+        ),
+        function(
+            "check",
+            INT,
+            [("t", tree_ptr), ("depth", INT)],
+            decl("sum", INT, arrow("t", "value")),
+            if_(
+                has_children,
+                block(
+                    stmt(
+                        assign(
+                            "sum",
+                            sub(
+                                add("sum", call("check", arrow("t", "left"), below)),
+                                call("check", arrow("t", "right"), below),
+                            ),
+                        )
+                    )
+                ),
+            ),
+            ret("sum"),
+        ),
+        function(
+            "release",
+            VOID,
+            [("t", tree_ptr), ("depth", INT)],
+            if_(
+                has_children,
+                block(
+                    stmt(call("release", arrow("t", "left"), below)),
+                    stmt(call("release", arrow("t", "right"), below)),
+                ),
+            ),
+            stmt(call("pool_free", "t", 24)),
+        ),
+        function(
+            "main",
+            INT,
+            [],
+            decl("checksum", INT, 0),
+            count(
+                "rep",
+                0,
+                100,
+                decl("t", tree_ptr, call("build", depth, "rep")),
+                stmt(assign("checksum", add(mul("checksum", 31), call("check", "t", depth)))),
+                stmt(call("release", "t", depth)),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def tail_calls():
+    # Ten million frames deep, only runs if every return f(x) is a real tail call
+    n_acc = [("n", INT), ("acc", INT)]
+    depth = 10000000
+    return [
+        PRINT_INT,
+        function(
+            "sum_to",
+            INT,
+            n_acc,
+            if_(eq("n", 0), block(ret("acc"))),
+            ret(call("sum_to", sub("n", 1), add("acc", mul("n", 3)))),
+        ),
+        extern("is_odd", INT, *n_acc),
+        function(
+            "is_even",
+            INT,
+            n_acc,
+            if_(eq("n", 0), block(ret("acc"))),
+            ret(call("is_odd", sub("n", 1), add("acc", 1))),
+        ),
+        function(
+            "is_odd",
+            INT,
+            n_acc,
+            if_(eq("n", 0), block(ret(sub("acc", 1)))),
+            ret(call("is_even", sub("n", 1), add(mul("acc", 3), 2))),
+        ),
+        function(
+            "main",
+            INT,
+            [],
+            decl("checksum", INT, 0),
+            count(
+                "rep",
+                0,
+                10,
+                stmt(assign("checksum", add("checksum", call("sum_to", add(depth, "rep"), "rep")))),
+                stmt(
+                    assign(
+                        "checksum",
+                        add(mul("checksum", 7), call("is_even", add(depth, "rep"), "checksum")),
+                    )
+                ),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+def lookup_table():
+    # A 1024 entry table initialized in the function that reads it, the case that used to be a
+    # store per element on every call. lookup never writes its table so it is read in place
+    # from rodata, mix writes one element of a partly initialized table, which is copied in
+    # with memcpy and the zero tail cleared with memset
+    table = [i * 7919 % 1000 + 1 for i in range(1024)]
+    mask = (1 << 20) - 1
+    return [
+        PRINT_INT,
+        function(
+            "lookup",
+            INT,
+            [("x", INT)],
+            decl("table", INT, init_list(*table), size=1024),
+            ret(index("table", bit_and("x", 1023))),
+        ),
+        function(
+            "mix",
+            INT,
+            [("seed", INT)],
+            decl("state", INT, init_list(*table[:16]), size=64),
+            stmt(assign(index("state", bit_and("seed", 63)), "seed")),
+            ret(
+                add(
+                    index("state", bit_and(mul("seed", 7), 63)),
+                    index("state", bit_and("seed", 15)),
+                )
+            ),
+        ),
+        function(
+            "main",
+            INT,
+            [],
+            decl("checksum", INT, 0),
+            count(
+                "i",
+                0,
+                10000000,
+                stmt(
+                    assign(
+                        "checksum",
+                        bit_and(add(mul("checksum", 3), call("lookup", mul("i", 37))), mask),
+                    )
+                ),
+            ),
+            count(
+                "i",
+                0,
+                5000000,
+                stmt(assign("checksum", bit_and(add("checksum", call("mix", "i")), mask))),
+            ),
+            stmt(call("print_int", "checksum")),
+            ret(0),
+        ),
+    ]
+
+
+KERNELS = {
+    "loops": loops,
+    "structs": structs,
+    "fnptr_dispatch": fnptr_dispatch,
+    "switch_dispatch": switch_dispatch,
+    "strings": strings,
+    "tail_calls": tail_calls,
+    "dot_product": dot_product,
+    "simd_dot": simd_dot,
+    "math_builtins": math_builtins,
+    "bit_builtins": bit_builtins,
+    "memory_hints": memory_hints,
+    "struct_copy": struct_copy,
+    "parallel_for": parallel_for,
+    "arena_list": arena_list,
+    "pool_trees": pool_trees,
+    "lookup_table": lookup_table,
+}
+
+
+def main():
+    out_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "kernels")
+    for name, build in KERNELS.items():
+        program = {"nodeType": "Program", "declarations": build()}
+        with open(os.path.join(out_dir, name + ".json"), "w") as out:
+            json.dump(program, out, indent=2)
+            out.write("\n")
+
+
+if __name__ == "__main__":
+    main()
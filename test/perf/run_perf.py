@@ -0,0 +1,231 @@
+# Runtime benchmark of the code my_compiler generates. Every kernel in kernels/ is compiled
+# to an object file at each optimization level and linked with the system C compiler, its C
+# version is built by that compiler at the same level. Both are run with warmup, must print
+# the same checksum, and the generated/C time ratio is checked against thresholds.json. The
+# compile time and object size of the generated code are recorded next to the run times.
+# Kernels with parallel loops are also run on one thread, their speedup over that is checked
+# when the machine has more than one processor.
+# usage: python run_perf.py <my_compiler> [--cc clang] [--levels 0,1,2,3] [--runs 5]
+#            [--warmup 1] [--kernels loops,strings] [--output perf_results.json]
+#            [--baseline previous_results.json]
+# Exits with 1 if a kernel fails to build, prints a different result or is over a threshold.
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+KERNEL_DIR = os.path.join(HERE, "kernels")
+RUNTIME_SOURCE = os.path.join(HERE, "..", "runtime.c")
+EXE_SUFFIX = ".exe" if os.name == "nt" else ""
+# Passed to my_compiler and to the C compiler, both must use the same FP semantics
+KERNEL_FLAGS = {"dot_product": ["-ffast-math"]}
+# Math builtins become libm calls where the target has no instruction for them, parallel for
+# loops run on the runtime's thread pool
+LIBS = [] if os.name == "nt" else ["-lm", "-pthread"]
+PARALLEL_KERNELS = {"parallel_for"}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("compiler", help="path to my_compiler")
+    parser.add_argument("--cc", default=os.environ.get("CC") or shutil.which("clang") or "cc")
+    parser.add_argument("--levels", default="0,1,2,3")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("--kernels", default="", help="comma separated, all when empty")
+    parser.add_argument("--thresholds", default=os.path.join(HERE, "thresholds.json"))
+    parser.add_argument("--baseline", default="", help="results of an earlier run to compare with")
+    parser.add_argument("--output", default="perf_results.json")
+    parser.add_argument("--work-dir", default="perf_work")
+    return parser.parse_args()
+
+
+def run(command):
+    # Compiler output is only shown when something goes wrong, my_compiler prints the whole AST
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(" ".join(command) + " failed:\n" + result.stdout[-4000:])
+
+
+def build_generated(args, kernel, level):
+    base = os.path.join(args.work_dir, "%s_O%d" % (kernel, level))
+    json_file = os.path.join(KERNEL_DIR, kernel + ".json")
+    start = time.perf_counter()
+    run([args.compiler, json_file, base + ".o", "-O%d" % level] + KERNEL_FLAGS.get(kernel, []))
+    compile_time = time.perf_counter() - start
+    run([args.cc, base + ".o", "-o", base + EXE_SUFFIX] + LIBS)
+    return base + EXE_SUFFIX, compile_time, os.path.getsize(base + ".o")
+
+
+def build_c(args, kernel, level):
+    # The generated code wraps on signed overflow and its math builtins never set errno, so
+    # must the C version
+    exe = os.path.join(args.work_dir, "%s_O%d_c%s" % (kernel, level, EXE_SUFFIX))
+    source = os.path.join(KERNEL_DIR, kernel + ".c")
+    flags = ["-O%d" % level, "-fwrapv", "-fno-math-errno"] + KERNEL_FLAGS.get(kernel, [])
+    run([args.cc] + flags + [source, RUNTIME_SOURCE, "-o", exe] + LIBS)
+    return exe
+
+
+def measure(args, exe, env=None):
+    output = None
+    times = []
+    env = dict(os.environ, **env) if env else None
+    for i in range(args.warmup + args.runs):
+        start = time.perf_counter()
+        result = subprocess.run(
+            [exe], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, env=env
+        )
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            raise RuntimeError("%s exited with %d" % (exe, result.returncode))
+        output = result.stdout
+        if i >= args.warmup:
+            times.append(elapsed)
+    return output, times
+
+
+def processors():
+    # The ones this process may run on, which can be fewer than the machine has
+    if hasattr(os, "sched_getaffinity"):
+        return len(os.sched_getaffinity(0))
+    return os.cpu_count() or 1
+
+
+def max_ratio(thresholds, kernel, level):
+    key = "O%d" % level
+    return thresholds.get("kernels", {}).get(kernel, {}).get(key, thresholds["ratio"][key])
+
+
+def main():
+    args = parse_args()
+    levels = [int(level) for level in args.levels.split(",")]
+    kernels = (
+        args.kernels.split(",")
+        if args.kernels
+        else sorted(
+            name[: -len(".json")] for name in os.listdir(KERNEL_DIR) if name.endswith(".json")
+        )
+    )
+    with open(args.thresholds) as f:
+        thresholds = json.load(f)
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)["kernels"]
+    os.makedirs(args.work_dir, exist_ok=True)
+    threads = processors()
+
+    results = {}
+    failures = []
+    for kernel in kernels:
+        results[kernel] = {}
+        for level in levels:
+            key = "O%d" % level
+            entry = {}
+            results[kernel][key] = entry
+            try:
+                exe, entry["compile_time"], entry["object_size"] = build_generated(
+                    args, kernel, level
+                )
+                output, times = measure(args, exe)
+                c_output, c_times = measure(args, build_c(args, kernel, level))
+                if kernel in PARALLEL_KERNELS:
+                    serial_output, serial_times = measure(args, exe, {"PARALLEL_THREADS": "1"})
+            except RuntimeError as e:
+                entry["status"] = "error"
+                entry["error"] = str(e)
+                failures.append("%s %s: %s" % (kernel, key, str(e).splitlines()[0]))
+                print("%-16s %s  error" % (kernel, key))
+                continue
+
+            entry["time"] = statistics.median(times)
+            entry["min_time"] = min(times)
+            entry["c_time"] = statistics.median(c_times)
+            entry["ratio"] = entry["time"] / entry["c_time"]
+            entry["max_ratio"] = max_ratio(thresholds, kernel, level)
+            entry["status"] = "ok"
+            if output != c_output:
+                entry["status"] = "mismatch"
+                entry["output"] = output
+                entry["c_output"] = c_output
+                failures.append("%s %s: output differs from C" % (kernel, key))
+            elif entry["ratio"] > entry["max_ratio"]:
+                entry["status"] = "slow"
+                failures.append(
+                    "%s %s: %.2fx the C time, at most %.2fx allowed"
+                    % (kernel, key, entry["ratio"], entry["max_ratio"])
+                )
+
+            # Against the same code on a single thread, only meaningful with several processors
+            if kernel in PARALLEL_KERNELS:
+                entry["threads"] = threads
+                entry["serial_time"] = statistics.median(serial_times)
+                entry["speedup"] = entry["serial_time"] / entry["time"]
+                min_speedup = thresholds["min_parallel_speedup"]
+                if serial_output != output:
+                    entry["status"] = "mismatch"
+                    entry["serial_output"] = serial_output
+                    failures.append("%s %s: output differs on one thread" % (kernel, key))
+                elif threads > 1 and entry["speedup"] < min_speedup:
+                    if entry["status"] == "ok":
+                        entry["status"] = "slow"
+                    failures.append(
+                        "%s %s: %.2fx faster than on one thread with %d, at least %.2fx expected"
+                        % (kernel, key, entry["speedup"], threads, min_speedup)
+                    )
+
+            # Against an earlier run on the same machine, catches slowdowns under the C ratio.
+            # The fastest run is compared, it is the least disturbed by other load
+            previous = baseline.get(kernel, {}).get(key, {}).get("min_time")
+            if previous:
+                entry["baseline_min_time"] = previous
+                slower = entry["min_time"] - previous
+                allowed = previous * thresholds["baseline_slowdown"]
+                if entry["min_time"] > allowed and slower > thresholds["min_delta"]:
+                    if entry["status"] == "ok":
+                        entry["status"] = "regressed"
+                    failures.append(
+                        "%s %s: %.3fs, was %.3fs in the baseline"
+                        % (kernel, key, entry["min_time"], previous)
+                    )
+
+            line = "%-16s %s  %8.3fs  C %8.3fs  %5.2fx  %s" % (
+                kernel,
+                key,
+                entry["time"],
+                entry["c_time"],
+                entry["ratio"],
+                entry["status"],
+            )
+            line += "  compile %.2fs  %d bytes" % (entry["compile_time"], entry["object_size"])
+            if "speedup" in entry:
+                line += "  speedup %.2fx on %d threads" % (entry["speedup"], threads)
+            print(line)
+
+    report = {
+        "platform": platform.platform(),
+        "cc": args.cc,
+        "runs": args.runs,
+        "warmup": args.warmup,
+        "kernels": results,
+        "failures": failures,
+    }
+    with open(args.output, "w") as out:
+        json.dump(report, out, indent=2)
+        out.write("\n")
+
+    for failure in failures:
+        print("FAIL " + failure)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,14 +1,643 @@
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#define sys_write _write
+#define sys_read _read
+#else
+#include <pthread.h>
+#include <unistd.h>
+#define sys_write write
+#define sys_read read
+#endif
+
+// Output goes through a per-thread buffer flushed with one write(2) when full, around parallel
+// for loops and at exit, so printing never takes the stdio lock or parses a format string.
+// Input is a single buffer on stdin, reading is meant for one thread.
+
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+#define INPUT_BUFFER_SIZE (1 << 16)
+#define MAX_LINE 4096
+
+typedef struct OutputBuffer {
+    char data[OUTPUT_BUFFER_SIZE];
+    size_t length;
+    struct OutputBuffer* next;  // All buffers ever created, walked at exit
+} OutputBuffer;
+
+// Heap allocated and never freed, a thread may exit before its buffer is flushed
+static _Thread_local OutputBuffer* thread_output;
+static _Atomic(OutputBuffer*) all_outputs;
+
+static void write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        long written = sys_write(fd, data, (unsigned)length);
+        if (written <= 0)
+            return;
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+static void flush_buffer(OutputBuffer* buffer) {
+    write_all(1, buffer->data, buffer->length);
+    buffer->length = 0;
+}
+
+// Oldest first, the list is newest first. One buffer per thread, so the depth is small
+static void flush_outputs_from(OutputBuffer* buffer) {
+    if (!buffer)
+        return;
+    flush_outputs_from(buffer->next);
+    flush_buffer(buffer);
+}
+
+static void flush_all_outputs(void) {
+    flush_outputs_from(atomic_load(&all_outputs));
+}
+
+// Flushes the calling thread's output, at exit every thread's output is flushed
+void flush_output(void) {
+    if (thread_output)
+        flush_buffer(thread_output);
+}
+
+static OutputBuffer* create_output(void) {
+    OutputBuffer* buffer = malloc(sizeof(OutputBuffer));
+    if (!buffer)
+        abort();
+    buffer->length = 0;
+
+    OutputBuffer* head = atomic_load(&all_outputs);
+    do {
+        buffer->next = head;
+    } while (!atomic_compare_exchange_weak(&all_outputs, &head, buffer));
+    if (!head)
+        atexit(flush_all_outputs);
+
+    thread_output = buffer;
+    return buffer;
+}
+
+// Room for at least size more bytes
+static OutputBuffer* reserve(size_t size) {
+    OutputBuffer* buffer = thread_output ? thread_output : create_output();
+    if (buffer->length + size > OUTPUT_BUFFER_SIZE)
+        flush_buffer(buffer);
+    return buffer;
+}
+
+static void append(const char* data, size_t length) {
+    OutputBuffer* buffer = thread_output ? thread_output : create_output();
+    if (length > OUTPUT_BUFFER_SIZE) {
+        flush_buffer(buffer);
+        write_all(1, data, length);
+        return;
+    }
+    if (buffer->length + length > OUTPUT_BUFFER_SIZE)
+        flush_buffer(buffer);
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+// Two digits per step
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes the digits of value ending at end, returns the first digit
+static char* format_unsigned(unsigned long long value, char* end) {
+    char* p = end;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return p;
+}
+
+static size_t format_int(long long x, char* out) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    unsigned long long magnitude = x < 0 ? 0ull - (unsigned long long)x : (unsigned long long)x;
+    char* begin = format_unsigned(magnitude, end);
+    if (x < 0)
+        *--begin = '-';
+    size_t length = (size_t)(end - begin);
+    memcpy(out, begin, length);
+    return length;
+}
+
+#define MAX_DOUBLE_LENGTH 400  // "%f" of DBL_MAX is 316 characters
+
+// Six decimals like %f, values too large for the fast path go through snprintf
+static size_t format_double(double x, char* out) {
+    if (x != x || x > 1e9 || x < -1e9)
+        return (size_t)snprintf(out, MAX_DOUBLE_LENGTH, "%f", x);
+
+    size_t length = 0;
+    if (x < 0 || (x == 0 && 1 / x < 0)) {
+        out[length++] = '-';
+        x = -x;
+    }
+
+    // Rounded to the sixth decimal, ties may differ from printf in the last digit
+    unsigned long long scaled = (unsigned long long)(x * 1e6 + 0.5);
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* begin = format_unsigned(scaled / 1000000, end);
+    memcpy(out + length, begin, (size_t)(end - begin));
+    length += (size_t)(end - begin);
+
+    out[length++] = '.';
+    begin = format_unsigned(scaled % 1000000, end);
+    size_t fraction = (size_t)(end - begin);
+    memset(out + length, '0', 6 - fraction);
+    memcpy(out + length + 6 - fraction, begin, fraction);
+    return length + 6;
+}
 
 void print_int(int x) {
-    printf("%d\n", x);
+    OutputBuffer* buffer = reserve(24);
+    buffer->length += format_int(x, buffer->data + buffer->length);
+    buffer->data[buffer->length++] = '\n';
 }
 
 void print_number(int x) {
-    printf("%d\n", x);
+    print_int(x);
+}
+
+void print_double(double x) {
+    OutputBuffer* buffer = reserve(MAX_DOUBLE_LENGTH + 1);
+    buffer->length += format_double(x, buffer->data + buffer->length);
+    buffer->data[buffer->length++] = '\n';
 }
 
 void print_string(char* s) {
-    printf("%s\n", s);
+    append(s, strlen(s));
+    append("\n", 1);
+}
+
+static char input[INPUT_BUFFER_SIZE];
+static size_t input_pos, input_end;
+static char line[MAX_LINE];
+
+// Next input byte, -1 at end of input
+static int peek_char(void) {
+    if (input_pos == input_end) {
+        // Prompts written so far should be visible before blocking on input
+        flush_output();
+        long count = sys_read(0, input, INPUT_BUFFER_SIZE);
+        if (count <= 0)
+            return -1;
+        input_pos = 0;
+        input_end = (size_t)count;
+    }
+    return (unsigned char)input[input_pos];
+}
+
+// Skips leading whitespace, 0 when there is no number
+int read_int(void) {
+    int c = peek_char();
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        input_pos++;
+        c = peek_char();
+    }
+
+    int negative = c == '-';
+    if (c == '-' || c == '+') {
+        input_pos++;
+        c = peek_char();
+    }
+    unsigned value = 0;
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (unsigned)(c - '0');
+        input_pos++;
+        c = peek_char();
+    }
+    return negative ? (int)(0u - value) : (int)value;
+}
+
+// Line without its newline, valid until the next call. Longer lines are truncated to
+// MAX_LINE - 1 characters, the rest is skipped. Empty string at end of input
+char* read_line(void) {
+    size_t length = 0;
+    int c = peek_char();
+    while (c != -1 && c != '\n') {
+        if (length < MAX_LINE - 1)
+            line[length++] = (char)c;
+        input_pos++;
+        c = peek_char();
+    }
+    if (c == '\n')
+        input_pos++;
+    if (length > 0 && line[length - 1] == '\r')
+        length--;
+    line[length] = '\0';
+    return line;
+}
+
+// Allocators for programs building linked structures out of many small nodes. The arena hands
+// out memory by bumping a pointer and frees all of it at once, pools keep freed nodes in a list
+// per size class. Both are per thread and return memory aligned like malloc. CodeGen calls the
+// __ entry points with the size already rounded when it is a constant and inlines their fast
+// paths, keep ALLOC_ALIGN and MAX_POOL_SIZE in sync with CodeGen::emitAllocationCall
+
+#define ALLOC_ALIGN 16
+#define MAX_POOL_SIZE 256  // Larger pool allocations go to malloc
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define POOL_CHUNK_SIZE (1 << 16)
+
+typedef struct ArenaBlock {
+    _Alignas(ALLOC_ALIGN) struct ArenaBlock* previous;
+    size_t size;  // Usable bytes after the header
+} ArenaBlock;
+
+typedef struct FreeNode {
+    struct FreeNode* next;
+} FreeNode;
+
+static _Thread_local char* arena_next;
+static _Thread_local char* arena_end;
+static _Thread_local ArenaBlock* arena_block;  // The one being bumped, earlier ones before it
+static _Thread_local size_t arena_capacity = ARENA_BLOCK_SIZE;
+static _Thread_local FreeNode* free_lists[MAX_POOL_SIZE / ALLOC_ALIGN];
+
+static size_t round_size(int size) {
+    size_t bytes = size > 0 ? (size_t)size : 1;
+    return (bytes + ALLOC_ALIGN - 1) & ~(size_t)(ALLOC_ALIGN - 1);
+}
+
+static void free_arena_blocks(ArenaBlock* block) {
+    while (block) {
+        ArenaBlock* previous = block->previous;
+        free(block);
+        block = previous;
+    }
+}
+
+static void use_arena_block(ArenaBlock* block) {
+    arena_block = block;
+    arena_next = (char*)(block + 1);
+    arena_end = arena_next + block->size;
+}
+
+// Called when the current block is full, the rest of it is left unused
+static __attribute__((noinline)) void* arena_grow(size_t size) {
+    size_t usable = size > arena_capacity ? size : arena_capacity;
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + usable);
+    if (!block)
+        abort();
+    block->previous = arena_block;
+    block->size = usable;
+    use_arena_block(block);
+    arena_next += size;
+    return (char*)(block + 1);
+}
+
+// size is a multiple of ALLOC_ALIGN
+void* __arena_alloc_rounded(long long size) {
+    char* p = arena_next;
+    if ((size_t)(arena_end - p) < (size_t)size)
+        return arena_grow((size_t)size);
+    arena_next = p + size;
+    return p;
+}
+
+// Frees the calling thread's arena and starts a new one, blocks get capacity bytes
+void arena_create(int capacity) {
+    free_arena_blocks(arena_block);
+    arena_block = NULL;
+    arena_next = arena_end = NULL;
+    arena_capacity = capacity > 0 ? round_size(capacity) : ARENA_BLOCK_SIZE;
+}
+
+void* arena_alloc(int size) {
+    return __arena_alloc_rounded((long long)round_size(size));
+}
+
+// Everything allocated from the calling thread's arena is freed, its last block is kept
+void arena_reset(void) {
+    if (!arena_block)
+        return;
+    free_arena_blocks(arena_block->previous);
+    arena_block->previous = NULL;
+    use_arena_block(arena_block);
+}
+
+// A chunk of nodes of the class, all but the first go to its free list
+static __attribute__((noinline)) void* pool_refill(int size_class) {
+    size_t size = (size_t)(size_class + 1) * ALLOC_ALIGN;
+    size_t count = POOL_CHUNK_SIZE / size;
+    char* chunk = malloc(count * size);
+    if (!chunk)
+        abort();
+    for (size_t i = 1; i + 1 < count; i++)
+        ((FreeNode*)(chunk + i * size))->next = (FreeNode*)(chunk + (i + 1) * size);
+    ((FreeNode*)(chunk + (count - 1) * size))->next = NULL;
+    free_lists[size_class] = (FreeNode*)(chunk + size);
+    return chunk;
+}
+
+// Class c holds nodes of (c + 1) * ALLOC_ALIGN bytes
+void* __pool_alloc_class(int size_class) {
+    FreeNode* node = free_lists[size_class];
+    if (!node)
+        return pool_refill(size_class);
+    free_lists[size_class] = node->next;
+    return node;
+}
+
+// Compiled calls with a constant size come here directly, so it takes NULL like free
+void __pool_free_class(void* p, int size_class) {
+    if (!p)
+        return;
+    FreeNode* node = p;
+    node->next = free_lists[size_class];
+    free_lists[size_class] = node;
+}
+
+void* pool_alloc(int size) {
+    size_t rounded = round_size(size);
+    if (rounded > MAX_POOL_SIZE)
+        return malloc(rounded);
+    return __pool_alloc_class((int)(rounded / ALLOC_ALIGN) - 1);
+}
+
+// size must be the one p was allocated with. Nodes freed by another thread join its lists
+void pool_free(void* p, int size) {
+    size_t rounded = round_size(size);
+    if (rounded > MAX_POOL_SIZE)
+        free(p);
+    else
+        __pool_free_class(p, (int)(rounded / ALLOC_ALIGN) - 1);
+}
+
+// parallel for loops call __parallel_for with their body outlined into a function running
+// iterations [begin, end). The iteration space is split evenly across a pool of threads,
+// started on first use and sized by PARALLEL_THREADS or the number of processors. The calling
+// thread is worker 0. Each thread runs pieces of its own slice from the front, under the
+// dynamic and guided schedules a thread that runs out steals the back half of another's.
+// A loop started while another is running, nested or from a second thread, runs serially
+
+#define MAX_THREADS 256
+#define SPIN_COUNT 4096  // Before sleeping on a condition variable
+
+enum { SCHEDULE_STATIC, SCHEDULE_DYNAMIC, SCHEDULE_GUIDED };
+
+typedef void (*LoopBody)(void* captures, long long begin, long long end);
+
+// Iterations a thread has left, own cache line so owners don't contend
+typedef struct {
+    _Alignas(64) atomic_flag lock;
+    long long begin, end;
+} Slice;
+
+#ifdef _WIN32
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Condition;
+#define MUTEX_INIT SRWLOCK_INIT
+#define CONDITION_INIT CONDITION_VARIABLE_INIT
+#define mutex_lock AcquireSRWLockExclusive
+#define mutex_unlock ReleaseSRWLockExclusive
+#define condition_wait(condition, mutex) SleepConditionVariableSRW(condition, mutex, INFINITE, 0)
+#define condition_broadcast WakeAllConditionVariable
+#else
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+#define MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define CONDITION_INIT PTHREAD_COND_INITIALIZER
+#define mutex_lock pthread_mutex_lock
+#define mutex_unlock pthread_mutex_unlock
+#define condition_wait pthread_cond_wait
+#define condition_broadcast pthread_cond_broadcast
+#endif
+
+static Slice slices[MAX_THREADS];
+static int pool_threads;  // 0 until the pool is started
+static atomic_flag pool_busy = ATOMIC_FLAG_INIT;
+
+// Workers sleep until generation changes, the last one to finish wakes the caller
+static Mutex pool_mutex = MUTEX_INIT;
+static Condition pool_wake = CONDITION_INIT;
+static Condition pool_done = CONDITION_INIT;
+static atomic_uint pool_generation;
+static atomic_int pool_running;
+
+// The loop being run, written before generation is bumped
+static LoopBody job_body;
+static void* job_captures;
+static int job_schedule;
+static long long job_chunk;
+
+static void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void lock_slice(Slice* slice) {
+    while (atomic_flag_test_and_set_explicit(&slice->lock, memory_order_acquire))
+        cpu_relax();
+}
+
+static void unlock_slice(Slice* slice) {
+    atomic_flag_clear_explicit(&slice->lock, memory_order_release);
+}
+
+// Next piece of the thread's own slice, 0 when it is empty
+static int take_piece(Slice* slice, long long* begin, long long* end) {
+    lock_slice(slice);
+    long long remaining = slice->end - slice->begin;
+    long long size = job_chunk;
+    if (job_schedule == SCHEDULE_STATIC && job_chunk == 0)
+        size = remaining;
+    else if (job_schedule == SCHEDULE_GUIDED && remaining / 2 > size)
+        size = remaining / 2;
+    if (size > remaining)
+        size = remaining;
+    *begin = slice->begin;
+    *end = slice->begin + size;
+    slice->begin += size;
+    unlock_slice(slice);
+    return size > 0;
+}
+
+// Moves the back half of the first non-empty slice after self into self's, which is empty.
+// Only one lock is held at a time
+static int steal(int self) {
+    for (int i = 1; i < pool_threads; i++) {
+        Slice* victim = &slices[(self + i) % pool_threads];
+        lock_slice(victim);
+        long long remaining = victim->end - victim->begin;
+        long long stolen = (remaining + 1) / 2;
+        long long end = victim->end;
+        victim->end -= stolen;
+        unlock_slice(victim);
+        if (stolen > 0) {
+            Slice* own = &slices[self];
+            lock_slice(own);
+            own->begin = end - stolen;
+            own->end = end;
+            unlock_slice(own);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Until every slice is empty, a stolen range is run by the thief before it looks again
+static void run_slices(int self) {
+    long long begin, end;
+    do {
+        while (take_piece(&slices[self], &begin, &end))
+            job_body(job_captures, begin, end);
+    } while (job_schedule != SCHEDULE_STATIC && steal(self));
+}
+
+static unsigned wait_for_job(unsigned seen) {
+    for (int i = 0; i < SPIN_COUNT; i++) {
+        unsigned generation = atomic_load_explicit(&pool_generation, memory_order_acquire);
+        if (generation != seen)
+            return generation;
+        cpu_relax();
+    }
+    mutex_lock(&pool_mutex);
+    while (atomic_load(&pool_generation) == seen)
+        condition_wait(&pool_wake, &pool_mutex);
+    mutex_unlock(&pool_mutex);
+    return atomic_load(&pool_generation);
 }
 
+static void worker_main(int self) {
+    unsigned seen = 0;
+    for (;;) {
+        seen = wait_for_job(seen);
+        run_slices(self);
+        // Printed by the body, out before the caller goes on past the loop
+        flush_output();
+        if (atomic_fetch_sub(&pool_running, 1) == 1) {
+            mutex_lock(&pool_mutex);
+            condition_broadcast(&pool_done);
+            mutex_unlock(&pool_mutex);
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_thread(LPVOID self) {
+    worker_main((int)(intptr_t)self);
+    return 0;
+}
+#else
+static void* worker_thread(void* self) {
+    worker_main((int)(intptr_t)self);
+    return NULL;
+}
+#endif
+
+static int processor_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+// Threads that fail to start are left out of the pool
+static void start_pool(void) {
+    const char* requested = getenv("PARALLEL_THREADS");
+    int threads = requested ? atoi(requested) : processor_count();
+    if (threads < 1)
+        threads = 1;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    pool_threads = 1;
+    for (int i = 1; i < threads; i++) {
+#ifdef _WIN32
+        HANDLE thread = CreateThread(NULL, 0, worker_thread, (LPVOID)(intptr_t)i, 0, NULL);
+        if (!thread)
+            break;
+        CloseHandle(thread);
+#else
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_thread, (void*)(intptr_t)i) != 0)
+            break;
+        pthread_detach(thread);
+#endif
+        pool_threads++;
+    }
+}
+
+void __parallel_for(
+    LoopBody body,
+    void* captures,
+    long long begin,
+    long long end,
+    int schedule,
+    long long chunk
+) {
+    if (begin >= end)
+        return;
+    if (atomic_flag_test_and_set(&pool_busy)) {
+        body(captures, begin, end);
+        return;
+    }
+    if (pool_threads == 0)
+        start_pool();
+    long long count = end - begin;
+    int threads = pool_threads;
+    if (threads == 1 || count == 1) {
+        body(captures, begin, end);
+        atomic_flag_clear(&pool_busy);
+        return;
+    }
+
+    // Enough pieces per thread to balance uneven iterations, few enough to keep them cheap
+    if (schedule == SCHEDULE_DYNAMIC && chunk == 0)
+        chunk = count / (64LL * threads);
+    if (schedule != SCHEDULE_STATIC && chunk < 1)
+        chunk = 1;
+    job_body = body;
+    job_captures = captures;
+    job_schedule = schedule;
+    job_chunk = chunk;
+    for (int i = 0; i < threads; i++) {
+        slices[i].begin = begin + count * i / threads;
+        slices[i].end = begin + count * (i + 1) / threads;
+    }
+
+    // What the caller printed before the loop goes out before anything the workers print
+    flush_output();
+    atomic_store(&pool_running, threads - 1);
+    mutex_lock(&pool_mutex);
+    atomic_fetch_add_explicit(&pool_generation, 1, memory_order_release);
+    condition_broadcast(&pool_wake);
+    mutex_unlock(&pool_mutex);
+
+    run_slices(0);
+    for (int i = 0; i < SPIN_COUNT && atomic_load(&pool_running) != 0; i++)
+        cpu_relax();
+    mutex_lock(&pool_mutex);
+    while (atomic_load(&pool_running) != 0)
+        condition_wait(&pool_done, &pool_mutex);
+    mutex_unlock(&pool_mutex);
+    atomic_flag_clear(&pool_busy);
+}
@@ -0,0 +1,14 @@
+#include <stdio.h>
+
+void print_int(int x) {
+    printf("%d\n", x);
+}
+
+void print_number(int x) {
+    printf("%d\n", x);
+}
+
+void print_string(char* s) {
+    printf("%s\n", s);
+}
+